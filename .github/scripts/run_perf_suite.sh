@@ -0,0 +1,107 @@
+#!/bin/bash
+# .github/scripts/run_perf_suite.sh
+# Build the host benchmarks and collect one per-commit performance record
+
+set -e
+
+BUILD_DIR=${PERF_BUILD_DIR:-host/build}
+RECORD=${PERF_RECORD:-perf_record.json}
+# Timed benchmarks run this many times, the best run is kept
+RUNS=${PERF_RUNS:-3}
+
+echo "=== Running host performance suite ==="
+
+cmake -S host -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release
+cmake --build "$BUILD_DIR" -j"$(nproc)" --target \
+	render_bench swap_bench touch_bench proto_bench timer_bench \
+	time_bench dlog_check
+
+# Not a benchmark: fails the suite when the deferred log macros break
+"$BUILD_DIR/dlog_check" > /dev/null
+
+TMP_DIR=$(mktemp -d)
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# run NAME CMD...: append the benchmark's JSON line to $TMP_DIR/NAME.json
+run() {
+	local name=$1
+	shift
+	for _ in $(seq "$RUNS"); do
+		"$@" >> "$TMP_DIR/$name.json"
+	done
+	echo "	- $name: $(tail -n 1 "$TMP_DIR/$name.json")"
+}
+
+run clock "$BUILD_DIR/render_bench" --ui clock --seconds 10
+run demo "$BUILD_DIR/render_bench" --ui demo --seconds 10
+run screens "$BUILD_DIR/render_bench" --ui screens --seconds 10
+run notifs "$BUILD_DIR/render_bench" --ui notifs --seconds 10
+run swap "$BUILD_DIR/swap_bench"
+run touch "$BUILD_DIR/touch_bench"
+run proto "$BUILD_DIR/proto_bench"
+run timer "$BUILD_DIR/timer_bench"
+run time "$BUILD_DIR/time_bench"
+
+# best NAME JQ_EXPR: smallest value of the expression over the runs
+best() {
+	jq -s "map($2) | min" "$TMP_DIR/$1.json"
+}
+
+TIMESTAMP=$(date -u '+%Y-%m-%d %H:%M:%S UTC')
+COMMIT_HASH=${GIT_COMMIT:-$(git rev-parse --short HEAD)}
+
+# Metrics ending in _per_s are better higher, all others better lower
+jq -n -c \
+	--arg timestamp "$TIMESTAMP" \
+	--arg commit "$COMMIT_HASH" \
+	--argjson full_frame_render_us \
+		"$(best swap '.full_frame[] | select(.mode == "swap_words") | .frame_us')" \
+	--argjson partial_render_us "$(best clock '.render_us_per_frame')" \
+	--argjson demo_render_us "$(best demo '.render_us_per_frame')" \
+	--argjson notif_scroll_render_us "$(best notifs '.render_us_per_frame')" \
+	--argjson flush_bytes_per_frame \
+		"$(best clock '.bytes_pushed / .frames | floor')" \
+	--argjson demo_flush_bytes_per_frame \
+		"$(best demo '.bytes_pushed / .frames | floor')" \
+	--argjson touch_filter_ns "$(best touch '.filter_ns_per_sample')" \
+	--argjson touch_cal_ns "$(best touch '.cal.ns_per_sample')" \
+	--argjson codec_encode_ns "$(best proto '.encode_ns_per_frame')" \
+	--argjson codec_parse_ns "$(best proto '.parse_ns_per_frame')" \
+	--argjson timer_fire_ns "$(best timer '.fire_ns')" \
+	--argjson local_time_ns "$(best time '.clock_ns')" \
+	--argjson lvgl_heap_peak_clock "$(best clock '.peak_lvgl_heap')" \
+	--argjson lvgl_heap_peak_demo "$(best demo '.peak_lvgl_heap')" \
+	--argjson lvgl_heap_peak_screens "$(best screens '.peak_lvgl_heap')" \
+	--argjson lvgl_heap_peak_notifs "$(best notifs '.peak_lvgl_heap')" \
+	--argjson lvgl_frag_pct_screens "$(best screens '.lvgl_mem.frag_pct')" \
+	--argjson tile_miss_pct_clock "$(best clock '100 - .tile_hit_pct')" \
+	'{
+		timestamp: $timestamp,
+		commit: $commit,
+		metrics: {
+			full_frame_render_us: $full_frame_render_us,
+			partial_render_us: $partial_render_us,
+			demo_render_us: $demo_render_us,
+			notif_scroll_render_us: $notif_scroll_render_us,
+			flush_bytes_per_frame: $flush_bytes_per_frame,
+			demo_flush_bytes_per_frame: $demo_flush_bytes_per_frame,
+			touch_filter_samples_per_s: (1e9 / $touch_filter_ns | floor),
+			touch_cal_samples_per_s: (1e9 / $touch_cal_ns | floor),
+			codec_encode_frames_per_s: (1e9 / $codec_encode_ns | floor),
+			codec_parse_frames_per_s: (1e9 / $codec_parse_ns | floor),
+			timer_fires_per_s: (1e9 / $timer_fire_ns | floor),
+			local_time_conversions_per_s: (1e9 / $local_time_ns | floor),
+			lvgl_heap_peak_clock: $lvgl_heap_peak_clock,
+			lvgl_heap_peak_demo: $lvgl_heap_peak_demo,
+			lvgl_heap_peak_screens: $lvgl_heap_peak_screens,
+			lvgl_heap_peak_notifs: $lvgl_heap_peak_notifs,
+			lvgl_frag_pct_screens: $lvgl_frag_pct_screens,
+			tile_miss_pct_clock: $tile_miss_pct_clock
+		}
+	}' > "$RECORD"
+
+echo "📋 Performance record:"
+cat "$RECORD"
+
+echo "PERF_RECORD=$RECORD" >> "${GITHUB_ENV:-/dev/null}"
+echo "✅ Performance suite completed"
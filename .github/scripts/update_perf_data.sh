@@ -0,0 +1,112 @@
+#!/bin/bash
+# .github/scripts/update_perf_data.sh
+# Compare the performance record with the last one in main and append it to
+# perf_data.jsonl in the build_data branch, next to the size history
+
+set -e
+
+RECORD=${PERF_RECORD:-perf_record.json}
+# Change against the previous record that counts as a regression
+THRESHOLD_PCT=${PERF_REGRESSION_PCT:-10}
+# Pull requests compare only, pushes to main also record
+PUSH=${PERF_PUSH:-true}
+
+echo "📊 Updating performance data"
+
+if [ ! -f "$RECORD" ]; then
+	echo "❌ $RECORD not found, run run_perf_suite.sh first"
+	exit 1
+fi
+COMMIT_HASH=$(jq -r '.commit' "$RECORD")
+ORIGINAL_BRANCH=$(git branch --show-current)
+
+cleanup() {
+	echo "🧹 Cleaning up temporary files..."
+	rm -f perf_data_temp.jsonl perf_data_filtered.jsonl
+}
+trap cleanup EXIT
+
+HAVE_BRANCH=false
+if git ls-remote --heads origin build_data | grep -q build_data; then
+	HAVE_BRANCH=true
+	git fetch origin build_data
+fi
+
+# Keep only records of commits in this branch, like build_data.csv
+: > perf_data_temp.jsonl
+if [ "$HAVE_BRANCH" = true ] && \
+   git show origin/build_data:perf_data.jsonl > perf_data_filtered.jsonl 2>/dev/null; then
+	while IFS= read -r entry; do
+		commit=$(jq -r '.commit' <<< "$entry")
+		if git merge-base --is-ancestor "$commit" HEAD 2>/dev/null; then
+			echo "$entry" >> perf_data_temp.jsonl
+		else
+			echo "🗑️ Removing entry for commit not in $ORIGINAL_BRANCH: $commit"
+		fi
+	done < perf_data_filtered.jsonl
+fi
+
+# Per-metric comparison with the latest record in this branch
+REGRESSIONS=0
+if [ -s perf_data_temp.jsonl ]; then
+	PREVIOUS=$(tail -n 1 perf_data_temp.jsonl)
+	echo "✅ Comparing with $(jq -r '.commit' <<< "$PREVIOUS")"
+	TABLE=$(jq -r -n \
+		--argjson prev "$PREVIOUS" \
+		--slurpfile cur "$RECORD" \
+		--argjson threshold "$THRESHOLD_PCT" '
+		$cur[0].metrics | to_entries[] |
+		.key as $k | .value as $v | ($prev.metrics[$k] // null) as $p |
+		(if $p == null or $p == 0 then null
+		 else ($v - $p) / $p * 100 end) as $pct |
+		# _per_s metrics regress when they drop, the rest when they grow
+		(if $pct == null then false
+		 elif ($k | endswith("_per_s")) then $pct < -$threshold
+		 else $pct > $threshold end) as $bad |
+		"| \($k) | \($p // "-") | \($v) | " +
+		(if $pct == null then "-" else "\($pct * 10 | round / 10)%" end) +
+		(if $bad then " ⚠️ |" else " |" end)')
+	REGRESSIONS=$(grep -c "⚠️" <<< "$TABLE" || true)
+	echo "$TABLE"
+	if [ -n "$GITHUB_STEP_SUMMARY" ]; then
+		{
+			echo "## ⏱️ Host Performance"
+			echo "| Metric | Previous | Current | Change |"
+			echo "|--------|----------|---------|--------|"
+			echo "$TABLE"
+		} >> "$GITHUB_STEP_SUMMARY"
+	fi
+	if [ "$REGRESSIONS" -gt 0 ]; then
+		echo "::warning::$REGRESSIONS metric(s) regressed by more than $THRESHOLD_PCT%"
+	fi
+else
+	echo "⚠️ No earlier performance records in $ORIGINAL_BRANCH"
+fi
+
+if [ "$PUSH" != true ]; then
+	echo "⏭️ Not recording, PERF_PUSH=$PUSH"
+	exit 0
+fi
+if [ "$HAVE_BRANCH" != true ]; then
+	echo "⚠️ build_data branch missing, update_build_data.sh creates it"
+	exit 0
+fi
+
+echo "📝 Appending performance record..."
+jq -c . "$RECORD" >> perf_data_temp.jsonl
+
+# Commit to build_data through a temporary index, without a checkout
+BUILD_DATA_COMMIT=$(git rev-parse origin/build_data)
+BLOB_HASH=$(git hash-object -w perf_data_temp.jsonl)
+CURRENT_TREE=$(git rev-parse origin/build_data^{tree})
+NEW_TREE=$(git read-tree --index-output=/tmp/git-perf-index $CURRENT_TREE && \
+		   GIT_INDEX_FILE=/tmp/git-perf-index git update-index --add --cacheinfo 100644 $BLOB_HASH perf_data.jsonl && \
+		   GIT_INDEX_FILE=/tmp/git-perf-index git write-tree)
+NEW_COMMIT=$(git commit-tree $NEW_TREE -p $BUILD_DATA_COMMIT -m "Update perf data for commit $COMMIT_HASH")
+git update-ref refs/heads/build_data $NEW_COMMIT
+rm -f /tmp/git-perf-index
+echo "✅ Committed perf data changes (commit: ${NEW_COMMIT:0:8})"
+
+echo "📤 Pushing updated perf data..."
+git push origin build_data
+echo "📊 Done. Perf data processed for commit: $COMMIT_HASH"
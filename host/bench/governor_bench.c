@@ -0,0 +1,289 @@
+/*
+ * Replays simulated input traces through the power governor at 1 ms steps,
+ * with the display refresh timer following its period the way the LVGL task
+ * sets it. Reports time per state, refreshes against a fixed 60 Hz panel,
+ * input-to-refresh latency and backlight time. Prints one JSON object.
+ *
+ * Trace files have one event per line, '#' starts a comment:
+ *   <start ms> touch <duration ms>   finger down, sampled every 10 ms
+ *   <start ms> anim <duration ms>    LVGL animation running
+ *   <start ms> end                   end of the trace
+ *
+ * usage: governor_bench [--scenario NAME | --trace FILE] [--dim-after-ms N]
+ */
+#include "config.h"
+#include "power_governor.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_EVENTS 256
+#define FIXED_60HZ_PERIOD_MS 16
+
+typedef enum {
+  EV_TOUCH,
+  EV_ANIM,
+  EV_END,
+} trace_kind_t;
+
+typedef struct {
+  uint32_t start_ms;
+  trace_kind_t kind;
+  uint32_t duration_ms;
+} trace_ev_t;
+
+typedef struct {
+  const char *name;
+  const trace_ev_t *events;
+  size_t count;
+} scenario_t;
+
+static const trace_ev_t idle_trace[] = {
+    {60000, EV_END, 0},
+};
+
+// A tap every 5 s for half a minute, then nothing
+static const trace_ev_t tap_trace[] = {
+    {0, EV_TOUCH, 80},     {5000, EV_TOUCH, 80},  {10000, EV_TOUCH, 80},
+    {15000, EV_TOUCH, 80}, {20000, EV_TOUCH, 80}, {25000, EV_TOUCH, 80},
+    {60000, EV_END, 0},
+};
+
+// Drags followed by scroll throw animations
+static const trace_ev_t scroll_trace[] = {
+    {1000, EV_TOUCH, 400}, {1400, EV_ANIM, 600},  {3000, EV_TOUCH, 400},
+    {3400, EV_ANIM, 600},  {5000, EV_TOUCH, 400}, {5400, EV_ANIM, 1500},
+    {60000, EV_END, 0},
+};
+
+// Tap, scroll, long idle that dims, wake by touch, then a notification
+// animation on an untouched watch
+static const trace_ev_t mixed_trace[] = {
+    {2000, EV_TOUCH, 100}, {5000, EV_TOUCH, 400}, {5400, EV_ANIM, 800},
+    {40000, EV_TOUCH, 120}, {50000, EV_ANIM, 1000}, {60000, EV_END, 0},
+};
+
+#define SCENARIO(n, t) {n, t, sizeof(t) / sizeof(t[0])}
+static const scenario_t scenarios[] = {
+    SCENARIO("idle", idle_trace),
+    SCENARIO("tap", tap_trace),
+    SCENARIO("scroll", scroll_trace),
+    SCENARIO("mixed", mixed_trace),
+};
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static trace_ev_t s_file_events[MAX_EVENTS];
+
+static bool load_trace(const char *path, scenario_t *out) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  char line[128];
+  size_t count = 0;
+  while (fgets(line, sizeof(line), f) && count < MAX_EVENTS) {
+    char *hash = strchr(line, '#');
+    if (hash) {
+      *hash = '\0';
+    }
+    unsigned start;
+    char kind[16];
+    unsigned duration = 0;
+    int n = sscanf(line, "%u %15s %u", &start, kind, &duration);
+    if (n <= 0) {
+      continue;
+    }
+    trace_ev_t *ev = &s_file_events[count];
+    ev->start_ms = start;
+    ev->duration_ms = duration;
+    if (n == 3 && !strcmp(kind, "touch")) {
+      ev->kind = EV_TOUCH;
+    } else if (n == 3 && !strcmp(kind, "anim")) {
+      ev->kind = EV_ANIM;
+    } else if (n >= 2 && !strcmp(kind, "end")) {
+      ev->kind = EV_END;
+    } else {
+      fprintf(stderr, "%s: bad line: %s", path, line);
+      fclose(f);
+      return false;
+    }
+    count++;
+  }
+  fclose(f);
+  out->name = path;
+  out->events = s_file_events;
+  out->count = count;
+  return count > 0;
+}
+
+typedef struct {
+  uint32_t duration_ms;
+  uint32_t time_in_state_ms[POWER_GOVERNOR_STATE_COUNT];
+  uint32_t transitions;
+  uint32_t refreshes;
+  uint32_t refreshes_60hz;
+  uint32_t input_samples;
+  uint32_t input_latency_max_ms; // sample to the refresh that shows it
+  uint32_t missed_interactive;   // samples handled outside INTERACTIVE
+  uint64_t backlight_pct_ms;
+} sim_result_t;
+
+static void simulate(const scenario_t *sc, const power_governor_config_t *cfg,
+                     sim_result_t *res) {
+  memset(res, 0, sizeof(*res));
+  uint32_t end_ms = 0;
+  for (size_t i = 0; i < sc->count; i++) {
+    uint32_t ev_end = sc->events[i].start_ms + sc->events[i].duration_ms;
+    end_ms = ev_end > end_ms ? ev_end : end_ms;
+  }
+
+  power_governor_t gov;
+  power_governor_init(&gov, cfg, 0);
+  uint32_t last_input_ms = 0;
+  uint32_t last_refresh_ms = 0;
+  uint32_t pending_sample_ms = UINT32_MAX; // oldest input not yet shown
+
+  for (uint32_t now = 0; now < end_ms; now++) {
+    bool input = false;
+    bool animating = false;
+    for (size_t i = 0; i < sc->count; i++) {
+      const trace_ev_t *ev = &sc->events[i];
+      if (now < ev->start_ms || now >= ev->start_ms + ev->duration_ms) {
+        continue;
+      }
+      if (ev->kind == EV_TOUCH &&
+          (now - ev->start_ms) % TOUCH_SAMPLE_PERIOD_MS == 0) {
+        input = true;
+      } else if (ev->kind == EV_ANIM) {
+        animating = true;
+      }
+    }
+    if (input) {
+      last_input_ms = now;
+      res->input_samples++;
+      if (pending_sample_ms == UINT32_MAX) {
+        pending_sample_ms = now;
+      }
+    }
+
+    power_governor_update(&gov, now, now - last_input_ms, animating);
+    if (input && gov.state != POWER_GOVERNOR_INTERACTIVE) {
+      res->missed_interactive++;
+    }
+
+    // lv_timer_set_period keeps the last run, so a shorter period can make
+    // the refresh due right away
+    if (now - last_refresh_ms >= power_governor_period_ms(&gov)) {
+      last_refresh_ms = now;
+      res->refreshes++;
+      if (pending_sample_ms != UINT32_MAX) {
+        uint32_t latency = now - pending_sample_ms;
+        if (latency > res->input_latency_max_ms) {
+          res->input_latency_max_ms = latency;
+        }
+        pending_sample_ms = UINT32_MAX;
+      }
+    }
+    res->backlight_pct_ms += power_governor_backlight(&gov);
+  }
+
+  gov.time_in_state_ms[gov.state] += end_ms - gov.entered_ms;
+  memcpy(res->time_in_state_ms, gov.time_in_state_ms,
+         sizeof(res->time_in_state_ms));
+  res->transitions = gov.transitions;
+  res->duration_ms = end_ms;
+  res->refreshes_60hz = end_ms / FIXED_60HZ_PERIOD_MS;
+}
+
+static void print_result(const char *name, const sim_result_t *res) {
+  printf("{\"scenario\":\"%s\",\"duration_ms\":%u,\"time_in_state_ms\":{",
+         name, res->duration_ms);
+  for (int s = 0; s < POWER_GOVERNOR_STATE_COUNT; s++) {
+    printf("%s\"%s\":%u", s ? "," : "", power_governor_state_names[s],
+           res->time_in_state_ms[s]);
+  }
+  double duration = res->duration_ms ? res->duration_ms : 1;
+  printf("},\"transitions\":%u,\"refreshes\":%u,\"refreshes_fixed_60hz\":%u,"
+         "\"refresh_saving\":%.3f,\"input_samples\":%u,"
+         "\"input_latency_max_ms\":%u,\"missed_interactive\":%u,"
+         "\"backlight_avg_pct\":%.1f}",
+         res->transitions, res->refreshes, res->refreshes_60hz,
+         res->refreshes_60hz
+             ? 1.0 - (double)res->refreshes / res->refreshes_60hz
+             : 0.0,
+         res->input_samples, res->input_latency_max_ms,
+         res->missed_interactive, res->backlight_pct_ms / duration);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [--scenario idle|tap|scroll|mixed | --trace FILE] "
+          "[--dim-after-ms N]\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  power_governor_config_t cfg = {
+      .interactive_period_ms = GOVERNOR_INTERACTIVE_PERIOD_MS,
+      .animating_period_ms = GOVERNOR_ANIMATING_PERIOD_MS,
+      .idle_period_ms = GOVERNOR_IDLE_PERIOD_MS,
+      .interactive_hold_ms = GOVERNOR_INTERACTIVE_HOLD_MS,
+      .dim_after_ms = GOVERNOR_DIM_AFTER_MS,
+      .backlight_full = GOVERNOR_BACKLIGHT_FULL,
+      .backlight_dim = GOVERNOR_BACKLIGHT_DIM,
+  };
+  const char *only = NULL;
+  scenario_t file_scenario;
+  bool from_file = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--scenario") && i + 1 < argc) {
+      only = argv[++i];
+    } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+      if (!load_trace(argv[++i], &file_scenario)) {
+        return 1;
+      }
+      from_file = true;
+    } else if (!strcmp(argv[i], "--dim-after-ms") && i + 1 < argc) {
+      cfg.dim_after_ms = (uint32_t)atoi(argv[++i]);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (only && !from_file) {
+    size_t i = 0;
+    while (i < SCENARIO_COUNT && strcmp(only, scenarios[i].name)) {
+      i++;
+    }
+    if (i == SCENARIO_COUNT) {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  sim_result_t res;
+  printf("{\"interactive_period_ms\":%u,\"idle_period_ms\":%u,"
+         "\"dim_after_ms\":%u,\"scenarios\":[",
+         cfg.interactive_period_ms, cfg.idle_period_ms, cfg.dim_after_ms);
+  if (from_file) {
+    simulate(&file_scenario, &cfg, &res);
+    print_result(file_scenario.name, &res);
+  } else {
+    bool first = true;
+    for (size_t i = 0; i < SCENARIO_COUNT; i++) {
+      if (only && strcmp(only, scenarios[i].name)) {
+        continue;
+      }
+      simulate(&scenarios[i], &cfg, &res);
+      printf("%s", first ? "" : ",");
+      print_result(scenarios[i].name, &res);
+      first = false;
+    }
+  }
+  printf("]}\n");
+  return 0;
+}
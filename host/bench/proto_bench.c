@@ -0,0 +1,247 @@
+/*
+ * Throughput of the watch-phone codec (phone_proto.c). Times frame encoding
+ * and in-place parsing on one thread, then streams status updates through
+ * the coalescer over the socket-pair loopback to a phone thread that decodes
+ * them, and checks the newest value of each status arrived. Prints one JSON
+ * object.
+ *
+ * usage: proto_bench [--updates N] [--mtu BYTES] [--flush-every N]
+ */
+#include "phone_loopback.h"
+#include "phone_proto.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#define CODEC_ROUNDS 200000
+
+static const char s_title[] = "Bohemian Rhapsody - Remastered 2011";
+static const char s_artist[] = "Queen";
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Status update number i: steps every time, battery and media less often
+static phone_msg_type_t make_update(uint32_t i, uint8_t *payload,
+                                    size_t *len) {
+  if (i % 16 == 15) {
+    phone_battery_t b = {.percent = 100 - i / 1000 % 100, .charging = false};
+    *len = phone_proto_encode_battery(&b, payload, PHONE_PROTO_MAX_PAYLOAD);
+    return PHONE_MSG_BATTERY;
+  }
+  if (i % 4 == 3) {
+    phone_media_state_t m = {
+        .playing = true,
+        .position_s = i % 355,
+        .duration_s = 355,
+        .title = s_title,
+        .title_len = sizeof(s_title) - 1,
+        .artist = s_artist,
+        .artist_len = sizeof(s_artist) - 1,
+    };
+    *len = phone_proto_encode_media_state(&m, payload, PHONE_PROTO_MAX_PAYLOAD);
+    return PHONE_MSG_MEDIA_STATE;
+  }
+  phone_steps_t s = {.steps = i};
+  *len = phone_proto_encode_steps(&s, payload, PHONE_PROTO_MAX_PAYLOAD);
+  return PHONE_MSG_STEPS;
+}
+
+typedef struct {
+  double encode_ns_per_frame;
+  double parse_ns_per_frame;
+  double parse_mb_per_s;
+  uint32_t frames_per_packet;
+} codec_result_t;
+
+static volatile uint32_t s_sink;
+
+static void run_codec(uint16_t mtu, codec_result_t *res) {
+  uint8_t packet[PHONE_PROTO_MAX_MTU];
+  uint8_t payload[PHONE_PROTO_MAX_PAYLOAD];
+  phone_proto_writer_t w;
+
+  // One packet filled with a mix of frames
+  uint32_t frames = 0;
+  uint64_t start = now_ns();
+  for (int round = 0; round < CODEC_ROUNDS; round++) {
+    phone_proto_writer_init(&w, packet, mtu);
+    for (uint32_t i = 0;; i++) {
+      size_t len;
+      phone_msg_type_t type = make_update(i, payload, &len);
+      if (!phone_proto_write(&w, type, payload, len)) {
+        break;
+      }
+      frames += round == 0;
+    }
+  }
+  res->encode_ns_per_frame =
+      (double)(now_ns() - start) / ((double)CODEC_ROUNDS * frames);
+  res->frames_per_packet = frames;
+
+  uint32_t sink = 0;
+  start = now_ns();
+  for (int round = 0; round < CODEC_ROUNDS; round++) {
+    phone_proto_reader_t r;
+    phone_proto_reader_init(&r, packet, w.len);
+    phone_proto_frame_t f;
+    while (phone_proto_next(&r, &f) == PHONE_PROTO_OK) {
+      phone_steps_t steps;
+      phone_battery_t battery;
+      phone_media_state_t media;
+      if (phone_proto_decode_steps(&f, &steps)) {
+        sink += steps.steps;
+      } else if (phone_proto_decode_battery(&f, &battery)) {
+        sink += battery.percent;
+      } else if (phone_proto_decode_media_state(&f, &media)) {
+        sink += media.title_len;
+      }
+    }
+  }
+  uint64_t elapsed = now_ns() - start;
+  s_sink = sink;
+  res->parse_ns_per_frame = (double)elapsed / ((double)CODEC_ROUNDS * frames);
+  res->parse_mb_per_s = (double)w.len * CODEC_ROUNDS / (elapsed / 1e3);
+}
+
+typedef struct {
+  phone_loopback_t *lb;
+  uint64_t packets;
+  uint64_t frames;
+  uint64_t bad;
+  uint32_t last_steps;
+  uint16_t last_position_s;
+  uint8_t last_battery;
+} phone_side_t;
+
+static void *phone_thread(void *arg) {
+  phone_side_t *ph = arg;
+  uint8_t packet[PHONE_PROTO_MAX_MTU];
+  ssize_t n;
+  while ((n = phone_loopback_recv(ph->lb, 1, packet, sizeof(packet))) > 0) {
+    ph->packets++;
+    phone_proto_reader_t r;
+    phone_proto_reader_init(&r, packet, n);
+    phone_proto_frame_t f;
+    phone_proto_err_t err;
+    while ((err = phone_proto_next(&r, &f)) == PHONE_PROTO_OK) {
+      phone_steps_t steps;
+      phone_battery_t battery;
+      phone_media_state_t media;
+      ph->frames++;
+      if (phone_proto_decode_steps(&f, &steps)) {
+        ph->last_steps = steps.steps;
+      } else if (phone_proto_decode_battery(&f, &battery)) {
+        ph->last_battery = battery.percent;
+      } else if (phone_proto_decode_media_state(&f, &media) &&
+                 media.title_len == sizeof(s_title) - 1 &&
+                 !memcmp(media.title, s_title, media.title_len)) {
+        ph->last_position_s = media.position_s;
+      } else {
+        ph->bad++;
+      }
+    }
+    ph->bad += err != PHONE_PROTO_END;
+  }
+  return NULL;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [--updates N] [--mtu BYTES] [--flush-every N]\n", prog);
+}
+
+int main(int argc, char **argv) {
+  uint32_t updates = 1000000;
+  int mtu = PHONE_PROTO_DEFAULT_MTU;
+  uint32_t flush_every = 8;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--updates") && i + 1 < argc) {
+      updates = strtoul(argv[++i], NULL, 0);
+    } else if (!strcmp(argv[i], "--mtu") && i + 1 < argc) {
+      mtu = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--flush-every") && i + 1 < argc) {
+      flush_every = strtoul(argv[++i], NULL, 0);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (mtu < PHONE_PROTO_MIN_MTU || mtu > PHONE_PROTO_MAX_MTU) {
+    fprintf(stderr, "--mtu must be %d to %d\n", PHONE_PROTO_MIN_MTU,
+            PHONE_PROTO_MAX_MTU);
+    return 1;
+  }
+  if (updates == 0 || flush_every == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  codec_result_t codec;
+  run_codec(mtu, &codec);
+
+  phone_loopback_t lb;
+  if (phone_loopback_open(&lb) != 0) {
+    perror("socketpair");
+    return 1;
+  }
+  phone_side_t phone = {.lb = &lb};
+  pthread_t thread;
+  pthread_create(&thread, NULL, phone_thread, &phone);
+
+  phone_proto_transport_t t = phone_loopback_transport(&lb, 0, mtu);
+  phone_proto_coalescer_t c;
+  phone_proto_coalescer_init(&c);
+  uint8_t payload[PHONE_PROTO_MAX_PAYLOAD];
+  uint32_t want_steps = 0, want_battery = 0, want_position = 0;
+  int send_err = 0;
+  uint64_t start = now_ns();
+  for (uint32_t i = 0; i < updates && send_err >= 0; i++) {
+    size_t len;
+    phone_msg_type_t type = make_update(i, payload, &len);
+    phone_proto_post(&c, type, payload, len);
+    if (type == PHONE_MSG_STEPS) {
+      want_steps = i;
+    } else if (type == PHONE_MSG_BATTERY) {
+      want_battery = 100 - i / 1000 % 100;
+    } else {
+      want_position = i % 355;
+    }
+    if (i % flush_every == flush_every - 1) {
+      send_err = phone_proto_flush(&c, &t);
+    }
+  }
+  if (send_err >= 0) {
+    send_err = phone_proto_flush(&c, &t);
+  }
+  shutdown(lb.end[0].fd, SHUT_WR);
+  pthread_join(thread, NULL);
+  double elapsed_s = (now_ns() - start) / 1e9;
+  phone_loopback_close(&lb);
+
+  bool ok = send_err >= 0 && phone.bad == 0 &&
+            phone.packets == lb.end[0].packets_sent &&
+            phone.frames == c.frames && phone.last_steps == want_steps &&
+            phone.last_battery == want_battery &&
+            phone.last_position_s == want_position;
+  printf("{\"mtu\":%d,\"encode_ns_per_frame\":%.1f,"
+         "\"parse_ns_per_frame\":%.1f,\"parse_mb_per_s\":%.1f,"
+         "\"frames_per_full_packet\":%u,"
+         "\"updates\":%u,\"superseded\":%u,\"frames_sent\":%u,"
+         "\"packets\":%llu,\"bytes\":%llu,\"updates_per_packet\":%.2f,"
+         "\"bytes_per_frame\":%.1f,\"updates_per_s\":%.0f,\"ok\":%s}\n",
+         mtu, codec.encode_ns_per_frame, codec.parse_ns_per_frame,
+         codec.parse_mb_per_s, codec.frames_per_packet, updates, c.superseded,
+         c.frames, (unsigned long long)lb.end[0].packets_sent,
+         (unsigned long long)lb.end[0].bytes_sent,
+         (double)updates / lb.end[0].packets_sent,
+         (double)lb.end[0].bytes_sent / c.frames, updates / elapsed_s,
+         ok ? "true" : "false");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+/*
+ * Drives lv_timer_handler over simulated time against the recording panel and
+ * prints one JSON object with per-frame render cost and flush traffic.
+ *
+ * --ui screens starts on the clock and swipes through the screen manager's
+ * screens every SWIPE_EVERY_MS, bouncing at either end.
+ *
+ * --ui notifs stores --notifs N notifications in the fake flash partition
+ * and scrolls the notifications list up and down at SCROLL_PX per 60 Hz
+ * frame, so render_us_per_frame is the scroll frame time.
+ *
+ * --no-tile-skip sends every flushed strip whole, for comparing traffic
+ * against the default tile skipping.
+ *
+ * usage: render_bench [--ui clock|demo|screens|notifs] [--seconds N]
+ *                     [--notifs N] [--dma-free KB] [--no-tile-skip]
+ */
+#include "config.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "fake_panel.h"
+#include "lvgl.h"
+#include "lv_mem_pool.h"
+#include "lvgl_display.h"
+#include "notif_store.h"
+#include "screen_mgr.h"
+#include "ui.h"
+#include "ui_cmd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <time.h>
+
+#define SWIPE_EVERY_MS 2000
+#define SCROLL_EVERY_MS 16
+#define SCROLL_PX 12
+// Index of the notifications screen in ui.c's swipe order
+#define NOTIF_SCREEN 2
+
+typedef struct {
+  uint64_t start_ns;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint32_t frames;
+} render_stats_t;
+
+static render_stats_t s_render;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void render_start_cb(lv_event_t *e) {
+  (void)e;
+  s_render.start_ns = now_ns();
+}
+
+static void render_ready_cb(lv_event_t *e) {
+  (void)e;
+  uint64_t elapsed = now_ns() - s_render.start_ns;
+  s_render.total_ns += elapsed;
+  s_render.max_ns = MAX(s_render.max_ns, elapsed);
+  s_render.frames++;
+}
+
+// The clock tick, run in the LVGL task like the device's time_svc callback
+static void bench_set_time(void *arg) {
+  uint32_t s = (uint32_t)(uintptr_t)arg;
+  set_time(s / 3600, s / 60 % 60, s % 60);
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [--ui clock|demo|screens|notifs] [--seconds N] "
+          "[--notifs N] [--dma-free KB] [--no-tile-skip]\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  const char *ui = "clock";
+  int seconds = 10;
+  int notifs = 400;
+  bool tile_skip = true;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--ui") && i + 1 < argc) {
+      ui = argv[++i];
+    } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--notifs") && i + 1 < argc) {
+      notifs = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--dma-free") && i + 1 < argc) {
+      // Free DMA heap the draw buffer policy sizes against
+      fake_heap_set_dma_free((size_t)atoi(argv[++i]) * 1024);
+    } else if (!strcmp(argv[i], "--no-tile-skip")) {
+      tile_skip = false;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (seconds <= 0 || notifs < 0 ||
+      (strcmp(ui, "clock") && strcmp(ui, "demo") && strcmp(ui, "screens") &&
+       strcmp(ui, "notifs"))) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  lv_display_t *display = display_init();
+  if (!tile_skip) {
+    display_set_tile_skip(false);
+  }
+  lv_display_add_event_cb(display, render_start_cb, LV_EVENT_RENDER_START,
+                          NULL);
+  lv_display_add_event_cb(display, render_ready_cb, LV_EVENT_RENDER_READY,
+                          NULL);
+
+  bool screens_ui = !strcmp(ui, "screens");
+  bool notifs_ui = !strcmp(ui, "notifs");
+  bool clock_ui = screens_ui || !strcmp(ui, "clock");
+  notif_store_init();
+  if (notifs_ui) {
+    for (int i = 0; i < notifs; i++) {
+      notif_t n = {.time = 1700000000 + i * 60, .app = i % 5};
+      snprintf(n.title, sizeof(n.title), "Message %d", i);
+      // Texts of every length up to a few lines
+      snprintf(n.text, sizeof(n.text), "%.*s", 8 + i * 37 % NOTIF_TEXT_MAX,
+               "Lorem ipsum dolor sit amet, consectetur adipiscing elit, "
+               "sed do eiusmod tempor incididunt ut labore et dolore magna "
+               "aliqua. Ut enim ad minim veniam, quis nostrud exercitation "
+               "ullamco laboris nisi ut aliquip");
+      ui_add_notification(&n);
+    }
+  }
+  if (clock_ui || notifs_ui) {
+    lv_screen(display);
+    set_time(12, 30, 45);
+  } else {
+    example_lvgl_demo_ui(display);
+  }
+  if (notifs_ui) {
+    screen_mgr_show(NOTIF_SCREEN);
+  }
+
+  // Same pacing as example_lvgl_port_task: sleep until the next LVGL timer
+  // or the next wake, here the once-a-second clock timer
+  const int64_t end_us = (int64_t)seconds * 1000000;
+  int64_t next_second_us = 1000000;
+  uint32_t wakeups = 0;
+  uint32_t clock_s = 12 * 3600 + 30 * 60 + 45;
+  int64_t next_swipe_us = SWIPE_EVERY_MS * 1000;
+  int swipe_dir = 1;
+  int64_t next_scroll_us = SCROLL_EVERY_MS * 1000;
+  int scroll_dir = 1;
+  uint32_t scroll_px = 0;
+  while (esp_timer_get_time() < end_us) {
+    ui_cmd_dispatch();
+    notif_list_t *list = ui_notif_list();
+    if (notifs_ui && list && esp_timer_get_time() >= next_scroll_us) {
+      // Down to the oldest, then back up to the newest
+      if ((scroll_dir > 0 && lv_obj_get_scroll_bottom(list->obj) <= 0) ||
+          (scroll_dir < 0 && lv_obj_get_scroll_top(list->obj) <= 0)) {
+        scroll_dir = -scroll_dir;
+      }
+      lv_obj_scroll_by(list->obj, 0, -scroll_dir * SCROLL_PX, LV_ANIM_OFF);
+      scroll_px += SCROLL_PX;
+      next_scroll_us += SCROLL_EVERY_MS * 1000;
+    }
+    if (screens_ui && esp_timer_get_time() >= next_swipe_us) {
+      if (!screen_mgr_swipe(swipe_dir)) {
+        swipe_dir = -swipe_dir;
+        screen_mgr_swipe(swipe_dir);
+      }
+      next_swipe_us += SWIPE_EVERY_MS * 1000;
+    }
+    uint32_t time_till_next_ms = lv_timer_handler();
+    wakeups++;
+
+    int64_t now_us = esp_timer_get_time();
+    int64_t step_us = end_us - now_us;
+    if (time_till_next_ms != LV_NO_TIMER_READY) {
+      time_till_next_ms = MAX(time_till_next_ms, LVGL_TASK_MIN_DELAY_MS);
+      step_us = MIN(step_us, (int64_t)time_till_next_ms * 1000);
+    }
+    if (screens_ui) {
+      step_us = MIN(step_us, MAX(next_swipe_us - now_us, 0));
+    }
+    if (notifs_ui) {
+      step_us = MIN(step_us, MAX(next_scroll_us - now_us, 0));
+    }
+    if (clock_ui && now_us + step_us >= next_second_us) {
+      fake_esp_timer_advance(next_second_us - now_us);
+      clock_s = (clock_s + 1) % (24 * 3600);
+      ui_cmd_post_call(bench_set_time, (void *)(uintptr_t)clock_s);
+      next_second_us += 1000000;
+    } else {
+      fake_esp_timer_advance(step_us);
+    }
+  }
+
+  fake_panel_stats_t panel;
+  fake_panel_get_stats(&panel);
+  display_flush_stats_t flush;
+  display_get_flush_stats(&flush);
+  display_panel_stats_t panel_state;
+  display_get_panel_stats(&panel_state);
+  lv_mem_pool_stats_t mem;
+  lv_mem_pool_get_stats(&mem);
+
+  uint32_t frames = s_render.frames;
+  printf("{\"ui\":\"%s\",\"sim_seconds\":%d,\"lvgl_wakeups\":%u,"
+         "\"frames\":%u,"
+         "\"render_us_per_frame\":%.2f,\"render_us_max\":%.2f,"
+         "\"flush_calls\":%u,\"bytes_pushed\":%llu,\"panel_windows\":%u,"
+         "\"strips_streamed\":%u,\"strips_resumed\":%u,"
+         "\"areas_merged\":%u,\"panel_cmds\":%u,"
+         "\"panel_cmds_sent\":%u,\"panel_cmds_skipped\":%u,"
+         "\"draw_bufs\":%u,\"draw_buf_lines\":%u,\"render_stalls\":%u,"
+         "\"bus_time_us\":%llu,\"peak_lvgl_heap\":%u,"
+         "\"tiles_hashed\":%u,\"tiles_skipped\":%u,\"tiles_partial\":%u,"
+         "\"tile_hit_pct\":%.1f,\"strips_skipped\":%u,"
+         "\"bytes_skipped\":%llu",
+         ui, seconds, wakeups, frames,
+         frames ? s_render.total_ns / 1000.0 / frames : 0.0,
+         s_render.max_ns / 1000.0, panel.draw_calls,
+         (unsigned long long)panel.bytes, panel.windows,
+         flush.strips_streamed, flush.strips_resumed, flush.areas_merged,
+         panel.cmds, panel_state.cmds_sent, panel_state.cmds_skipped,
+         flush.draw_bufs, flush.draw_buf_lines, flush.render_stalls,
+         (unsigned long long)fake_panel_bus_time_us(), (unsigned)mem.max_used,
+         flush.tiles_hashed, flush.tiles_skipped, flush.tiles_partial,
+         flush.tiles_hashed ? 100.0 * flush.tiles_skipped / flush.tiles_hashed
+                            : 0.0,
+         flush.strips_skipped, (unsigned long long)flush.bytes_skipped);
+  if (screens_ui) {
+    screen_mgr_stats_t scr;
+    screen_mgr_get_stats(&scr);
+    printf(",\"screens\":{\"created\":%u,\"evicted\":%u,\"live\":%u,"
+           "\"snapshots\":%u,\"swipe_renders\":%u,\"snapshot_hits\":%u,"
+           "\"live_fallbacks\":%u,\"heap_used\":%u,\"snapshot_bytes\":%u}",
+           scr.created, scr.evicted, scr.live, scr.snapshots,
+           scr.swipe_renders, scr.snapshot_hits, scr.live_fallbacks,
+           scr.heap_used, scr.snapshot_bytes);
+  }
+  notif_list_t *list = ui_notif_list();
+  notif_ring_t *ring = notif_store_ring();
+  if (notifs_ui && list && ring) {
+    printf(",\"notifs\":{\"stored\":%u,\"dropped\":%u,\"rows\":%u,"
+           "\"binds\":%u,\"bind_fails\":%u,\"index_builds\":%u,"
+           "\"scroll_px\":%u}",
+           (unsigned)notif_ring_count(ring), ring->stats.dropped,
+           list->row_count, list->stats.binds, list->stats.bind_fails,
+           ring->stats.index_builds, scroll_px);
+  }
+  printf(",\"lvgl_mem\":{\"used\":%u,\"largest_free\":%u,\"frag_pct\":%u,"
+         "\"slab_pages\":%u,\"run_pages\":%u,\"failures\":%u,"
+         "\"arena_pages_freed\":%u,\"arena_survivors\":%u}",
+         mem.used, mem.largest_free, mem.frag_pct, mem.pages_slab,
+         mem.pages_run, mem.failures, mem.arena_pages_freed,
+         mem.arena_survivors);
+  printf("}\n");
+  return 0;
+}
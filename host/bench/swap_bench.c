@@ -0,0 +1,159 @@
+/*
+ * Compares the three ways of getting big-endian RGB565 to the panel:
+ * lv_draw_sw_rgb565_swap in flush (the original path), the word-at-a-time
+ * kernel in flush, and rendering LV_COLOR_FORMAT_RGB565_SWAPPED directly
+ * (LVGL 9.3+ only). Prints one JSON object.
+ *
+ * usage: swap_bench [--frames N]
+ */
+#include "config.h"
+#include "draw/sw/lv_draw_sw.h"
+#include "lvgl.h"
+#include "rgb565_swap.h"
+#include "ui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define KERNEL_ITERATIONS 2000
+// The original fixed draw buffer height
+#define BUF_LINES 20
+#define BUF_PX (EXAMPLE_LCD_H_RES * BUF_LINES)
+
+#if LVGL_VERSION_MAJOR > 9 || (LVGL_VERSION_MAJOR == 9 && LVGL_VERSION_MINOR >= 3)
+#define HAVE_RGB565_SWAPPED 1
+#else
+#define HAVE_RGB565_SWAPPED 0
+#endif
+
+typedef enum {
+  MODE_SWAP_LVGL,
+  MODE_SWAP_WORDS,
+  MODE_RENDER_SWAPPED,
+} swap_mode_t;
+
+static const char *const mode_names[] = {"swap_lvgl", "swap_words",
+                                         "render_swapped"};
+
+static swap_mode_t s_mode;
+static uint64_t s_swap_ns;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t tick_ms(void) { return now_ns() / 1000000; }
+
+static void flush_cb(lv_display_t *disp, const lv_area_t *area,
+                     uint8_t *px_map) {
+  uint32_t px = lv_area_get_size(area);
+  uint64_t start = now_ns();
+  if (s_mode == MODE_SWAP_LVGL) {
+    lv_draw_sw_rgb565_swap(px_map, px);
+  } else if (s_mode == MODE_SWAP_WORDS) {
+    rgb565_swap_words(px_map, px);
+  }
+  s_swap_ns += now_ns() - start;
+  lv_display_flush_ready(disp);
+}
+
+static bool kernels_match(void) {
+  static uint16_t a[BUF_PX + 1];
+  static uint16_t b[BUF_PX + 1];
+  for (size_t i = 0; i < BUF_PX + 1; i++) {
+    a[i] = b[i] = (uint16_t)rand();
+  }
+  // Odd start and odd length exercise the head/tail paths
+  lv_draw_sw_rgb565_swap(a, BUF_PX);
+  rgb565_swap_words(b, BUF_PX);
+  lv_draw_sw_rgb565_swap(a + 1, BUF_PX - 1);
+  rgb565_swap_words(b + 1, BUF_PX - 1);
+  return memcmp(a, b, sizeof(a)) == 0;
+}
+
+static double kernel_ns_per_px(swap_mode_t mode) {
+  static uint16_t buf[BUF_PX];
+  uint64_t start = now_ns();
+  for (int i = 0; i < KERNEL_ITERATIONS; i++) {
+    if (mode == MODE_SWAP_LVGL) {
+      lv_draw_sw_rgb565_swap(buf, BUF_PX);
+    } else {
+      rgb565_swap_words(buf, BUF_PX);
+    }
+  }
+  return (double)(now_ns() - start) / KERNEL_ITERATIONS / BUF_PX;
+}
+
+// Average µs per full-screen refresh, swap time returned separately
+static double frame_us(swap_mode_t mode, int frames, double *swap_us) {
+  size_t buf_sz = BUF_PX * sizeof(uint16_t);
+  void *buf1 = malloc(buf_sz);
+  void *buf2 = malloc(buf_sz);
+  lv_display_t *disp = lv_display_create(EXAMPLE_LCD_H_RES, EXAMPLE_LCD_V_RES);
+  lv_display_set_buffers(disp, buf1, buf2, buf_sz,
+                         LV_DISPLAY_RENDER_MODE_PARTIAL);
+#if HAVE_RGB565_SWAPPED
+  lv_display_set_color_format(disp, mode == MODE_RENDER_SWAPPED
+                                        ? LV_COLOR_FORMAT_RGB565_SWAPPED
+                                        : LV_COLOR_FORMAT_RGB565);
+#else
+  lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+#endif
+  lv_display_set_flush_cb(disp, flush_cb);
+  lv_screen(disp);
+  set_time(12, 30, 45);
+  lv_refr_now(disp);
+
+  s_mode = mode;
+  s_swap_ns = 0;
+  uint64_t start = now_ns();
+  for (int i = 0; i < frames; i++) {
+    lv_obj_invalidate(lv_display_get_screen_active(disp));
+    lv_refr_now(disp);
+  }
+  double total_us = (now_ns() - start) / 1000.0 / frames;
+  *swap_us = s_swap_ns / 1000.0 / frames;
+
+  lv_display_delete(disp);
+  free(buf1);
+  free(buf2);
+  return total_us;
+}
+
+int main(int argc, char **argv) {
+  int frames = 200;
+  if (argc == 3 && !strcmp(argv[1], "--frames")) {
+    frames = atoi(argv[2]);
+  }
+  if (frames <= 0) {
+    fprintf(stderr, "usage: %s [--frames N]\n", argv[0]);
+    return 1;
+  }
+
+  lv_init();
+  lv_tick_set_cb(tick_ms);
+
+  printf("{\"buffer_px\":%d,\"kernels_match\":%s,", BUF_PX,
+         kernels_match() ? "true" : "false");
+  printf("\"kernel_ns_per_px\":{\"swap_lvgl\":%.4f,\"swap_words\":%.4f},",
+         kernel_ns_per_px(MODE_SWAP_LVGL), kernel_ns_per_px(MODE_SWAP_WORDS));
+  printf("\"frames\":%d,\"full_frame\":[", frames);
+  for (swap_mode_t mode = MODE_SWAP_LVGL; mode <= MODE_RENDER_SWAPPED;
+       mode++) {
+    if (mode == MODE_RENDER_SWAPPED && !HAVE_RGB565_SWAPPED) {
+      printf(",{\"mode\":\"%s\",\"supported\":false}", mode_names[mode]);
+      continue;
+    }
+    double swap_us;
+    double total_us = frame_us(mode, frames, &swap_us);
+    printf("%s{\"mode\":\"%s\",\"supported\":true,\"frame_us\":%.2f,"
+           "\"swap_us\":%.2f}",
+           mode == MODE_SWAP_LVGL ? "" : ",", mode_names[mode], total_us,
+           swap_us);
+  }
+  printf("]}\n");
+  return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * Checks the local time engine (local_time.c) against the C library's
+ * localtime_r for a set of POSIX TZ rules: every second around each DST
+ * transition of several years, then random instants from 1970 to 2200.
+ * Then measures a second-by-second clock and random instants against
+ * localtime_r. Prints one JSON object and exits non-zero on a mismatch.
+ *
+ * usage: time_bench [--samples N] [--seed S]
+ */
+#include "config.h"
+#include "local_time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Seconds checked either side of each transition
+#define EDGE_SECS (2 * 3600)
+#define CLOCK_SECS (30 * 86400)
+
+/* Rules with all their parts spelled out: glibc takes a bare "EST5EDT" as
+ * a zoneinfo file, and fills in missing rules from its posixrules file. */
+static const char *const s_rules[] = {
+    WATCH_TZ,
+    "CET-1CEST,M3.5.0,M10.5.0/3",
+    "AEST-10AEDT,M10.1.0,M4.1.0/3", // DST across the new year
+    "NZST-12NZDT,M9.5.0,M4.1.0/3",
+    "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1", // negative transition times
+    "EST5EDT,M3.2.0/2,M11.1.0/26",      // past 24 h
+    "XST3XDT2,J60/1:30,J300/23:59:59",
+    "YST9YDT,59,300",
+    "IST-5:30",
+    "<+0545>-5:45",
+    "UTC0",
+};
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int64_t rand64(int64_t lo, int64_t hi) {
+  uint64_t r = (uint64_t)rand() << 40 ^ (uint64_t)rand() << 20 ^ rand();
+  return lo + (int64_t)(r % (uint64_t)(hi - lo));
+}
+
+static bool same_tm(const struct tm *a, const struct tm *b) {
+  return a->tm_year == b->tm_year && a->tm_mon == b->tm_mon &&
+         a->tm_mday == b->tm_mday && a->tm_hour == b->tm_hour &&
+         a->tm_min == b->tm_min && a->tm_sec == b->tm_sec &&
+         a->tm_wday == b->tm_wday && a->tm_yday == b->tm_yday &&
+         a->tm_isdst == b->tm_isdst;
+}
+
+typedef struct {
+  uint64_t checked;
+  uint64_t mismatches;
+} check_t;
+
+static void check_at(local_time_t *lt, int64_t utc, const char *rule,
+                     check_t *c) {
+  time_t t = (time_t)utc;
+  struct tm want, got;
+  localtime_r(&t, &want);
+  local_time_get(lt, utc, &got);
+  c->checked++;
+  if (!same_tm(&want, &got) && c->mismatches++ < 10) {
+    fprintf(stderr,
+            "%s at %lld: want %04d-%02d-%02d %02d:%02d:%02d dst %d, "
+            "got %04d-%02d-%02d %02d:%02d:%02d dst %d\n",
+            rule, (long long)utc, want.tm_year + 1900, want.tm_mon + 1,
+            want.tm_mday, want.tm_hour, want.tm_min, want.tm_sec,
+            want.tm_isdst, got.tm_year + 1900, got.tm_mon + 1, got.tm_mday,
+            got.tm_hour, got.tm_min, got.tm_sec, got.tm_isdst);
+  }
+}
+
+static void set_libc_tz(const char *rule) {
+  setenv("TZ", rule, 1);
+  tzset();
+}
+
+/* Walk the instants where localtime_r's isdst flips, found by stepping
+ * hours, and compare every second around each one in both directions. */
+static void check_rule(const char *rule, int samples, check_t *c) {
+  local_tz_t tz;
+  if (!local_tz_parse(rule, &tz)) {
+    fprintf(stderr, "%s: does not parse\n", rule);
+    c->mismatches++;
+    return;
+  }
+  set_libc_tz(rule);
+  local_time_t lt;
+  local_time_init(&lt, &tz);
+  for (int64_t year = 1995; year < 2045; year += 7) {
+    struct tm jan1 = {.tm_year = (int)(year - 1900), .tm_mday = 1};
+    int64_t start = timegm(&jan1);
+    int prev = -1;
+    for (int64_t h = start; h < start + 366 * 86400; h += 3600) {
+      time_t t = (time_t)h;
+      struct tm tm;
+      localtime_r(&t, &tm);
+      if (prev >= 0 && tm.tm_isdst != prev) {
+        for (int64_t s = h - EDGE_SECS; s < h + EDGE_SECS; s++) {
+          check_at(&lt, s, rule, c);
+        }
+        for (int64_t s = h + EDGE_SECS; s > h - EDGE_SECS; s--) {
+          check_at(&lt, s, rule, c);
+        }
+      }
+      prev = tm.tm_isdst;
+    }
+  }
+  // Far apart instants, every conversion leaves the cached span and day
+  for (int i = 0; i < samples; i++) {
+    check_at(&lt, rand64(0, 7258118400LL), rule, c);
+  }
+}
+
+int main(int argc, char **argv) {
+  int samples = 200000;
+  unsigned seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--samples") && i + 1 < argc) {
+      samples = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = (unsigned)atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--samples N] [--seed S]\n", argv[0]);
+      return 1;
+    }
+  }
+  srand(seed);
+
+  check_t c = {0};
+  size_t rules = sizeof(s_rules) / sizeof(s_rules[0]);
+  for (size_t r = 0; r < rules; r++) {
+    check_rule(s_rules[r], samples, &c);
+  }
+  // A daylight name without rules takes the US ones, as newlib does
+  local_tz_t bare, spelled;
+  c.checked++;
+  if (!local_tz_parse("EST5EDT", &bare) ||
+      !local_tz_parse("EST5EDT,M3.2.0/2,M11.1.0/2", &spelled) ||
+      memcmp(&bare, &spelled, sizeof(bare))) {
+    fprintf(stderr, "EST5EDT: not the default rules\n");
+    c.mismatches++;
+  }
+
+  // The watch: one conversion per second of a month, over a DST change
+  local_tz_t tz;
+  local_tz_parse(WATCH_TZ, &tz);
+  set_libc_tz(WATCH_TZ);
+  local_time_t lt;
+  local_time_init(&lt, &tz);
+  const int64_t clock_start = 1709251200; // 2024-03-01
+  volatile int sink = 0;
+  uint64_t start = now_ns();
+  for (int64_t s = clock_start; s < clock_start + CLOCK_SECS; s++) {
+    struct tm tm;
+    local_time_get(&lt, s, &tm);
+    sink ^= tm.tm_sec;
+  }
+  double clock_ns = (double)(now_ns() - start) / CLOCK_SECS;
+  local_time_stats_t clock_stats = lt.stats;
+  start = now_ns();
+  for (int64_t s = clock_start; s < clock_start + CLOCK_SECS; s++) {
+    time_t t = (time_t)s;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    sink ^= tm.tm_sec;
+  }
+  double libc_clock_ns = (double)(now_ns() - start) / CLOCK_SECS;
+
+  enum { RANDOM = 1 << 20 };
+  static int64_t instants[RANDOM];
+  for (int i = 0; i < RANDOM; i++) {
+    instants[i] = rand64(0, 4102444800LL);
+  }
+  start = now_ns();
+  for (int i = 0; i < RANDOM; i++) {
+    struct tm tm;
+    local_time_get(&lt, instants[i], &tm);
+    sink ^= tm.tm_sec;
+  }
+  double random_ns = (double)(now_ns() - start) / RANDOM;
+  start = now_ns();
+  for (int i = 0; i < RANDOM; i++) {
+    time_t t = (time_t)instants[i];
+    struct tm tm;
+    localtime_r(&t, &tm);
+    sink ^= tm.tm_sec;
+  }
+  double libc_random_ns = (double)(now_ns() - start) / RANDOM;
+
+  printf("{\"rules\":%zu,\"checked\":%llu,\"mismatches\":%llu,"
+         "\"clock_ns\":%.2f,\"localtime_r_clock_ns\":%.2f,"
+         "\"clock_span_changes\":%u,\"clock_day_changes\":%u,"
+         "\"random_ns\":%.2f,\"localtime_r_random_ns\":%.2f}\n",
+         rules, (unsigned long long)c.checked,
+         (unsigned long long)c.mismatches, clock_ns, libc_clock_ns,
+         (unsigned)clock_stats.span_changes,
+         (unsigned)clock_stats.day_changes, random_ns, libc_random_ns);
+  return c.mismatches ? 1 : 0;
+}
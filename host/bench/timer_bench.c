@@ -0,0 +1,334 @@
+/*
+ * Checks the timer wheel (timer_wheel.c) against a brute-force model over
+ * random start/stop/pause/resume/advance sequences, then measures it:
+ * start+stop cost with many timers armed, cost per fired callback, and a
+ * day of the watch's periodic work, counting the wakeups of one wheel on a
+ * single one-shot timer against one task per tick source. Prints one JSON
+ * object and exits non-zero when the wheel and the model disagree.
+ *
+ * usage: timer_bench [--ops N] [--seed S]
+ */
+#include "timer_wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MODEL_TIMERS 64
+#define MAX_FIRES (1 << 16)
+// Callbacks one model advance may expect, long steps are shortened to fit
+#define STEP_FIRES 512
+#define BENCH_TIMERS 10000
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+typedef struct {
+  uint64_t time;
+  uint32_t id;
+} fire_t;
+
+static fire_t s_got[MAX_FIRES];
+static uint32_t s_got_count;
+
+typedef struct {
+  timer_wheel_t *w;
+  uint32_t id;
+} model_ctx_t;
+
+static void record_fire(timer_wheel_timer_t *t) {
+  model_ctx_t *ctx = t->arg;
+  if (s_got_count < MAX_FIRES) {
+    s_got[s_got_count++] = (fire_t){ctx->w->now, ctx->id};
+  }
+}
+
+// What the wheel should do, one plain struct per timer
+typedef struct {
+  timer_wheel_state_t state;
+  uint64_t expires;
+  uint32_t period;
+  uint32_t remaining;
+} model_timer_t;
+
+static int fire_cmp(const void *a, const void *b) {
+  const fire_t *x = a, *y = b;
+  if (x->time != y->time) {
+    return x->time < y->time ? -1 : 1;
+  }
+  return (int)x->id - (int)y->id;
+}
+
+// Delays across every level and past the overflow boundary
+static uint32_t random_delay(void) {
+  switch (rand() % 6) {
+  case 0:
+    return rand() % 4;
+  case 1:
+    return rand() % TIMER_WHEEL_SLOTS;
+  case 2:
+    return rand() % (TIMER_WHEEL_SLOTS * TIMER_WHEEL_SLOTS);
+  case 3:
+    return rand() % (1u << 18);
+  case 4:
+    return rand() % (1u << TIMER_WHEEL_SPAN_BITS);
+  default:
+    return (uint32_t)rand() << 6;
+  }
+}
+
+static uint32_t random_step(void) {
+  switch (rand() % 4) {
+  case 0:
+    return rand() % 8;
+  case 1:
+    return rand() % 1000;
+  case 2:
+    return rand() % (1u << 20);
+  default:
+    return (uint32_t)rand() << 4;
+  }
+}
+
+// Callbacks the model expects up to target
+static uint64_t model_fires(const model_timer_t *model, uint64_t target) {
+  uint64_t n = 0;
+  for (uint32_t j = 0; j < MODEL_TIMERS; j++) {
+    const model_timer_t *m = &model[j];
+    if (m->state != TIMER_WHEEL_ARMED || m->expires > target) {
+      continue;
+    }
+    n += m->period ? (target - m->expires) / m->period + 1 : 1;
+  }
+  return n;
+}
+
+/* Returns the number of mismatching advances */
+static uint32_t run_model(long ops, uint64_t *fires_checked) {
+  static timer_wheel_t w;
+  static timer_wheel_timer_t timers[MODEL_TIMERS];
+  static model_ctx_t ctx[MODEL_TIMERS];
+  static model_timer_t model[MODEL_TIMERS];
+  static fire_t want[MAX_FIRES];
+  uint32_t mismatches = 0;
+
+  // Start close to an overflow boundary so it is crossed early on
+  uint64_t now = (1ull << TIMER_WHEEL_SPAN_BITS) - 5000;
+  timer_wheel_init(&w, now);
+  memset(model, 0, sizeof(model));
+  for (uint32_t i = 0; i < MODEL_TIMERS; i++) {
+    ctx[i] = (model_ctx_t){&w, i};
+    timer_wheel_timer_init(&timers[i], record_fire, &ctx[i]);
+  }
+
+  for (long op = 0; op < ops; op++) {
+    uint32_t i = rand() % MODEL_TIMERS;
+    model_timer_t *m = &model[i];
+    switch (rand() % 8) {
+    case 0:
+    case 1: {
+      uint32_t delay = random_delay();
+      uint32_t period = 0;
+      if (rand() % 2) {
+        period = rand() % 4 ? 200u + rand() % 5000 : 1 + random_delay();
+      }
+      timer_wheel_start(&w, &timers[i], delay, period);
+      *m = (model_timer_t){TIMER_WHEEL_ARMED, now + delay, period, 0};
+      break;
+    }
+    case 2:
+      timer_wheel_stop(&w, &timers[i]);
+      m->state = TIMER_WHEEL_IDLE;
+      break;
+    case 3:
+      timer_wheel_pause(&w, &timers[i]);
+      if (m->state == TIMER_WHEEL_ARMED) {
+        m->remaining = m->expires - now;
+        m->state = TIMER_WHEEL_PAUSED;
+      }
+      break;
+    case 4:
+      timer_wheel_resume(&w, &timers[i]);
+      if (m->state == TIMER_WHEEL_PAUSED) {
+        m->expires = now + m->remaining;
+        m->state = TIMER_WHEEL_ARMED;
+      }
+      break;
+    default: {
+      uint64_t step = random_step();
+      while (step && model_fires(model, now + step) > STEP_FIRES) {
+        step /= 2;
+      }
+      uint64_t target = now + step;
+      uint32_t nwant = 0;
+      for (uint32_t j = 0; j < MODEL_TIMERS; j++) {
+        model_timer_t *mj = &model[j];
+        while (mj->state == TIMER_WHEEL_ARMED && mj->expires <= target &&
+               nwant < MAX_FIRES) {
+          want[nwant++] = (fire_t){mj->expires, j};
+          if (mj->period) {
+            mj->expires += mj->period;
+          } else {
+            mj->state = TIMER_WHEEL_IDLE;
+          }
+        }
+      }
+      s_got_count = 0;
+      uint32_t fired = timer_wheel_advance(&w, target);
+      now = target;
+      qsort(want, nwant, sizeof(want[0]), fire_cmp);
+      qsort(s_got, s_got_count, sizeof(s_got[0]), fire_cmp);
+      if (fired != nwant || s_got_count != nwant ||
+          memcmp(want, s_got, nwant * sizeof(want[0]))) {
+        mismatches++;
+      }
+      *fires_checked += nwant;
+      break;
+    }
+    }
+    // The next deadline has to agree too
+    uint64_t next = UINT64_MAX, got;
+    for (uint32_t j = 0; j < MODEL_TIMERS; j++) {
+      if (model[j].state == TIMER_WHEEL_ARMED && model[j].expires < next) {
+        next = model[j].expires;
+      }
+    }
+    if (timer_wheel_next(&w, &got) ? got != next : next != UINT64_MAX) {
+      mismatches++;
+    }
+    for (uint32_t j = 0; j < MODEL_TIMERS; j++) {
+      if (timers[j].state != model[j].state) {
+        mismatches++;
+      }
+    }
+  }
+  return mismatches;
+}
+
+static void count_fire(timer_wheel_timer_t *t) { (*(uint32_t *)t->arg)++; }
+
+typedef struct {
+  double start_stop_ns;
+  double fire_ns;
+  uint32_t cascaded;
+} speed_result_t;
+
+static void run_speed(speed_result_t *res) {
+  static timer_wheel_t w;
+  static timer_wheel_timer_t timers[BENCH_TIMERS];
+  uint32_t count = 0;
+  timer_wheel_init(&w, 0);
+  for (uint32_t i = 0; i < BENCH_TIMERS; i++) {
+    timer_wheel_timer_init(&timers[i], count_fire, &count);
+    timer_wheel_start(&w, &timers[i], random_delay(), 0);
+  }
+
+  const uint32_t rounds = 1000000;
+  uint64_t t0 = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    timer_wheel_timer_t *t = &timers[r % BENCH_TIMERS];
+    timer_wheel_stop(&w, t);
+    timer_wheel_start(&w, t, r % (1u << 20), 0);
+  }
+  res->start_stop_ns = (double)(now_ns() - t0) / rounds;
+
+  // Periodic timers at spread out phases, advanced in uneven steps
+  for (uint32_t i = 0; i < BENCH_TIMERS; i++) {
+    timer_wheel_start(&w, &timers[i], i % 1000, 1000 + i % 97);
+  }
+  uint32_t before = w.stats.cascaded;
+  t0 = now_ns();
+  uint64_t now = 0;
+  while (count < 5000000) {
+    now += 1 + rand() % 50;
+    timer_wheel_advance(&w, now);
+  }
+  res->fire_ns = (double)(now_ns() - t0) / count;
+  res->cascaded = w.stats.cascaded - before;
+}
+
+// A day of the watch's periodic work, in ms
+typedef struct {
+  const char *name;
+  uint32_t period;
+  uint32_t phase;
+} watch_source_t;
+
+// Polls start on a whole second so they share the clock's wakeup
+static const watch_source_t s_watch[] = {
+    {"clock", 1000, 0},             // seconds hand
+    {"pomodoro", 25 * 60000, 7000}, // W-POM-1 work interval
+    {"battery", 60000, 1000},       // status polls
+    {"steps", 30000, 2000},
+    {"phone", 15000, 3000},
+    {"wifi", 10000, 4000},
+};
+#define WATCH_SOURCES (sizeof(s_watch) / sizeof(s_watch[0]))
+
+typedef struct {
+  uint64_t wheel_wakeups;
+  uint64_t task_wakeups;
+  uint32_t fired;
+} watch_result_t;
+
+static void run_watch_day(watch_result_t *res) {
+  static timer_wheel_t w;
+  timer_wheel_timer_t timers[WATCH_SOURCES];
+  uint32_t fired = 0;
+  const uint64_t day = 24ull * 3600 * 1000;
+  timer_wheel_init(&w, 0);
+  res->task_wakeups = 0;
+  for (uint32_t i = 0; i < WATCH_SOURCES; i++) {
+    timer_wheel_timer_init(&timers[i], count_fire, &fired);
+    timer_wheel_start(&w, &timers[i], s_watch[i].phase, s_watch[i].period);
+    // vTaskDelay loop: wakes once per period whatever the others do
+    res->task_wakeups += (day - s_watch[i].phase) / s_watch[i].period + 1;
+  }
+  // One esp_timer armed for the next deadline: a wakeup per distinct one
+  res->wheel_wakeups = 0;
+  uint64_t next;
+  while (timer_wheel_next(&w, &next) && next <= day) {
+    timer_wheel_advance(&w, next);
+    res->wheel_wakeups++;
+  }
+  res->fired = fired;
+}
+
+int main(int argc, char **argv) {
+  long ops = 500000;
+  unsigned seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--ops") && i + 1 < argc) {
+      ops = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else {
+      fprintf(stderr, "usage: %s [--ops N] [--seed S]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  srand(seed);
+  uint64_t fires_checked = 0;
+  uint32_t mismatches = run_model(ops, &fires_checked);
+  speed_result_t speed;
+  run_speed(&speed);
+  watch_result_t watch;
+  run_watch_day(&watch);
+
+  printf("{\"model_ops\":%ld,\"model_fires\":%llu,\"mismatches\":%u,"
+         "\"start_stop_ns\":%.1f,\"fire_ns\":%.1f,\"cascaded\":%u,"
+         "\"watch_sources\":%u,\"watch_fired\":%u,"
+         "\"wheel_wakeups_per_day\":%llu,\"task_wakeups_per_day\":%llu,"
+         "\"ok\":%s}\n",
+         ops, (unsigned long long)fires_checked, mismatches,
+         speed.start_stop_ns, speed.fire_ns, speed.cascaded,
+         (unsigned)WATCH_SOURCES, watch.fired,
+         (unsigned long long)watch.wheel_wakeups,
+         (unsigned long long)watch.task_wakeups,
+         mismatches ? "false" : "true");
+  return mismatches ? 1 : 0;
+}
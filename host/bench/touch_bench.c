@@ -0,0 +1,352 @@
+/*
+ * Runs a synthetic noisy swipe through the touch filter and the touch event
+ * ring. Reports filter error against the true path, filter cost per sample,
+ * and whether a producer thread and a consumer thread hand over every event
+ * in order through the ring. Then solves random panel calibrations in Q16,
+ * composed with each display rotation, and reports their worst error and
+ * cost per sample against a double-precision reference. Prints one JSON
+ * object.
+ *
+ * usage: touch_bench [--samples N] [--seed S]
+ */
+#include "config.h"
+#include "touch_cal.h"
+#include "touch_filter.h"
+#include "touch_ring.h"
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Resistive panel noise, in pixels, and one wild sample in this many
+#define NOISE_PX 3.0
+#define SPIKE_EVERY 25
+#define SPIKE_PX 60
+#define RING_EVENTS 2000000
+#define CAL_PANELS 1000
+// Integer outputs against the exact point: rounding alone is 0.5 px per axis
+#define CAL_MAX_ERR_PX 1.0
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static double gauss(void) {
+  double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+  double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+  return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static uint16_t clamp_px(double v, int max) {
+  return v < 0 ? 0 : v > max - 1 ? max - 1 : (uint16_t)lround(v);
+}
+
+typedef struct {
+  double raw_rms;
+  double raw_max;
+  double filtered_rms;
+  double filtered_max;
+  double lag_px; // filtered distance behind the true point, along the swipe
+  double ns_per_sample;
+} filter_result_t;
+
+// Left to right swipe across the panel, one sample per TOUCH_SAMPLE_PERIOD_MS
+static void run_filter(int samples, filter_result_t *res) {
+  uint16_t *raw = malloc(samples * 2 * sizeof(uint16_t));
+  double *truth = malloc(samples * 2 * sizeof(double));
+  for (int i = 0; i < samples; i++) {
+    double t = (double)i / (samples - 1);
+    truth[2 * i] = 10 + t * (EXAMPLE_LCD_H_RES - 20);
+    truth[2 * i + 1] = EXAMPLE_LCD_V_RES / 2 + 20 * sin(t * M_PI);
+    double nx = gauss() * NOISE_PX;
+    double ny = gauss() * NOISE_PX;
+    if (i % SPIKE_EVERY == SPIKE_EVERY - 1) {
+      nx += SPIKE_PX;
+      ny -= SPIKE_PX;
+    }
+    raw[2 * i] = clamp_px(truth[2 * i] + nx, EXAMPLE_LCD_H_RES);
+    raw[2 * i + 1] = clamp_px(truth[2 * i + 1] + ny, EXAMPLE_LCD_V_RES);
+  }
+
+  touch_filter_t f;
+  touch_filter_init(&f, TOUCH_FILTER_ALPHA_Q8);
+  double raw_sq = 0, filt_sq = 0, lag = 0;
+  res->raw_max = res->filtered_max = 0;
+  for (int i = 0; i < samples; i++) {
+    uint16_t fx, fy;
+    touch_filter_push(&f, raw[2 * i], raw[2 * i + 1], &fx, &fy);
+    double rdx = raw[2 * i] - truth[2 * i];
+    double rdy = raw[2 * i + 1] - truth[2 * i + 1];
+    double fdx = fx - truth[2 * i];
+    double fdy = fy - truth[2 * i + 1];
+    double rd = sqrt(rdx * rdx + rdy * rdy);
+    double fd = sqrt(fdx * fdx + fdy * fdy);
+    raw_sq += rd * rd;
+    filt_sq += fd * fd;
+    lag -= fdx;
+    res->raw_max = fmax(res->raw_max, rd);
+    res->filtered_max = fmax(res->filtered_max, fd);
+  }
+  res->raw_rms = sqrt(raw_sq / samples);
+  res->filtered_rms = sqrt(filt_sq / samples);
+  res->lag_px = lag / samples;
+
+  const int reps = 200;
+  volatile uint16_t sink = 0;
+  uint64_t start = now_ns();
+  for (int r = 0; r < reps; r++) {
+    touch_filter_reset(&f);
+    for (int i = 0; i < samples; i++) {
+      uint16_t fx, fy;
+      touch_filter_push(&f, raw[2 * i], raw[2 * i + 1], &fx, &fy);
+      sink ^= fx ^ fy;
+    }
+  }
+  res->ns_per_sample = (double)(now_ns() - start) / reps / samples;
+  free(raw);
+  free(truth);
+}
+
+static touch_ring_t s_ring;
+
+static void *ring_producer(void *arg) {
+  (void)arg;
+  for (uint32_t i = 0; i < RING_EVENTS;) {
+    touch_event_t ev = {.time_us = i, .x = i & 0xffff, .y = i >> 16};
+    // Retry instead of dropping so the consumer can check the sequence
+    if (touch_ring_push(&s_ring, &ev)) {
+      i++;
+    } else {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+// True when every event arrived exactly once and in order
+static bool ring_in_order(double *ns_per_event) {
+  touch_ring_init(&s_ring);
+  pthread_t producer;
+  uint64_t start = now_ns();
+  pthread_create(&producer, NULL, ring_producer, NULL);
+  bool ok = true;
+  for (uint32_t i = 0; i < RING_EVENTS;) {
+    touch_event_t ev;
+    if (!touch_ring_pop(&s_ring, &ev)) {
+      sched_yield();
+      continue;
+    }
+    if (ev.time_us != i || ev.x != (i & 0xffff) || ev.y != (i >> 16)) {
+      ok = false;
+    }
+    i++;
+  }
+  pthread_join(producer, NULL);
+  *ns_per_event = (double)(now_ns() - start) / RING_EVENTS;
+  return ok && touch_ring_empty(&s_ring);
+}
+
+typedef struct {
+  double m[6]; // x' = m0 x + m1 y + m2, y' = m3 x + m4 y + m5
+} ref_cal_t;
+
+static double uniform(double lo, double hi) {
+  return lo + (hi - lo) * rand() / RAND_MAX;
+}
+
+static void ref_apply(const ref_cal_t *r, double x, double y, double *ox,
+                      double *oy) {
+  *ox = r->m[0] * x + r->m[1] * y + r->m[2];
+  *oy = r->m[3] * x + r->m[4] * y + r->m[5];
+}
+
+// The same three-point solve in doubles
+static void ref_solve(const touch_cal_point_t raw[3],
+                      const touch_cal_point_t target[3], ref_cal_t *out) {
+  double x0 = raw[0].x - raw[2].x, y0 = raw[0].y - raw[2].y;
+  double x1 = raw[1].x - raw[2].x, y1 = raw[1].y - raw[2].y;
+  double det = x0 * y1 - x1 * y0;
+  for (int axis = 0; axis < 2; axis++) {
+    double u0 = axis ? target[0].y - target[2].y : target[0].x - target[2].x;
+    double u1 = axis ? target[1].y - target[2].y : target[1].x - target[2].x;
+    double a = (u0 * y1 - u1 * y0) / det;
+    double b = (x0 * u1 - x1 * u0) / det;
+    double t2 = axis ? target[2].y : target[2].x;
+    out->m[3 * axis] = a;
+    out->m[3 * axis + 1] = b;
+    out->m[3 * axis + 2] = t2 - a * raw[2].x - b * raw[2].y;
+  }
+}
+
+// lv_indev's rotation of the unrotated point (x, y)
+static void ref_rotate(int rotation, double x, double y, double *ox,
+                       double *oy) {
+  const double w = EXAMPLE_LCD_H_RES - 1, h = EXAMPLE_LCD_V_RES - 1;
+  switch (rotation) {
+  case 1:
+    *ox = h - y, *oy = x;
+    break;
+  case 2:
+    *ox = w - x, *oy = h - y;
+    break;
+  case 3:
+    *ox = y, *oy = w - x;
+    break;
+  default:
+    *ox = x, *oy = y;
+  }
+}
+
+typedef struct {
+  int panels;
+  int failed; // solves the fixed-point side rejected
+  double max_err_px;
+  double rms_err_px;
+  double ns_per_sample;
+  double float_ns_per_sample;
+} cal_result_t;
+
+/* Panels whose raw axes are scaled, sheared, turned a few degrees and
+ * offset against the display, read at whole pixels like the driver does.
+ * Every calibration is checked over the whole panel in every rotation. */
+static void run_calibration(cal_result_t *res) {
+  const touch_cal_point_t target[3] = {
+      {EXAMPLE_LCD_H_RES / 8, EXAMPLE_LCD_V_RES / 8},
+      {EXAMPLE_LCD_H_RES * 7 / 8, EXAMPLE_LCD_V_RES / 2},
+      {EXAMPLE_LCD_H_RES / 2, EXAMPLE_LCD_V_RES * 7 / 8},
+  };
+  double sq = 0;
+  long points = 0;
+  memset(res, 0, sizeof(*res));
+  res->panels = CAL_PANELS;
+  for (int p = 0; p < CAL_PANELS; p++) {
+    // Display to raw, the inverse of what the calibration recovers
+    double angle = uniform(-5, 5) * M_PI / 180;
+    double sx = uniform(0.8, 1.25), sy = uniform(0.8, 1.25);
+    double shear = uniform(-0.05, 0.05);
+    ref_cal_t panel = {{sx * cos(angle), -sy * sin(angle) + shear,
+                        uniform(-20, 20), sx * sin(angle), sy * cos(angle),
+                        uniform(-20, 20)}};
+    if (p & 1) {
+      // Mirrored axes, like a panel mounted the other way up
+      panel.m[3] = -panel.m[3];
+      panel.m[4] = -panel.m[4];
+      panel.m[5] += EXAMPLE_LCD_V_RES;
+    }
+    touch_cal_point_t raw[3];
+    for (int i = 0; i < 3; i++) {
+      double rx, ry;
+      ref_apply(&panel, target[i].x, target[i].y, &rx, &ry);
+      raw[i] = (touch_cal_point_t){lround(rx), lround(ry)};
+    }
+    touch_cal_t cal;
+    if (!touch_cal_solve(raw, target, &cal)) {
+      res->failed++;
+      continue;
+    }
+    ref_cal_t ref;
+    ref_solve(raw, target, &ref);
+    for (int rot = 0; rot < 4; rot++) {
+      touch_cal_t rotated;
+      touch_cal_rotate(&cal, rot, EXAMPLE_LCD_H_RES, EXAMPLE_LCD_V_RES,
+                       &rotated);
+      for (int y = 0; y < EXAMPLE_LCD_V_RES; y += 7) {
+        for (int x = 0; x < EXAMPLE_LCD_H_RES; x += 7) {
+          double ux, uy, ex, ey;
+          int32_t fx, fy;
+          ref_apply(&ref, x, y, &ux, &uy);
+          ref_rotate(rot, ux, uy, &ex, &ey);
+          touch_cal_apply(&rotated, x, y, &fx, &fy);
+          double err = hypot(fx - ex, fy - ey);
+          res->max_err_px = fmax(res->max_err_px, err);
+          sq += err * err;
+          points++;
+        }
+      }
+    }
+  }
+  res->rms_err_px = points ? sqrt(sq / points) : 0;
+
+  // Cost per sample on a swipe's worth of points, fixed against double
+  enum { N = 4096, REPS = 2000 };
+  static int32_t xs[N], ys[N];
+  for (int i = 0; i < N; i++) {
+    xs[i] = rand() % EXAMPLE_LCD_H_RES;
+    ys[i] = rand() % EXAMPLE_LCD_V_RES;
+  }
+  touch_cal_t cal;
+  ref_cal_t ref;
+  touch_cal_solve((touch_cal_point_t[]){{30, 40}, {210, 160}, {120, 280}},
+                  target, &cal);
+  ref_solve((touch_cal_point_t[]){{30, 40}, {210, 160}, {120, 280}}, target,
+            &ref);
+  volatile int32_t sink = 0;
+  uint64_t start = now_ns();
+  for (int r = 0; r < REPS; r++) {
+    for (int i = 0; i < N; i++) {
+      int32_t ox, oy;
+      touch_cal_apply(&cal, xs[i], ys[i], &ox, &oy);
+      sink ^= ox ^ oy;
+    }
+  }
+  res->ns_per_sample = (double)(now_ns() - start) / REPS / N;
+  volatile double fsink = 0;
+  start = now_ns();
+  for (int r = 0; r < REPS; r++) {
+    for (int i = 0; i < N; i++) {
+      double ox, oy;
+      ref_apply(&ref, xs[i], ys[i], &ox, &oy);
+      fsink += lround(ox) ^ lround(oy);
+    }
+  }
+  res->float_ns_per_sample = (double)(now_ns() - start) / REPS / N;
+}
+
+int main(int argc, char **argv) {
+  int samples = 100;
+  unsigned seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--samples") && i + 1 < argc) {
+      samples = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = (unsigned)atoi(argv[++i]);
+    } else {
+      samples = 0;
+      break;
+    }
+  }
+  if (samples < 2) {
+    fprintf(stderr, "usage: %s [--samples N] [--seed S]\n", argv[0]);
+    return 1;
+  }
+  srand(seed);
+
+  filter_result_t f;
+  run_filter(samples, &f);
+  double ring_ns;
+  bool ring_ok = ring_in_order(&ring_ns);
+  cal_result_t cal;
+  run_calibration(&cal);
+  bool cal_ok = cal.failed == 0 && cal.max_err_px <= CAL_MAX_ERR_PX;
+
+  printf("{\"samples\":%d,\"alpha_q8\":%d,"
+         "\"raw_rms_px\":%.2f,\"raw_max_px\":%.2f,"
+         "\"filtered_rms_px\":%.2f,\"filtered_max_px\":%.2f,"
+         "\"filtered_lag_px\":%.2f,\"filter_ns_per_sample\":%.2f,"
+         "\"ring_events\":%d,\"ring_in_order\":%s,"
+         "\"ring_ns_per_event\":%.2f,"
+         "\"cal\":{\"panels\":%d,\"failed\":%d,\"max_err_px\":%.3f,"
+         "\"rms_err_px\":%.3f,\"ns_per_sample\":%.2f,"
+         "\"float_ns_per_sample\":%.2f}}\n",
+         samples, TOUCH_FILTER_ALPHA_Q8, f.raw_rms, f.raw_max, f.filtered_rms,
+         f.filtered_max, f.lag_px, f.ns_per_sample, RING_EVENTS,
+         ring_ok ? "true" : "false", ring_ns, cal.panels, cal.failed,
+         cal.max_err_px, cal.rms_err_px, cal.ns_per_sample,
+         cal.float_ns_per_sample);
+  return ring_ok && cal_ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/spi_common.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_TIMER_MAX 16
+// Same size as the notif entry of partitions.csv
+#define FAKE_NOTIF_PARTITION_SIZE (64 * 1024)
+
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void *arg;
+  int64_t period_us; // 0 for one-shot
+  int64_t deadline_us;
+  bool active;
+};
+
+static struct esp_timer s_timers[FAKE_TIMER_MAX];
+static size_t s_timer_count;
+static int64_t s_now_us;
+static uint64_t s_gpio_levels;
+static size_t s_dma_free = 160 * 1024;
+
+esp_err_t gpio_config(const gpio_config_t *cfg) {
+  (void)cfg;
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+  if (level) {
+    s_gpio_levels |= 1ULL << gpio_num;
+  } else {
+    s_gpio_levels &= ~(1ULL << gpio_num);
+  }
+  return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+  return (s_gpio_levels >> gpio_num) & 1;
+}
+
+// Backlight PWM, nothing to drive on the host
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf) {
+  (void)timer_conf;
+  return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf) {
+  (void)ledc_conf;
+  return ESP_OK;
+}
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags) {
+  (void)intr_alloc_flags;
+  return ESP_OK;
+}
+
+esp_err_t ledc_set_duty_and_update(ledc_mode_t speed_mode,
+                                   ledc_channel_t channel, uint32_t duty,
+                                   uint32_t hpoint) {
+  (void)speed_mode;
+  (void)channel;
+  (void)duty;
+  (void)hpoint;
+  return ESP_OK;
+}
+
+esp_err_t ledc_set_fade_time_and_start(ledc_mode_t speed_mode,
+                                       ledc_channel_t channel,
+                                       uint32_t target_duty,
+                                       uint32_t max_fade_time_ms,
+                                       ledc_fade_mode_t fade_mode) {
+  (void)speed_mode;
+  (void)channel;
+  (void)target_duty;
+  (void)max_fade_time_ms;
+  (void)fade_mode;
+  return ESP_OK;
+}
+
+esp_err_t ledc_fade_stop(ledc_mode_t speed_mode, ledc_channel_t channel) {
+  (void)speed_mode;
+  (void)channel;
+  return ESP_OK;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id,
+                             const spi_bus_config_t *bus_config,
+                             spi_dma_chan_t dma_chan) {
+  (void)host_id;
+  (void)bus_config;
+  (void)dma_chan;
+  return ESP_OK;
+}
+
+void *spi_bus_dma_memory_alloc(spi_host_device_t host_id, size_t size,
+                               uint32_t extra_heap_caps) {
+  (void)host_id;
+  (void)extra_heap_caps;
+  return aligned_alloc(4, (size + 3) & ~(size_t)3);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+  (void)caps;
+  return s_dma_free;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+  (void)caps;
+  return s_dma_free;
+}
+
+void fake_heap_set_dma_free(size_t free_bytes) { s_dma_free = free_bytes; }
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args,
+                           esp_timer_handle_t *out_handle) {
+  if (s_timer_count >= FAKE_TIMER_MAX) {
+    return ESP_ERR_NO_MEM;
+  }
+  struct esp_timer *timer = &s_timers[s_timer_count++];
+  timer->callback = create_args->callback;
+  timer->arg = create_args->arg;
+  timer->active = false;
+  *out_handle = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  if (timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->period_us = 0;
+  timer->deadline_us = s_now_us + (int64_t)timeout_us;
+  timer->active = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+  if (timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->period_us = (int64_t)period;
+  timer->deadline_us = s_now_us + (int64_t)period;
+  timer->active = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (!timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->active = false;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  timer->active = false;
+  timer->callback = NULL;
+  return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) { return timer->active; }
+
+int64_t esp_timer_get_time(void) { return s_now_us; }
+
+void fake_esp_timer_advance(int64_t us) {
+  const int64_t target = s_now_us + us;
+
+  while (1) {
+    // Fire the earliest due timer first so callbacks observe ordered time
+    struct esp_timer *next = NULL;
+    for (size_t i = 0; i < s_timer_count; i++) {
+      struct esp_timer *t = &s_timers[i];
+      if (t->active && t->callback && t->deadline_us <= target &&
+          (!next || t->deadline_us < next->deadline_us)) {
+        next = t;
+      }
+    }
+    if (!next) {
+      break;
+    }
+    s_now_us = next->deadline_us;
+    if (next->period_us) {
+      next->deadline_us += next->period_us;
+    } else {
+      next->active = false;
+    }
+    next->callback(next->arg);
+  }
+  s_now_us = target;
+}
+
+static const esp_partition_t s_notif_partition = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = 0x41,
+    .address = 0x1b0000,
+    .size = FAKE_NOTIF_PARTITION_SIZE,
+    .erase_size = 4096,
+    .label = "notif",
+};
+static uint8_t *s_notif_flash;
+
+static uint8_t *partition_data(const esp_partition_t *partition) {
+  (void)partition;
+  if (!s_notif_flash) {
+    s_notif_flash = malloc(FAKE_NOTIF_PARTITION_SIZE);
+    memset(s_notif_flash, 0xff, FAKE_NOTIF_PARTITION_SIZE);
+  }
+  return s_notif_flash;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char *label) {
+  (void)subtype;
+  if (type != ESP_PARTITION_TYPE_DATA || !label ||
+      strcmp(label, s_notif_partition.label)) {
+    return NULL;
+  }
+  return &s_notif_partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition,
+                             size_t src_offset, void *dst, size_t size) {
+  if (src_offset + size > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  memcpy(dst, partition_data(partition) + src_offset, size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition,
+                              size_t dst_offset, const void *src, size_t size) {
+  if (dst_offset + size > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  uint8_t *data = partition_data(partition) + dst_offset;
+  const uint8_t *bytes = src;
+  for (size_t i = 0; i < size; i++) {
+    data[i] &= bytes[i];
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition,
+                                    size_t offset, size_t size) {
+  if (offset % partition->erase_size || size % partition->erase_size ||
+      offset + size > partition->size) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(partition_data(partition) + offset, 0xff, size);
+  return ESP_OK;
+}
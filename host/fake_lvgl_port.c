@@ -0,0 +1,12 @@
+#include "lvgl_port.h"
+
+// The host build has no LVGL task: render_bench drives lv_timer_handler
+// itself and the fake panel completes transfers synchronously.
+
+void lvgl_port_add_indev(lv_indev_t *indev) { (void)indev; }
+
+void lvgl_port_wake(void) {}
+
+bool lvgl_port_wake_from_isr(void) { return false; }
+
+bool lvgl_port_flush_done_from_isr(void) { return false; }
@@ -0,0 +1,246 @@
+#include "fake_panel.h"
+#include "esp_lcd_ili9341.h"
+#include "esp_lcd_panel_commands.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Bytes on the wire for one window: CASET + 4 params, RASET + 4 params, RAMWR
+#define FAKE_PANEL_WINDOW_OVERHEAD 11
+// Bytes on the wire for a command with a single parameter (MADCTL, ...)
+#define FAKE_PANEL_CMD_OVERHEAD 2
+
+struct esp_lcd_panel_io_t {
+  unsigned int pclk_hz;
+  esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+  void *user_ctx;
+  // Last CASET/RASET values and whether raw data still lands in RAM
+  int caset[2];
+  int raset[2];
+  bool ram_write;
+};
+
+struct esp_lcd_panel_t {
+  esp_lcd_panel_io_handle_t io;
+  uint32_t bits_per_pixel;
+};
+
+static fake_panel_stats_t s_stats;
+static fake_panel_draw_t s_log[FAKE_PANEL_LOG_LEN];
+static size_t s_log_len;
+static unsigned int s_pclk_hz = 20 * 1000 * 1000;
+
+static void fake_panel_count_cmd(esp_lcd_panel_handle_t panel) {
+  panel->io->ram_write = false;
+  s_stats.cmds++;
+  s_stats.wire_bytes += FAKE_PANEL_CMD_OVERHEAD;
+}
+
+static void fake_panel_log(int x1, int y1, int x2, int y2, size_t bytes,
+                           bool continued) {
+  if (s_log_len < FAKE_PANEL_LOG_LEN) {
+    s_log[s_log_len++] = (fake_panel_draw_t){.x1 = x1,
+                                             .y1 = y1,
+                                             .x2 = x2,
+                                             .y2 = y2,
+                                             .bytes = bytes,
+                                             .continued = continued};
+  }
+  s_stats.draw_calls++;
+  s_stats.bytes += bytes;
+}
+
+static int fake_panel_param16(const void *param, int idx) {
+  const uint8_t *p = param;
+  return (p[idx * 2] << 8) | p[idx * 2 + 1];
+}
+
+esp_err_t esp_lcd_new_panel_io_spi(esp_lcd_spi_bus_handle_t bus,
+                                   const esp_lcd_panel_io_spi_config_t *io_config,
+                                   esp_lcd_panel_io_handle_t *ret_io) {
+  (void)bus;
+  struct esp_lcd_panel_io_t *io = calloc(1, sizeof(*io));
+  if (!io) {
+    return ESP_ERR_NO_MEM;
+  }
+  io->pclk_hz = io_config->pclk_hz;
+  io->on_color_trans_done = io_config->on_color_trans_done;
+  io->user_ctx = io_config->user_ctx;
+  if (io->pclk_hz) {
+    s_pclk_hz = io->pclk_hz;
+  }
+  *ret_io = io;
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd,
+                                    const void *param, size_t param_size) {
+  s_stats.wire_bytes += 1 + param_size;
+  io->ram_write = false;
+  if ((lcd_cmd == LCD_CMD_CASET || lcd_cmd == LCD_CMD_RASET) &&
+      param_size == 4) {
+    int *range = lcd_cmd == LCD_CMD_CASET ? io->caset : io->raset;
+    range[0] = fake_panel_param16(param, 0);
+    range[1] = fake_panel_param16(param, 1);
+  } else {
+    s_stats.cmds++;
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd,
+                                    const void *color, size_t color_size) {
+  (void)color;
+  bool continued;
+  if (lcd_cmd == LCD_CMD_RAMWR) {
+    s_stats.windows++;
+    continued = false;
+  } else if (lcd_cmd == LCD_CMD_RAMWRC) {
+    continued = true;
+  } else if (lcd_cmd < 0) {
+    // Raw data only continues a memory write if nothing else was sent since
+    if (!io->ram_write) {
+      return ESP_ERR_INVALID_STATE;
+    }
+    continued = true;
+  } else {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  s_stats.wire_bytes += (lcd_cmd >= 0) + color_size;
+  io->ram_write = true;
+
+  int width = io->caset[1] - io->caset[0] + 1;
+  int rows = width > 0 ? (int)(color_size / 2 / width) : 0;
+  fake_panel_log(io->caset[0], io->raset[0], io->caset[1] + 1,
+                 io->raset[0] + rows, color_size, continued);
+
+  if (io->on_color_trans_done) {
+    io->on_color_trans_done(io, NULL, io->user_ctx);
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_register_event_callbacks(
+    esp_lcd_panel_io_handle_t io, const esp_lcd_panel_io_callbacks_t *cbs,
+    void *user_ctx) {
+  io->on_color_trans_done = cbs->on_color_trans_done;
+  io->user_ctx = user_ctx;
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io) {
+  free(io);
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_ili9341(
+    const esp_lcd_panel_io_handle_t io,
+    const esp_lcd_panel_dev_config_t *panel_dev_config,
+    esp_lcd_panel_handle_t *ret_panel) {
+  struct esp_lcd_panel_t *panel = calloc(1, sizeof(*panel));
+  if (!panel) {
+    return ESP_ERR_NO_MEM;
+  }
+  panel->io = io;
+  panel->bits_per_pixel = panel_dev_config->bits_per_pixel;
+  *ret_panel = panel;
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel) {
+  fake_panel_count_cmd(panel);
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel) {
+  fake_panel_count_cmd(panel);
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel) {
+  free(panel);
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start,
+                                    int y_start, int x_end, int y_end,
+                                    const void *color_data) {
+  (void)color_data;
+  if (x_start >= x_end || y_start >= y_end) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  size_t bytes = (size_t)(x_end - x_start) * (y_end - y_start) *
+                 panel->bits_per_pixel / 8;
+
+  fake_panel_log(x_start, y_start, x_end, y_end, bytes, false);
+  s_stats.windows++;
+  s_stats.wire_bytes += FAKE_PANEL_WINDOW_OVERHEAD + bytes;
+
+  esp_lcd_panel_io_handle_t io = panel->io;
+  io->caset[0] = x_start;
+  io->caset[1] = x_end - 1;
+  io->raset[0] = y_start;
+  io->raset[1] = y_end - 1;
+  io->ram_write = true;
+  if (io->on_color_trans_done) {
+    io->on_color_trans_done(io, NULL, io->user_ctx);
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x,
+                               bool mirror_y) {
+  (void)mirror_x;
+  (void)mirror_y;
+  fake_panel_count_cmd(panel);
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes) {
+  (void)swap_axes;
+  fake_panel_count_cmd(panel);
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap,
+                                int y_gap) {
+  (void)panel;
+  (void)x_gap;
+  (void)y_gap;
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel,
+                                     bool invert_color_data) {
+  (void)invert_color_data;
+  fake_panel_count_cmd(panel);
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_disp_on_off(esp_lcd_panel_handle_t panel,
+                                    bool on_off) {
+  (void)on_off;
+  fake_panel_count_cmd(panel);
+  return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_disp_sleep(esp_lcd_panel_handle_t panel, bool sleep) {
+  (void)sleep;
+  fake_panel_count_cmd(panel);
+  return ESP_OK;
+}
+
+void fake_panel_get_stats(fake_panel_stats_t *out) { *out = s_stats; }
+
+void fake_panel_reset_stats(void) {
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_log_len = 0;
+}
+
+const fake_panel_draw_t *fake_panel_get_log(size_t *count) {
+  *count = s_log_len;
+  return s_log;
+}
+
+uint64_t fake_panel_bus_time_us(void) {
+  return s_stats.wire_bytes * 8 * 1000000ULL / s_pclk_hz;
+}
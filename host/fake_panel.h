@@ -0,0 +1,37 @@
+#ifndef __FAKE_PANEL_H__
+#define __FAKE_PANEL_H__
+
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+
+// Recording stand-in for the esp_lcd SPI panel IO and the ILI9341 driver.
+// Every esp_lcd_panel_draw_bitmap is logged, and on_color_trans_done fires
+// synchronously before draw_bitmap returns.
+
+#define FAKE_PANEL_LOG_LEN 4096
+
+typedef struct {
+  int x1; // inclusive, panel window the pixels were written into
+  int y1; // inclusive
+  int x2; // exclusive, as passed to esp_lcd_panel_draw_bitmap
+  int y2; // exclusive
+  size_t bytes;
+  bool continued; // appended to the previous RAMWR instead of a new one
+} fake_panel_draw_t;
+
+typedef struct {
+  uint32_t draw_calls; // pixel transfers (draw_bitmap or tx_color)
+  uint32_t windows;    // CASET/RASET/RAMWR window setups
+  uint64_t bytes;      // pixel bytes pushed
+  uint32_t cmds;       // other commands (MADCTL, invert, on/off, ...)
+  uint64_t wire_bytes; // pixel bytes plus command and parameter bytes
+} fake_panel_stats_t;
+
+void fake_panel_get_stats(fake_panel_stats_t *out);
+void fake_panel_reset_stats(void);
+// Draws since the last reset; only the first FAKE_PANEL_LOG_LEN are kept
+const fake_panel_draw_t *fake_panel_get_log(size_t *count);
+// Estimated time the recorded traffic holds the bus at the configured pclk
+uint64_t fake_panel_bus_time_us(void);
+
+#endif //__FAKE_PANEL_H__
@@ -0,0 +1,181 @@
+/*
+ * Fuzz target for the watch-phone packet parser (phone_proto.c). Every input
+ * is one received packet. The parser must stay inside it whatever the bytes
+ * are, and every frame that decodes must encode back to the same payload.
+ *
+ * With clang, -DPHONE_PROTO_FUZZ_LIBFUZZER=ON builds it as a libFuzzer
+ * target with ASan and UBSan. Otherwise it is a standalone driver:
+ *
+ * usage: phone_proto_fuzz FILE...              replay packets
+ *        phone_proto_fuzz --random N [--seed S] mutate valid packets
+ *
+ * corpus/ holds packets that once broke it, replayed as seeds.
+ */
+#include "phone_proto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      abort();                                                                 \
+    }                                                                          \
+  } while (0)
+
+// Decode, re-encode, and compare with the bytes the decoder read
+static void check_roundtrip(const phone_proto_frame_t *f) {
+  uint8_t out[PHONE_PROTO_MAX_PAYLOAD];
+  size_t len = 0;
+  phone_time_sync_t time_sync;
+  phone_steps_t steps;
+  phone_battery_t battery;
+  phone_media_state_t media;
+  phone_media_cmd_t cmd;
+  if (phone_proto_decode_time_sync(f, &time_sync)) {
+    len = phone_proto_encode_time_sync(&time_sync, out, sizeof(out));
+  } else if (phone_proto_decode_steps(f, &steps)) {
+    len = phone_proto_encode_steps(&steps, out, sizeof(out));
+  } else if (phone_proto_decode_battery(f, &battery)) {
+    len = phone_proto_encode_battery(&battery, out, sizeof(out));
+    // Only the charging bit is defined
+    CHECK(len == 2);
+    out[1] |= f->payload[1] & ~1;
+  } else if (phone_proto_decode_media_state(f, &media)) {
+    const uint8_t *end = f->payload + f->len;
+    CHECK((const uint8_t *)media.title + media.title_len <= end);
+    CHECK((const uint8_t *)media.artist + media.artist_len <= end);
+    len = phone_proto_encode_media_state(&media, out, sizeof(out));
+    CHECK(len > 0);
+    out[0] |= f->payload[0] & ~1;
+  } else if (phone_proto_decode_media_cmd(f, &cmd)) {
+    len = phone_proto_encode_media_cmd(cmd, out, sizeof(out));
+  } else {
+    return;
+  }
+  // Fields a newer peer appended are not re-encoded
+  CHECK(len > 0 && len <= f->len);
+  CHECK(memcmp(out, f->payload, len) == 0);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  phone_proto_reader_t r;
+  phone_proto_reader_init(&r, data, size);
+  phone_proto_frame_t f;
+  phone_proto_err_t err;
+  size_t frames = 0;
+  while ((err = phone_proto_next(&r, &f)) == PHONE_PROTO_OK ||
+         err == PHONE_PROTO_ERR_VERSION) {
+    CHECK(f.payload >= data && f.payload + f.len <= data + size);
+    CHECK(++frames <= size / PHONE_PROTO_FRAME_OVERHEAD);
+    if (err == PHONE_PROTO_OK) {
+      check_roundtrip(&f);
+    }
+  }
+  CHECK(err < PHONE_PROTO_ERR_COUNT);
+  CHECK(phone_proto_next(&r, &f) == PHONE_PROTO_END);
+  return 0;
+}
+
+#ifndef PHONE_PROTO_LIBFUZZER
+
+static int replay(int argc, char **argv) {
+  static uint8_t buf[1 << 16];
+  for (int i = 1; i < argc; i++) {
+    FILE *f = fopen(argv[i], "rb");
+    if (!f) {
+      perror(argv[i]);
+      return 1;
+    }
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(buf, n);
+  }
+  printf("{\"inputs\":%d}\n", argc - 1);
+  return 0;
+}
+
+/* One well-formed frame with a payload past PHONE_PROTO_MAX_PAYLOAD, which
+ * no writer produces but a peer may send */
+static size_t oversized_packet(uint8_t *packet) {
+  size_t len = PHONE_PROTO_MAX_PAYLOAD + 1 +
+               rand() % (PHONE_PROTO_MAX_MTU - PHONE_PROTO_MAX_PAYLOAD -
+                         PHONE_PROTO_FRAME_OVERHEAD);
+  size_t frame_len = len + PHONE_PROTO_FRAME_OVERHEAD;
+  packet[0] = frame_len;
+  packet[1] = frame_len >> 8;
+  packet[2] = PHONE_PROTO_VERSION;
+  packet[3] = PHONE_MSG_MEDIA_STATE;
+  for (size_t j = 0; j < len; j++) {
+    packet[4 + j] = rand();
+  }
+  uint16_t crc = phone_proto_crc16(0xffff, packet, 4 + len);
+  packet[4 + len] = crc;
+  packet[5 + len] = crc >> 8;
+  return frame_len;
+}
+
+// A packet of random valid frames, then a few random byte edits
+static size_t random_packet(uint8_t *packet) {
+  if (rand() % 16 == 0) {
+    return oversized_packet(packet);
+  }
+  phone_proto_writer_t w;
+  phone_proto_writer_init(&w, packet, PHONE_PROTO_DEFAULT_MTU);
+  uint8_t payload[PHONE_PROTO_MAX_PAYLOAD];
+  int frames = rand() % 8;
+  for (int i = 0; i < frames; i++) {
+    uint8_t type = rand() % (PHONE_MSG_TYPE_COUNT + 1);
+    size_t len = rand() % 48;
+    for (size_t j = 0; j < len; j++) {
+      payload[j] = rand();
+    }
+    if (type == PHONE_MSG_MEDIA_STATE && len >= 7) {
+      // Mostly consistent string lengths, so decoding gets exercised
+      payload[5] = rand() % (len - 6);
+      payload[6 + payload[5]] = len - 7 - payload[5];
+    }
+    phone_proto_write(&w, type, payload, len);
+  }
+  int edits = rand() % 4;
+  for (int i = 0; i < edits && w.len > 0; i++) {
+    packet[rand() % w.len] = rand();
+  }
+  if (rand() % 8 == 0 && w.len > 0) {
+    w.len = rand() % w.len;
+  }
+  return w.len;
+}
+
+int main(int argc, char **argv) {
+  long iterations = 0;
+  unsigned seed = 1;
+  if (argc >= 3 && !strcmp(argv[1], "--random")) {
+    iterations = atol(argv[2]);
+    if (argc == 5 && !strcmp(argv[3], "--seed")) {
+      seed = strtoul(argv[4], NULL, 0);
+    } else if (argc != 3) {
+      iterations = 0;
+    }
+  } else if (argc > 1 && argv[1][0] != '-') {
+    return replay(argc, argv);
+  }
+  if (iterations <= 0) {
+    fprintf(stderr,
+            "usage: %s FILE...\n"
+            "       %s --random N [--seed S]\n",
+            argv[0], argv[0]);
+    return 1;
+  }
+
+  srand(seed);
+  uint8_t packet[PHONE_PROTO_MAX_MTU];
+  for (long i = 0; i < iterations; i++) {
+    LLVMFuzzerTestOneInput(packet, random_packet(packet));
+  }
+  printf("{\"iterations\":%ld,\"seed\":%u}\n", iterations, seed);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+// Host build LVGL configuration. Mirrors the Kconfig values the firmware gets
+// from the ESP-IDF LVGL component plus sdkconfig.defaults, so render cost
+// measured here matches what runs on the ESP32-C6.
+
+#define LV_COLOR_DEPTH 16
+
+#define LV_USE_STDLIB_MALLOC LV_STDLIB_CUSTOM
+#define LV_USE_STDLIB_STRING LV_STDLIB_BUILTIN
+#define LV_USE_STDLIB_SPRINTF LV_STDLIB_BUILTIN
+
+#define LV_DEF_REFR_PERIOD 33
+#define LV_DPI_DEF 130
+
+#define LV_USE_OS LV_OS_NONE
+#define LV_USE_DRAW_SW 1
+#define LV_USE_LOG 0
+
+#define LV_FONT_MONTSERRAT_14 1
+#define LV_FONT_DEFAULT &lv_font_montserrat_14
+
+#define LV_USE_OBSERVER 1
+#define LV_USE_SYSMON 1
+
+#endif // LV_CONF_H
@@ -0,0 +1,52 @@
+#include "phone_loopback.h"
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int loopback_send(void *ctx, const void *packet, size_t len) {
+  phone_loopback_end_t *e = ctx;
+  ssize_t n;
+  do {
+    n = send(e->fd, packet, len, MSG_NOSIGNAL);
+  } while (n < 0 && errno == EINTR);
+  if (n != (ssize_t)len) {
+    return n < 0 ? -errno : -EMSGSIZE;
+  }
+  e->packets_sent++;
+  e->bytes_sent += len;
+  return 0;
+}
+
+int phone_loopback_open(phone_loopback_t *lb) {
+  int fd[2];
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fd) != 0) {
+    return -1;
+  }
+  for (int i = 0; i < 2; i++) {
+    lb->end[i] = (phone_loopback_end_t){.fd = fd[i]};
+  }
+  return 0;
+}
+
+void phone_loopback_close(phone_loopback_t *lb) {
+  close(lb->end[0].fd);
+  close(lb->end[1].fd);
+}
+
+phone_proto_transport_t phone_loopback_transport(phone_loopback_t *lb, int end,
+                                                 uint16_t mtu) {
+  return (phone_proto_transport_t){
+      .send = loopback_send,
+      .ctx = &lb->end[end],
+      .mtu = mtu,
+  };
+}
+
+ssize_t phone_loopback_recv(phone_loopback_t *lb, int end, void *buf,
+                            size_t cap) {
+  ssize_t n;
+  do {
+    n = recv(lb->end[end].fd, buf, cap, 0);
+  } while (n < 0 && errno == EINTR);
+  return n;
+}
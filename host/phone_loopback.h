@@ -0,0 +1,33 @@
+#ifndef __PHONE_LOOPBACK_H__
+#define __PHONE_LOOPBACK_H__
+
+#include "phone_proto.h"
+#include <sys/types.h>
+
+// Linux stand-in for the BLE link: a SOCK_SEQPACKET socket pair, so packets
+// keep their boundaries like notifications do. end[0] is the watch, end[1]
+// the phone.
+
+typedef struct {
+  int fd;
+  uint64_t packets_sent;
+  uint64_t bytes_sent;
+} phone_loopback_end_t;
+
+typedef struct {
+  phone_loopback_end_t end[2];
+} phone_loopback_t;
+
+// Returns 0, or -1 with errno set
+int phone_loopback_open(phone_loopback_t *lb);
+void phone_loopback_close(phone_loopback_t *lb);
+
+// Transport that sends from one end of the pair to the other
+phone_proto_transport_t phone_loopback_transport(phone_loopback_t *lb, int end,
+                                                 uint16_t mtu);
+
+// Blocking read of one packet at the given end, 0 once the other end closes
+ssize_t phone_loopback_recv(phone_loopback_t *lb, int end, void *buf,
+                            size_t cap);
+
+#endif //__PHONE_LOOPBACK_H__
@@ -0,0 +1,35 @@
+#ifndef __HOST_DRIVER_SPI_COMMON_H__
+#define __HOST_DRIVER_SPI_COMMON_H__
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  SPI1_HOST = 0,
+  SPI2_HOST = 1,
+} spi_host_device_t;
+
+typedef enum {
+  SPI_DMA_DISABLED = 0,
+  SPI_DMA_CH_AUTO = 3,
+} spi_dma_chan_t;
+
+typedef struct {
+  int mosi_io_num;
+  int miso_io_num;
+  int sclk_io_num;
+  int quadwp_io_num;
+  int quadhd_io_num;
+  int max_transfer_sz;
+  uint32_t flags;
+  int intr_flags;
+} spi_bus_config_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id,
+                             const spi_bus_config_t *bus_config,
+                             spi_dma_chan_t dma_chan);
+void *spi_bus_dma_memory_alloc(spi_host_device_t host_id, size_t size,
+                               uint32_t extra_heap_caps);
+
+#endif //__HOST_DRIVER_SPI_COMMON_H__
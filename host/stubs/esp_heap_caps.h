@@ -0,0 +1,18 @@
+#ifndef __HOST_ESP_HEAP_CAPS_H__
+#define __HOST_ESP_HEAP_CAPS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+// Reports the figures set with fake_heap_set_dma_free(), defaults to what a
+// C6 typically has left after Wi-Fi init
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+void fake_heap_set_dma_free(size_t free_bytes);
+
+#endif //__HOST_ESP_HEAP_CAPS_H__
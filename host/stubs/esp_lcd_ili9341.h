@@ -0,0 +1,13 @@
+#ifndef __HOST_ESP_LCD_ILI9341_H__
+#define __HOST_ESP_LCD_ILI9341_H__
+
+#include "esp_lcd_panel_dev.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+
+esp_err_t esp_lcd_new_panel_ili9341(
+    const esp_lcd_panel_io_handle_t io,
+    const esp_lcd_panel_dev_config_t *panel_dev_config,
+    esp_lcd_panel_handle_t *ret_panel);
+
+#endif //__HOST_ESP_LCD_ILI9341_H__
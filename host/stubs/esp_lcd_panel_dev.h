@@ -0,0 +1,20 @@
+#ifndef __HOST_ESP_LCD_PANEL_DEV_H__
+#define __HOST_ESP_LCD_PANEL_DEV_H__
+
+#include "esp_lcd_types.h"
+
+typedef struct {
+  int reset_gpio_num;
+  union {
+    lcd_rgb_element_order_t color_space;
+    lcd_rgb_element_order_t rgb_ele_order;
+  };
+  lcd_rgb_data_endian_t data_endian;
+  uint32_t bits_per_pixel;
+  struct {
+    uint32_t reset_active_high : 1;
+  } flags;
+  void *vendor_config;
+} esp_lcd_panel_dev_config_t;
+
+#endif //__HOST_ESP_LCD_PANEL_DEV_H__
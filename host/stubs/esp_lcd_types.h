@@ -0,0 +1,22 @@
+#ifndef __HOST_ESP_LCD_TYPES_H__
+#define __HOST_ESP_LCD_TYPES_H__
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct esp_lcd_panel_io_t *esp_lcd_panel_io_handle_t;
+typedef struct esp_lcd_panel_t *esp_lcd_panel_handle_t;
+
+typedef enum {
+  LCD_RGB_ELEMENT_ORDER_RGB,
+  LCD_RGB_ELEMENT_ORDER_BGR,
+} lcd_rgb_element_order_t;
+
+typedef enum {
+  LCD_RGB_DATA_ENDIAN_BIG = 0,
+  LCD_RGB_DATA_ENDIAN_LITTLE,
+} lcd_rgb_data_endian_t;
+
+#endif //__HOST_ESP_LCD_TYPES_H__
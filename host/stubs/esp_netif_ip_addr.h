@@ -0,0 +1,29 @@
+#ifndef __HOST_ESP_NETIF_IP_ADDR_H__
+#define __HOST_ESP_NETIF_IP_ADDR_H__
+
+#include <stdint.h>
+
+// The IPv4 address type and print macros, as ESP-IDF defines them
+typedef struct {
+  uint32_t addr;
+} esp_ip4_addr_t;
+
+#define esp_ip4_addr_get_byte(ipaddr, idx)                                     \
+  (((const uint8_t *)(&(ipaddr)->addr))[idx])
+#define esp_ip4_addr1(ipaddr) esp_ip4_addr_get_byte(ipaddr, 0)
+#define esp_ip4_addr2(ipaddr) esp_ip4_addr_get_byte(ipaddr, 1)
+#define esp_ip4_addr3(ipaddr) esp_ip4_addr_get_byte(ipaddr, 2)
+#define esp_ip4_addr4(ipaddr) esp_ip4_addr_get_byte(ipaddr, 3)
+
+#define esp_ip4_addr1_16(ipaddr) ((uint16_t)esp_ip4_addr1(ipaddr))
+#define esp_ip4_addr2_16(ipaddr) ((uint16_t)esp_ip4_addr2(ipaddr))
+#define esp_ip4_addr3_16(ipaddr) ((uint16_t)esp_ip4_addr3(ipaddr))
+#define esp_ip4_addr4_16(ipaddr) ((uint16_t)esp_ip4_addr4(ipaddr))
+
+#define IP2STR(ipaddr)                                                         \
+  esp_ip4_addr1_16(ipaddr), esp_ip4_addr2_16(ipaddr),                          \
+      esp_ip4_addr3_16(ipaddr), esp_ip4_addr4_16(ipaddr)
+
+#define IPSTR "%d.%d.%d.%d"
+
+#endif //__HOST_ESP_NETIF_IP_ADDR_H__
@@ -0,0 +1,18 @@
+#ifndef __HOST_SDKCONFIG_H__
+#define __HOST_SDKCONFIG_H__
+
+// Host stand-in for the generated sdkconfig.h. Mirrors sdkconfig.defaults for
+// the options the display/UI sources look at.
+#define CONFIG_EXAMPLE_LCD_CONTROLLER_ILI9341 1
+#define CONFIG_EXAMPLE_LCD_MIRROR_Y 1
+#define CONFIG_EXAMPLE_LCD_RGB565_SWAP_WORDS 1
+#define CONFIG_EXAMPLE_LCD_FLUSH_TILE_SKIP 1
+#define CONFIG_EXAMPLE_LVGL_DRAW_BUF_COUNT_MAX 3
+#define CONFIG_EXAMPLE_LVGL_DRAW_BUF_LINES_MIN 10
+#define CONFIG_EXAMPLE_LVGL_DRAW_BUF_LINES_MAX 40
+#define CONFIG_EXAMPLE_LVGL_DRAW_BUF_HEAP_PERCENT 25
+#define CONFIG_EXAMPLE_LVGL_DRAW_BUF_HEAP_RESERVE_KB 48
+#define CONFIG_EXAMPLE_LVGL_DRAW_BUF_PREFER_COUNT 1
+#define CONFIG_FREERTOS_HZ 100
+
+#endif //__HOST_SDKCONFIG_H__
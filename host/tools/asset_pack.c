@@ -0,0 +1,297 @@
+/*
+ * Packs PNGs into the "assets" partition blob (asset_pack.h), converted to the
+ * pixel format LVGL draws from, and verifies existing blobs.
+ *
+ * The manifest has one asset per line, '#' starts a comment, paths are
+ * relative to the manifest:
+ *   <name> <rgb565|rgb565-swapped|rgb565a8|a8> <file.png>
+ *
+ * a8 takes the PNG's alpha channel, or its luminance when it has none, so
+ * pre-rasterised glyph sheets and icons can be drawn recoloured.
+ *
+ * usage: asset_pack -o assets.bin [--max-size BYTES] manifest.txt
+ *        asset_pack --verify assets.bin
+ */
+#include "asset_pack.h"
+#include <errno.h>
+#include <libgen.h>
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ASSETS 256
+
+typedef struct {
+  asset_entry_t entry;
+  uint8_t *data;
+} packed_asset_t;
+
+static packed_asset_t s_assets[MAX_ASSETS];
+static uint32_t s_count;
+
+static uint16_t rgb565(const uint8_t *px) {
+  return (uint16_t)(((px[0] >> 3) << 11) | ((px[1] >> 2) << 5) | (px[2] >> 3));
+}
+
+static bool parse_format(const char *s, asset_format_t *out) {
+  for (int f = 0; f < ASSET_FORMAT_COUNT; f++) {
+    if (!strcmp(s, asset_format_names[f])) {
+      *out = f;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Decode to RGBA8888 and convert; returns false with a message on stderr */
+static bool convert_png(const char *path, asset_format_t format,
+                        packed_asset_t *out) {
+  png_image image = {.version = PNG_IMAGE_VERSION};
+  if (!png_image_begin_read_from_file(&image, path)) {
+    fprintf(stderr, "%s: %s\n", path, image.message);
+    return false;
+  }
+  bool has_alpha = image.format & PNG_FORMAT_FLAG_ALPHA;
+  image.format = PNG_FORMAT_RGBA;
+  if (image.width > UINT16_MAX || image.height > UINT16_MAX) {
+    fprintf(stderr, "%s: %ux%u is too large\n", path, image.width,
+            image.height);
+    png_image_free(&image);
+    return false;
+  }
+  uint8_t *rgba = malloc(PNG_IMAGE_SIZE(image));
+  if (!rgba || !png_image_finish_read(&image, NULL, rgba, 0, NULL)) {
+    fprintf(stderr, "%s: %s\n", path, rgba ? image.message : "out of memory");
+    free(rgba);
+    return false;
+  }
+
+  uint32_t w = image.width;
+  uint32_t h = image.height;
+  uint32_t px = w * h;
+  uint32_t size = asset_pack_data_size(format, w, h);
+  uint8_t *data = malloc(size);
+  for (uint32_t i = 0; i < px; i++) {
+    const uint8_t *p = &rgba[i * 4];
+    uint16_t c = rgb565(p);
+    switch (format) {
+    case ASSET_FORMAT_RGB565:
+      data[i * 2] = c & 0xff;
+      data[i * 2 + 1] = c >> 8;
+      break;
+    case ASSET_FORMAT_RGB565_SWAPPED:
+      data[i * 2] = c >> 8;
+      data[i * 2 + 1] = c & 0xff;
+      break;
+    case ASSET_FORMAT_RGB565A8:
+      data[i * 2] = c & 0xff;
+      data[i * 2 + 1] = c >> 8;
+      data[px * 2 + i] = p[3];
+      break;
+    case ASSET_FORMAT_A8:
+      // Rec. 601 luma for opaque sources
+      data[i] = has_alpha ? p[3] : (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8;
+      break;
+    default:
+      break;
+    }
+  }
+  free(rgba);
+
+  out->data = data;
+  out->entry.width = w;
+  out->entry.height = h;
+  out->entry.stride = asset_pack_stride(format, w);
+  out->entry.format = format;
+  out->entry.size = size;
+  out->entry.crc = asset_pack_crc32(0, data, size);
+  return true;
+}
+
+static bool load_manifest(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  char *path_copy = strdup(path);
+  const char *dir = dirname(path_copy);
+  char line[512];
+  int lineno = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f)) {
+    lineno++;
+    char *hash = strchr(line, '#');
+    if (hash) {
+      *hash = '\0';
+    }
+    char name[64], format_name[32], file[400];
+    int n = sscanf(line, "%63s %31s %399s", name, format_name, file);
+    if (n <= 0) {
+      continue;
+    }
+    asset_format_t format;
+    if (n != 3 || !parse_format(format_name, &format) ||
+        strlen(name) >= ASSET_NAME_LEN) {
+      fprintf(stderr,
+              "%s:%d: expected <name> <format> <file>, names up to %d "
+              "chars\n",
+              path, lineno, ASSET_NAME_LEN - 1);
+      ok = false;
+      break;
+    }
+    for (uint32_t i = 0; i < s_count; i++) {
+      if (!strcmp(s_assets[i].entry.name, name)) {
+        fprintf(stderr, "%s:%d: duplicate asset %s\n", path, lineno, name);
+        ok = false;
+      }
+    }
+    if (ok && s_count == MAX_ASSETS) {
+      fprintf(stderr, "%s:%d: more than %d assets\n", path, lineno,
+              MAX_ASSETS);
+      ok = false;
+    }
+    if (!ok) {
+      break;
+    }
+    char full[1024];
+    snprintf(full, sizeof(full), "%s/%s", dir, file);
+    packed_asset_t *a = &s_assets[s_count];
+    memset(a, 0, sizeof(*a));
+    strcpy(a->entry.name, name);
+    ok = convert_png(file[0] == '/' ? file : full, format, a);
+    s_count += ok;
+  }
+  free(path_copy);
+  fclose(f);
+  return ok;
+}
+
+static int pack(const char *out_path, const char *manifest, long max_size) {
+  if (!load_manifest(manifest)) {
+    return 1;
+  }
+
+  uint32_t offset =
+      sizeof(asset_pack_header_t) + s_count * sizeof(asset_entry_t);
+  for (uint32_t i = 0; i < s_count; i++) {
+    offset = (offset + ASSET_DATA_ALIGN - 1) & ~(ASSET_DATA_ALIGN - 1);
+    s_assets[i].entry.offset = offset;
+    offset += s_assets[i].entry.size;
+  }
+  uint32_t total = offset;
+  if (max_size > 0 && total > max_size) {
+    fprintf(stderr, "%u bytes do not fit the %ld byte partition\n", total,
+            max_size);
+    return 1;
+  }
+
+  uint8_t *blob = calloc(1, total);
+  asset_entry_t *entries =
+      (asset_entry_t *)(blob + sizeof(asset_pack_header_t));
+  for (uint32_t i = 0; i < s_count; i++) {
+    entries[i] = s_assets[i].entry;
+    memcpy(blob + entries[i].offset, s_assets[i].data, entries[i].size);
+    free(s_assets[i].data);
+  }
+  asset_pack_header_t hdr = {
+      .magic = ASSET_PACK_MAGIC,
+      .version = ASSET_PACK_VERSION,
+      .count = s_count,
+      .total_size = total,
+      .index_crc = asset_pack_crc32(0, entries, s_count * sizeof(*entries)),
+  };
+  memcpy(blob, &hdr, sizeof(hdr));
+
+  // Read back what the device will see before writing anything
+  uint32_t bad = 0;
+  asset_pack_err_t err = asset_pack_check(blob, total, true, &bad);
+  if (err != ASSET_PACK_OK) {
+    fprintf(stderr, "packed blob fails verification: %s\n",
+            asset_pack_err_names[err]);
+    free(blob);
+    return 1;
+  }
+
+  FILE *f = fopen(out_path, "wb");
+  if (!f || fwrite(blob, 1, total, f) != total || fclose(f) != 0) {
+    fprintf(stderr, "%s: %s\n", out_path, strerror(errno));
+    free(blob);
+    return 1;
+  }
+  free(blob);
+  printf("{\"assets\":%u,\"bytes\":%u}\n", s_count, total);
+  return 0;
+}
+
+static int verify(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return 1;
+  }
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *blob = malloc(len > 0 ? len : 1);
+  size_t got = fread(blob, 1, len, f);
+  fclose(f);
+
+  uint32_t bad = 0;
+  asset_pack_err_t err = asset_pack_check(blob, got, true, &bad);
+  printf("{\"file_bytes\":%zu,\"ok\":%s,\"error\":\"%s\"", got,
+         err == ASSET_PACK_OK ? "true" : "false", asset_pack_err_names[err]);
+  if (err == ASSET_PACK_ERR_ENTRY || err == ASSET_PACK_ERR_DATA_CRC) {
+    printf(",\"bad_entry\":%u", bad);
+  }
+  if (err == ASSET_PACK_OK) {
+    const asset_pack_header_t *hdr = (const asset_pack_header_t *)blob;
+    const asset_entry_t *entries = asset_pack_entries(blob);
+    printf(",\"bytes\":%u,\"entries\":[", hdr->total_size);
+    for (uint32_t i = 0; i < hdr->count; i++) {
+      const asset_entry_t *e = &entries[i];
+      printf("%s{\"name\":\"%s\",\"format\":\"%s\",\"width\":%u,"
+             "\"height\":%u,\"offset\":%u,\"size\":%u}",
+             i ? "," : "", e->name, asset_format_names[e->format], e->width,
+             e->height, e->offset, e->size);
+    }
+    printf("]");
+  }
+  printf("}\n");
+  free(blob);
+  return err == ASSET_PACK_OK ? 0 : 1;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s -o assets.bin [--max-size BYTES] manifest.txt\n"
+          "       %s --verify assets.bin\n",
+          prog, prog);
+}
+
+int main(int argc, char **argv) {
+  const char *out = NULL;
+  const char *manifest = NULL;
+  long max_size = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--verify") && i + 1 < argc && argc == 3) {
+      return verify(argv[++i]);
+    } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+      out = argv[++i];
+    } else if (!strcmp(argv[i], "--max-size") && i + 1 < argc) {
+      // Accepts the partition table's 0x notation
+      max_size = strtol(argv[++i], NULL, 0);
+    } else if (!manifest && argv[i][0] != '-') {
+      manifest = argv[i];
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (!out || !manifest) {
+    usage(argv[0]);
+    return 1;
+  }
+  return pack(out, manifest, max_size);
+}
@@ -0,0 +1,87 @@
+/*
+ * Builds the DLOGx macros as the firmware does with
+ * CONFIG_EXAMPLE_DEFERRED_LOG, where the host build otherwise maps them to
+ * ESP_LOGx, and checks the words they hand to dlog_write(): argument count,
+ * wide mask and values, including argument lists that come from macros like
+ * IP2STR. Mistakes in the macros mostly fail to compile here; the rest exit
+ * non-zero.
+ *
+ * usage: dlog_check
+ */
+#include "dlog.h"
+#include "esp_netif_ip_addr.h"
+#include <stdio.h>
+
+static const char *TAG = "dlog_check";
+
+static struct {
+  esp_log_level_t level;
+  const char *fmt;
+  uint32_t wide;
+  uint32_t nargs;
+  uint64_t args[DLOG_MAX_WORDS];
+} s_last;
+
+static int s_failures;
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                uint32_t wide, uint32_t nargs, const uint64_t *args) {
+  (void)tag;
+  s_last.level = level;
+  s_last.fmt = fmt;
+  s_last.wide = wide;
+  s_last.nargs = nargs;
+  for (uint32_t i = 0; i < nargs && i < DLOG_MAX_WORDS; i++) {
+    s_last.args[i] = args[i];
+  }
+}
+
+static void expect(const char *what, uint32_t wide, uint32_t nargs,
+                   const uint64_t *args) {
+  int ok = s_last.wide == wide && s_last.nargs == nargs;
+  for (uint32_t i = 0; ok && i < nargs; i++) {
+    ok = s_last.args[i] == args[i];
+  }
+  if (!ok) {
+    fprintf(stderr, "%s: got nargs %u wide 0x%x\n", what,
+            (unsigned)s_last.nargs, (unsigned)s_last.wide);
+    s_failures++;
+  }
+}
+
+int main(void) {
+  esp_ip4_addr_t ip = {0};
+  uint8_t *octets = (uint8_t *)&ip.addr;
+  octets[0] = 192;
+  octets[1] = 168;
+  octets[2] = 4;
+  octets[3] = 17;
+
+  DLOGI(TAG, "no arguments");
+  expect("none", 0, 0, NULL);
+
+  DLOGW(TAG, "one %d", 42);
+  expect("one", 0, 1, (const uint64_t[]){42});
+
+  DLOGI(TAG, "Got IP:" IPSTR, IP2STR(&ip));
+  expect("IP2STR", 0, 4, (const uint64_t[]){192, 168, 4, 17});
+
+  DLOGI(TAG, "Got IP:" IPSTR " in %u ms", IP2STR(&ip), 250u);
+  expect("IP2STR + 1", 0, 5, (const uint64_t[]){192, 168, 4, 17, 250});
+
+  DLOGI(TAG, "%d then " IPSTR, 7, IP2STR(&ip));
+  expect("1 + IP2STR", 0, 5, (const uint64_t[]){7, 192, 168, 4, 17});
+
+  DLOGE(TAG, "%lld %u", 1LL << 40, 3u);
+  expect("wide", 1u << 0, 2, (const uint64_t[]){1ULL << 40, 3});
+
+  DLOGI(TAG, "%d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8);
+  expect("eight", 0, 8, (const uint64_t[]){1, 2, 3, 4, 5, 6, 7, 8});
+
+  if (s_last.level != ESP_LOG_INFO) {
+    fprintf(stderr, "level: got %d\n", (int)s_last.level);
+    s_failures++;
+  }
+  printf("{\"dlog_check_failures\": %d}\n", s_failures);
+  return s_failures ? 1 : 0;
+}
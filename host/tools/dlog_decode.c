@@ -0,0 +1,381 @@
+/*
+ * Turns the "DLOG" lines of a console capture back into log text. Records
+ * hold addresses for the format, the tag and %s arguments; they are looked
+ * up in the allocated sections of the firmware ELF the capture came from.
+ * Prints ESP_LOG style lines, in time order across cores.
+ *
+ * usage: dlog_decode firmware.elf < capture.log
+ */
+#include "dlog_record.h"
+#include <ctype.h>
+#include <elf.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SECTIONS 64
+
+typedef struct {
+  uint32_t addr;
+  uint32_t size;
+  const uint8_t *data;
+} section_t;
+
+static section_t s_sections[MAX_SECTIONS];
+static size_t s_section_count;
+
+typedef struct {
+  uint64_t time_us; // unwrapped per core
+  dlog_record_t rec;
+} entry_t;
+
+static entry_t *s_entries;
+static size_t s_entry_count, s_entry_cap;
+static uint32_t s_last_time[256];
+static uint64_t s_epoch[256];
+static bool s_seen[256];
+
+static uint8_t *read_file(const char *path, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *buf = n > 0 ? malloc((size_t)n) : NULL;
+  if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+    free(buf);
+    buf = NULL;
+  }
+  fclose(f);
+  *len = (size_t)n;
+  return buf;
+}
+
+// The target is little-endian RISC-V, so is every host this runs on
+static bool load_elf(const uint8_t *img, size_t len) {
+  const Elf32_Ehdr *eh = (const Elf32_Ehdr *)img;
+  if (len < sizeof(*eh) || memcmp(eh->e_ident, ELFMAG, SELFMAG) ||
+      eh->e_ident[EI_CLASS] != ELFCLASS32 ||
+      eh->e_ident[EI_DATA] != ELFDATA2LSB ||
+      eh->e_shoff + (uint64_t)eh->e_shnum * sizeof(Elf32_Shdr) > len) {
+    return false;
+  }
+  const Elf32_Shdr *sh = (const Elf32_Shdr *)(img + eh->e_shoff);
+  for (int i = 0; i < eh->e_shnum && s_section_count < MAX_SECTIONS; i++) {
+    if (!(sh[i].sh_flags & SHF_ALLOC) || sh[i].sh_type == SHT_NOBITS ||
+        sh[i].sh_offset + (uint64_t)sh[i].sh_size > len) {
+      continue;
+    }
+    s_sections[s_section_count++] = (section_t){
+        sh[i].sh_addr, sh[i].sh_size, img + sh[i].sh_offset};
+  }
+  return s_section_count > 0;
+}
+
+// The NUL-terminated string at addr in the image, NULL when there is none
+static const char *image_string(uint32_t addr) {
+  for (size_t i = 0; i < s_section_count; i++) {
+    const section_t *s = &s_sections[i];
+    if (addr < s->addr || addr - s->addr >= s->size) {
+      continue;
+    }
+    const char *str = (const char *)s->data + (addr - s->addr);
+    return memchr(str, '\0', s->size - (addr - s->addr)) ? str : NULL;
+  }
+  return NULL;
+}
+
+static int hex_nibble(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = (char)tolower((unsigned char)c);
+  return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+static uint32_t le32(const uint8_t *b) {
+  return b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+static bool parse_record(const char *hex, dlog_record_t *out) {
+  uint8_t raw[sizeof(dlog_record_t)];
+  for (size_t b = 0; b < sizeof(raw); b++) {
+    int hi = hex_nibble(hex[0]);
+    int lo = hi < 0 ? -1 : hex_nibble(hex[1]);
+    if (lo < 0) {
+      return false;
+    }
+    raw[b] = (uint8_t)(hi << 4 | lo);
+    hex += 2;
+  }
+  out->time_us = le32(raw);
+  out->fmt = le32(raw + 4);
+  out->tag = le32(raw + 8);
+  out->level = raw[12];
+  out->nwords = raw[13];
+  out->core = raw[14];
+  out->lap = raw[15];
+  for (int i = 0; i < DLOG_MAX_WORDS; i++) {
+    out->args[i] = le32(raw + 16 + 4 * i);
+  }
+  return true;
+}
+
+typedef struct {
+  const dlog_record_t *rec;
+  uint32_t next;
+  uint32_t count;
+} args_t;
+
+static bool next_word(args_t *a, uint32_t *out) {
+  if (a->next >= a->count) {
+    return false;
+  }
+  *out = a->rec->args[a->next++];
+  return true;
+}
+
+static bool next_dword(args_t *a, uint64_t *out) {
+  uint32_t lo, hi;
+  if (!next_word(a, &lo) || !next_word(a, &hi)) {
+    return false;
+  }
+  *out = (uint64_t)hi << 32 | lo;
+  return true;
+}
+
+/* printf the record's format with its argument words, sized the way the
+ * 32-bit target passed them: long is one word, long long and double two. */
+static void format_record(const dlog_record_t *rec, const char *fmt,
+                          FILE *out) {
+  args_t a = {rec, 0, rec->nwords & ~DLOG_WORDS_TRUNCATED};
+  if (a.count > DLOG_MAX_WORDS) {
+    a.count = DLOG_MAX_WORDS;
+  }
+  while (*fmt) {
+    if (*fmt != '%') {
+      fputc(*fmt++, out);
+      continue;
+    }
+    if (fmt[1] == '%') {
+      fputc('%', out);
+      fmt += 2;
+      continue;
+    }
+    // Rebuild the spec without its length modifier and with * resolved
+    char spec[64];
+    size_t n = 0;
+    const char *start = fmt++;
+    int stars[2], nstars = 0;
+    bool ok = true;
+    spec[n++] = '%';
+    while (*fmt && strchr("-+ #0123456789.*", *fmt) && n < sizeof(spec) - 8) {
+      if (*fmt == '*') {
+        uint32_t w;
+        ok = ok && nstars < 2 && next_word(&a, &w);
+        if (ok) {
+          stars[nstars++] = (int32_t)w;
+        }
+      }
+      spec[n++] = *fmt++;
+    }
+    int longs = 0;
+    bool half = false, byte = false;
+    while (*fmt && strchr("hlLjzt", *fmt)) {
+      if (*fmt == 'h') {
+        byte = half;
+        half = true;
+      } else if (*fmt == 'l' || *fmt == 'L') {
+        longs++;
+      } else if (*fmt == 'j') {
+        longs = 2;
+      }
+      fmt++;
+    }
+    char conv = *fmt ? *fmt++ : '\0';
+    bool wide = longs >= 2; // ll, j; L takes two words as a double anyway
+    char text[512];
+    text[0] = '\0';
+    if (ok && conv && strchr("diouxXc", conv)) {
+      uint64_t v = 0;
+      uint32_t w = 0;
+      ok = wide ? next_dword(&a, &v) : next_word(&a, &w);
+      if (ok && !wide) {
+        bool sign = conv == 'd' || conv == 'i';
+        v = byte   ? (sign ? (uint64_t)(int8_t)w : (uint8_t)w)
+            : half ? (sign ? (uint64_t)(int16_t)w : (uint16_t)w)
+            : sign ? (uint64_t)(int32_t)w
+                   : w;
+      }
+      if (conv == 'c') {
+        spec[n++] = 'c';
+      } else {
+        spec[n++] = 'l';
+        spec[n++] = 'l';
+        spec[n++] = conv;
+      }
+      spec[n] = '\0';
+      if (ok && nstars == 2) {
+        snprintf(text, sizeof(text), spec, stars[0], stars[1], v);
+      } else if (ok && nstars == 1) {
+        snprintf(text, sizeof(text), spec, stars[0], v);
+      } else if (ok) {
+        snprintf(text, sizeof(text), spec, v);
+      }
+    } else if (ok && conv && strchr("fFeEgGaA", conv)) {
+      uint64_t bits = 0;
+      double d;
+      ok = next_dword(&a, &bits);
+      memcpy(&d, &bits, sizeof(d));
+      spec[n++] = conv;
+      spec[n] = '\0';
+      if (ok && nstars == 2) {
+        snprintf(text, sizeof(text), spec, stars[0], stars[1], d);
+      } else if (ok && nstars == 1) {
+        snprintf(text, sizeof(text), spec, stars[0], d);
+      } else if (ok) {
+        snprintf(text, sizeof(text), spec, d);
+      }
+    } else if (ok && (conv == 's' || conv == 'p')) {
+      uint32_t addr = 0;
+      ok = next_word(&a, &addr);
+      const char *str = conv == 's' ? image_string(addr) : NULL;
+      char addr_text[16];
+      if (!str) {
+        // Not in the image: a buffer, all that is left is where it was
+        snprintf(addr_text, sizeof(addr_text), "0x%08" PRIx32, addr);
+        str = addr_text;
+      }
+      spec[n++] = 's';
+      spec[n] = '\0';
+      if (ok && nstars == 2) {
+        snprintf(text, sizeof(text), spec, stars[0], stars[1], str);
+      } else if (ok && nstars == 1) {
+        snprintf(text, sizeof(text), spec, stars[0], str);
+      } else if (ok) {
+        snprintf(text, sizeof(text), spec, str);
+      }
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      // Out of words or a spec this does not know, show it raw
+      fprintf(out, "<%.*s?>", (int)(fmt - start), start);
+      continue;
+    }
+    fputs(text, out);
+  }
+  if (rec->nwords & DLOG_WORDS_TRUNCATED) {
+    fputs(" [truncated]", out);
+  }
+}
+
+static int entry_cmp(const void *pa, const void *pb) {
+  const entry_t *a = pa, *b = pb;
+  if (a->time_us != b->time_us) {
+    return a->time_us < b->time_us ? -1 : 1;
+  }
+  // qsort is not stable, keep the ring order of equal times
+  return a < b ? -1 : a > b;
+}
+
+static void print_entries(void) {
+  static const char letters[] = "NEWIDV";
+  if (s_entry_count) {
+    qsort(s_entries, s_entry_count, sizeof(*s_entries), entry_cmp);
+  }
+  for (size_t i = 0; i < s_entry_count; i++) {
+    const dlog_record_t *rec = &s_entries[i].rec;
+    const char *tag = image_string(rec->tag);
+    const char *fmt = image_string(rec->fmt);
+    printf("%c (%" PRIu64 ") %s: ",
+           rec->level < sizeof(letters) - 1 ? letters[rec->level] : '?',
+           s_entries[i].time_us / 1000, tag ? tag : "?");
+    if (fmt) {
+      format_record(rec, fmt, stdout);
+    } else {
+      printf("<format at 0x%08" PRIx32 " not in the ELF>", rec->fmt);
+    }
+    putchar('\n');
+  }
+  s_entry_count = 0;
+}
+
+static void add_entry(const dlog_record_t *rec) {
+  if (s_entry_count == s_entry_cap) {
+    s_entry_cap = s_entry_cap ? 2 * s_entry_cap : 1024;
+    s_entries = realloc(s_entries, s_entry_cap * sizeof(*s_entries));
+    if (!s_entries) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  // esp_timer time in 32 bits wraps every ~71 minutes. A core's records
+  // come in the order it wrote them, so a big step back is a wrap.
+  uint8_t core = rec->core;
+  if (s_seen[core] && rec->time_us < s_last_time[core] &&
+      s_last_time[core] - rec->time_us > UINT32_MAX / 2) {
+    s_epoch[core] += (uint64_t)1 << 32;
+  }
+  s_seen[core] = true;
+  s_last_time[core] = rec->time_us;
+  s_entries[s_entry_count++] =
+      (entry_t){s_epoch[core] + rec->time_us, *rec};
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s firmware.elf < capture.log\n", argv[0]);
+    return 1;
+  }
+  size_t elf_len;
+  uint8_t *elf = read_file(argv[1], &elf_len);
+  if (!elf || !load_elf(elf, elf_len)) {
+    fprintf(stderr, "%s: not a 32-bit little-endian ELF\n", argv[1]);
+    return 1;
+  }
+
+  char line[1024];
+  uint32_t records = 0, bad = 0;
+  while (fgets(line, sizeof(line), stdin)) {
+    // Tolerate log prefixes, the records go out with puts()
+    const char *p = strstr(line, DLOG_LINE_PREFIX);
+    if (!p) {
+      continue;
+    }
+    p += strlen(DLOG_LINE_PREFIX);
+    unsigned n;
+    if (sscanf(p, "LOST %u", &n) == 1) {
+      print_entries();
+      printf("--- %u records lost ---\n", n);
+    } else if (sscanf(p, "PANIC %u", &n) == 1 ||
+               !strncmp(p, "BOOT", 4)) {
+      // Times start over, they do not sort with the ones before
+      print_entries();
+      memset(s_seen, 0, sizeof(s_seen));
+      memset(s_epoch, 0, sizeof(s_epoch));
+      if (*p == 'P') {
+        printf("--- %u records left by the previous boot ---\n", n);
+      } else {
+        printf("--- boot ---\n");
+      }
+    } else {
+      dlog_record_t rec;
+      if (parse_record(p, &rec)) {
+        add_entry(&rec);
+        records++;
+      } else {
+        bad++;
+      }
+    }
+  }
+  print_entries();
+  fprintf(stderr, "%u records, %u bad lines\n", records, bad);
+  free(s_entries);
+  free(elf);
+  return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Decodes a console capture containing the output of "trace dump" and rebuilds
+ * the touch-to-photon breakdown of each interaction. Prints one JSON object
+ * with per-stage percentiles and which stage dominated the interactions over
+ * the budget; --list adds one CSV line per interaction before it.
+ *
+ * usage: trace_decode [--list] [--budget-ms N] < capture.log
+ */
+#include "trace_stats.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_BUDGET_MS 100 // W-UI-2
+
+static int hex_nibble(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = (char)tolower((unsigned char)c);
+  return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+// Parse the hex after "TRACE " into records, returns how many
+static size_t parse_line(const char *hex, trace_record_t *out, size_t max) {
+  size_t n = 0;
+  while (n < max) {
+    uint8_t raw[sizeof(trace_record_t)];
+    for (size_t b = 0; b < sizeof(raw); b++) {
+      int hi = hex_nibble(hex[0]);
+      int lo = hi < 0 ? -1 : hex_nibble(hex[1]);
+      if (lo < 0) {
+        return n;
+      }
+      raw[b] = (uint8_t)(hi << 4 | lo);
+      hex += 2;
+    }
+    // Dumped little-endian, decode by hand so the host order does not matter
+    out[n].time_us = raw[0] | raw[1] << 8 | raw[2] << 16 | (uint32_t)raw[3]
+                                                               << 24;
+    out[n].arg = raw[4] | raw[5] << 8;
+    out[n].id = raw[6];
+    out[n].lap = raw[7];
+    n++;
+  }
+  return n;
+}
+
+static trace_stage_t worst_stage(const trace_interaction_t *it) {
+  trace_stage_t worst = TRACE_STAGE_INPUT;
+  for (int s = TRACE_STAGE_INPUT; s < TRACE_STAGE_TOTAL; s++) {
+    if (it->stage_us[s] > it->stage_us[worst]) {
+      worst = s;
+    }
+  }
+  return worst;
+}
+
+int main(int argc, char **argv) {
+  bool list = false;
+  unsigned budget_ms = DEFAULT_BUDGET_MS;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--list")) {
+      list = true;
+    } else if (!strcmp(argv[i], "--budget-ms") && i + 1 < argc) {
+      budget_ms = (unsigned)atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--list] [--budget-ms N] < capture.log\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  static trace_hist_t hists[TRACE_STAGE_COUNT];
+  uint32_t breakers[TRACE_STAGE_COUNT] = {0};
+  uint32_t events = 0, interactions = 0, over_budget = 0;
+  trace_correlator_t corr;
+  trace_correlator_init(&corr);
+
+  if (list) {
+    printf("touch_us");
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+      printf(",%s_us", trace_stage_names[s]);
+    }
+    printf(",worst\n");
+  }
+
+  char line[1024];
+  while (fgets(line, sizeof(line), stdin)) {
+    // Tolerate log prefixes and the "TRACE END" trailer
+    const char *p = strstr(line, "TRACE ");
+    if (!p || !strncmp(p, "TRACE END", 9)) {
+      continue;
+    }
+    trace_record_t recs[sizeof(line) / 16];
+    size_t n = parse_line(p + 6, recs, sizeof(recs) / sizeof(recs[0]));
+    for (size_t i = 0; i < n; i++) {
+      events++;
+      trace_interaction_t it;
+      if (!trace_correlator_feed(&corr, &recs[i], &it)) {
+        continue;
+      }
+      interactions++;
+      for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        trace_hist_add(&hists[s], it.stage_us[s]);
+      }
+      trace_stage_t worst = worst_stage(&it);
+      if (it.stage_us[TRACE_STAGE_TOTAL] > budget_ms * 1000) {
+        over_budget++;
+        breakers[worst]++;
+      }
+      if (list) {
+        printf("%u", (unsigned)it.touch_us);
+        for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+          printf(",%u", (unsigned)it.stage_us[s]);
+        }
+        printf(",%s\n", trace_stage_names[worst]);
+      }
+    }
+  }
+
+  printf("{\"events\":%u,\"interactions\":%u,\"budget_ms\":%u,"
+         "\"over_budget\":%u,\"stages\":{",
+         events, interactions, budget_ms, over_budget);
+  for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+    const trace_hist_t *h = &hists[s];
+    printf("%s\"%s\":{\"p50_us\":%u,\"p90_us\":%u,\"p99_us\":%u,"
+           "\"max_us\":%u,\"mean_us\":%.1f}",
+           s ? "," : "", trace_stage_names[s],
+           (unsigned)trace_hist_percentile(h, 50),
+           (unsigned)trace_hist_percentile(h, 90),
+           (unsigned)trace_hist_percentile(h, 99), (unsigned)h->max_us,
+           h->count ? (double)h->sum_us / h->count : 0.0);
+  }
+  printf("},\"over_budget_by_stage\":{");
+  for (int s = TRACE_STAGE_INPUT; s < TRACE_STAGE_TOTAL; s++) {
+    printf("%s\"%s\":%u", s ? "," : "", trace_stage_names[s], breakers[s]);
+  }
+  printf("}}\n");
+  return 0;
+}
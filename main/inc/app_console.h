@@ -0,0 +1,7 @@
+#ifndef __APP_CONSOLE_H__
+#define __APP_CONSOLE_H__
+
+// Start the serial console REPL with the diagnostic commands
+void app_console_start(void);
+
+#endif //__APP_CONSOLE_H__
@@ -0,0 +1,82 @@
+#ifndef __ASSET_PACK_H__
+#define __ASSET_PACK_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Layout of the "assets" data partition, written by host/tools/asset_pack:
+ *
+ *   asset_pack_header_t | asset_entry_t[count] | pixel data ...
+ *
+ * Pixel data is already in the format LVGL draws from, so image descriptors
+ * point straight into the memory-mapped partition. Little-endian, like both
+ * the host and the ESP32-C6. */
+
+#define ASSET_PACK_MAGIC 0x4b505341 // "ASPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_NAME_LEN 24
+// Alignment of each asset's pixel data inside the blob
+#define ASSET_DATA_ALIGN 4
+
+typedef enum {
+  ASSET_FORMAT_RGB565,         // what LVGL renders when flush swaps bytes
+  ASSET_FORMAT_RGB565_SWAPPED, // panel byte order, for RENDER_SWAPPED builds
+  ASSET_FORMAT_RGB565A8,       // RGB565 plane followed by an A8 plane
+  ASSET_FORMAT_A8,             // alpha only, drawn recoloured (icons, glyphs)
+  ASSET_FORMAT_COUNT,
+} asset_format_t;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+  uint32_t total_size; // header, index and data
+  uint32_t index_crc;  // CRC-32 of the entries
+} asset_pack_header_t;
+
+typedef struct {
+  char name[ASSET_NAME_LEN]; // NUL-terminated
+  uint32_t offset;           // from the start of the blob
+  uint32_t size;
+  uint32_t crc; // CRC-32 of the pixel data
+  uint16_t width;
+  uint16_t height;
+  uint16_t stride; // bytes per row of the first plane
+  uint8_t format;  // asset_format_t
+  uint8_t reserved[5];
+} asset_entry_t;
+
+_Static_assert(sizeof(asset_pack_header_t) == 16, "asset pack header layout");
+_Static_assert(sizeof(asset_entry_t) == 48, "asset entry layout");
+
+typedef enum {
+  ASSET_PACK_OK,
+  ASSET_PACK_ERR_SIZE,      // blob shorter than its header or index says
+  ASSET_PACK_ERR_MAGIC,     // not an asset pack
+  ASSET_PACK_ERR_VERSION,   // packed by an incompatible tool
+  ASSET_PACK_ERR_INDEX_CRC, // index corrupted
+  ASSET_PACK_ERR_ENTRY,     // entry out of bounds or inconsistent
+  ASSET_PACK_ERR_DATA_CRC,  // pixel data corrupted
+} asset_pack_err_t;
+
+extern const char *const asset_format_names[];
+extern const char *const asset_pack_err_names[];
+
+// zlib-compatible CRC-32, pass 0 to start
+uint32_t asset_pack_crc32(uint32_t crc, const void *data, size_t len);
+
+// Bytes of pixel data and of the first plane's rows for a format
+uint32_t asset_pack_data_size(asset_format_t format, uint32_t w, uint32_t h);
+uint32_t asset_pack_stride(asset_format_t format, uint32_t w);
+
+// Validate header and index, and the pixel data CRCs if check_data. On
+// ASSET_PACK_ERR_ENTRY or _DATA_CRC, *bad_entry is the offending index.
+asset_pack_err_t asset_pack_check(const void *blob, size_t len,
+                                  bool check_data, uint32_t *bad_entry);
+
+// Only on a blob that passed asset_pack_check
+const asset_entry_t *asset_pack_entries(const void *blob);
+const asset_entry_t *asset_pack_find(const void *blob, const char *name);
+
+#endif //__ASSET_PACK_H__
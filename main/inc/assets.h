@@ -0,0 +1,23 @@
+#ifndef __ASSETS_H__
+#define __ASSETS_H__
+
+#include "lvgl.h"
+#include <stdbool.h>
+
+#define ASSETS_PARTITION_LABEL "assets"
+
+/* Map the "assets" partition and build an LVGL image descriptor for every
+ * entry. Pixel data stays in flash, read through the cache: only the
+ * descriptors take RAM. Checks the header and index, not the pixel data.
+ * False when the partition is missing, empty or corrupt. */
+bool assets_mount(void);
+
+// NULL when not mounted or there is no such asset
+const lv_image_dsc_t *assets_image(const char *name);
+
+// Re-check every asset's pixel data CRC, prints the result
+bool assets_verify(void);
+// One line per asset to stdout
+void assets_print(void);
+
+#endif //__ASSETS_H__
@@ -0,0 +1,39 @@
+#ifndef __BOOT_H__
+#define __BOOT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BOOT_MAX_STAGES 8
+#define BOOT_DEP(stage) (1u << (stage))
+
+/* One step of the bring-up. Each stage runs in its own task as soon as the
+ * stages in deps have finished, so independent chains (display, radio)
+ * overlap their waits. */
+typedef struct {
+  const char *name;
+  void (*run)(void);
+  uint32_t deps; // BOOT_DEP() of the stages that have to finish first
+  uint32_t stack_size;
+  uint32_t priority;
+} boot_stage_t;
+
+// Points in time after the stages, set by whoever gets there
+typedef enum {
+  BOOT_MARK_FIRST_PIXEL, // first frame on the panel, backlight on
+  BOOT_MARK_GOT_IP,
+  BOOT_MARK_TIME_SYNC,
+  BOOT_MARK_COUNT,
+} boot_mark_t;
+
+// Run the stages and return when all of them are done, then log the
+// timeline. Stages may only depend on stages with a lower index.
+void boot_run(const boot_stage_t *stages, size_t count);
+
+// Record a milestone, only the first call per mark counts
+void boot_mark(boot_mark_t mark);
+
+// Stage start/end and milestones in ms since esp_timer started, to stdout
+void boot_print_timeline(void);
+
+#endif //__BOOT_H__
@@ -0,0 +1,29 @@
+#ifndef __CLOCK_WIDGET_H__
+#define __CLOCK_WIDGET_H__
+
+#include "lvgl.h"
+
+// "HH:MM:SS"
+#define CLOCK_WIDGET_CELLS 8
+// '0'..'9' and ':'
+#define CLOCK_WIDGET_GLYPHS 11
+
+/* Clock made of fixed-width cells, one image per character. The glyphs are
+ * rendered once at init, opaque on the background colour, so a tick only
+ * swaps the source of the cells whose digit changed and LVGL invalidates
+ * just those. */
+typedef struct {
+  lv_obj_t *obj; // container, align/position it like any widget
+  lv_obj_t *cells[CLOCK_WIDGET_CELLS];
+  lv_draw_buf_t *glyphs[CLOCK_WIDGET_GLYPHS];
+  int8_t shown[CLOCK_WIDGET_CELLS]; // glyph index per cell, -1 before the
+                                    // first set
+} clock_widget_t;
+
+void clock_widget_init(clock_widget_t *w, lv_obj_t *parent,
+                       const lv_font_t *font, lv_color_t fg, lv_color_t bg);
+
+void clock_widget_set_time(clock_widget_t *w, uint8_t h, uint8_t m,
+                           uint8_t s);
+
+#endif //__CLOCK_WIDGET_H__
@@ -21,6 +21,9 @@
 #define EXAMPLE_LCD_PIXEL_CLOCK_HZ (20 * 1000 * 1000)
 #define EXAMPLE_LCD_BK_LIGHT_ON_LEVEL 1
 #define EXAMPLE_LCD_BK_LIGHT_OFF_LEVEL !EXAMPLE_LCD_BK_LIGHT_ON_LEVEL
+// Backlight PWM, off the XTAL clock so DFS does not shift it
+#define EXAMPLE_LCD_BK_LIGHT_PWM_HZ 5000
+#define EXAMPLE_LCD_BK_LIGHT_FADE_MS 500
 #define EXAMPLE_PIN_NUM_SCLK 6
 #define EXAMPLE_PIN_NUM_MOSI 7
 #define EXAMPLE_PIN_NUM_MISO 2
@@ -29,6 +32,7 @@
 #define EXAMPLE_PIN_NUM_LCD_CS 4
 #define EXAMPLE_PIN_NUM_BK_LIGHT 19
 #define EXAMPLE_PIN_NUM_TOUCH_CS 20
+#define EXAMPLE_PIN_NUM_TOUCH_IRQ 18
 
 // The pixel number in horizontal and vertical
 #if CONFIG_EXAMPLE_LCD_CONTROLLER_ILI9341
@@ -42,12 +46,92 @@
 #define EXAMPLE_LCD_CMD_BITS 8
 #define EXAMPLE_LCD_PARAM_BITS 8
 
-#define EXAMPLE_LVGL_DRAW_BUF_LINES                                            \
-  20 // number of display lines in each draw buffer
-#define EXAMPLE_LVGL_TICK_PERIOD_MS 2
-#define LVGL_TASK_MAX_DELAY_MS 500
+// Extra pixels worth re-rendering to save one CASET/RASET/RAMWR round trip
+// when merging neighbouring invalid areas
+#define EXAMPLE_LVGL_MERGE_SLACK_PX 256
 #define LVGL_TASK_MIN_DELAY_MS 1000 / CONFIG_FREERTOS_HZ
+// Re-check the flushing flag this often in case a transfer-done was missed
+#define LVGL_TASK_FLUSH_TIMEOUT_MS 100
 #define LVGL_TASK_STACK_SIZE (4 * 1024)
 #define LVGL_TASK_PRIORITY 2
+#define LVGL_PORT_MAX_INDEVS 2
+
+// W-2: UI on screen within 3 s of power-on
+#define BOOT_FIRST_PIXEL_BUDGET_MS 3000
+#define BOOT_STAGE_STACK_SIZE (4 * 1024)
+#define BOOT_STAGE_PRIORITY 1
+#define BOOT_DISPLAY_STAGE_PRIORITY LVGL_TASK_PRIORITY
+
+// W-UI-2: touch to photon
+#define TOUCH_LATENCY_BUDGET_MS 100
+// Touch is sampled this often while the panel is pressed
+#define TOUCH_SAMPLE_PERIOD_MS 10
+// Weight of a new sample in the touch IIR filter, Q8, 0 turns smoothing off
+#define TOUCH_FILTER_ALPHA_Q8 128
+#define TOUCH_TASK_STACK_SIZE (3 * 1024)
+// Above LVGL so sampling keeps its pace while a frame renders
+#define TOUCH_TASK_PRIORITY (LVGL_TASK_PRIORITY + 1)
+
+// Deferred logging (dlog.c): records per core, a power of two
+#define DLOG_RING_LEN 128
+#define DLOG_FLUSH_PERIOD_MS 500
+#define DLOG_TASK_STACK_SIZE (3 * 1024)
+// Below everything else, printing is what the deferral is for
+#define DLOG_TASK_PRIORITY 1
+
+// Power governor: display refresh period per UI activity level
+#define GOVERNOR_INTERACTIVE_PERIOD_MS 16 // ~60 Hz while touched
+#define GOVERNOR_ANIMATING_PERIOD_MS 33
+#define GOVERNOR_IDLE_PERIOD_MS 1000 // the clock only changes once a second
+// Keeps 60 Hz through scroll throw after the finger lifts
+#define GOVERNOR_INTERACTIVE_HOLD_MS 1000
+#define GOVERNOR_DIM_AFTER_MS (15 * 1000)
+#define GOVERNOR_BACKLIGHT_FULL 100
+#define GOVERNOR_BACKLIGHT_DIM 20
+
+// LVGL allocator (lv_mem_pool.c): a static region of its own, outside the
+// heap that Wi-Fi and the DMA draw buffers use
+#define LV_MEM_POOL_SIZE (64 * 1024)
+#define LV_MEM_POOL_PAGE_SIZE 512
+// Refresh period of the on-screen pool monitor (lvmem monitor on)
+#define LV_MEM_POOL_MONITOR_MS 1000
+
+// Screen manager: inactive screens are deleted, least recently shown first,
+// while the LVGL heap is above the budget
+#define SCREEN_LVGL_HEAP_BUDGET (40 * 1024)
+// Swipe bitmaps are kept at 1/2^shift of the display resolution, rendered
+// this many full-resolution rows at a time (a multiple of 1 << shift)
+#define SCREEN_SNAPSHOT_SHIFT 1
+#define SCREEN_SNAPSHOT_BAND_ROWS 16
+// Age up to which a neighbour's bitmap stands in for it, much shorter for
+// screens that change every second
+#define SCREEN_SNAPSHOT_MAX_AGE_MS (10 * 1000)
+#define SCREEN_SNAPSHOT_TICK_MAX_AGE_MS 200
+// Bitmaps are not allocated when the largest free heap block would keep less
+// than this for Wi-Fi and the draw buffers, swipes then animate live
+#define SCREEN_SNAPSHOT_HEAP_RESERVE (64 * 1024)
+// Bitmaps are refreshed once input has been idle this long
+#define SCREEN_SNAPSHOT_IDLE_MS 500
+#define SCREEN_SWIPE_ANIM_MS 250
+
+// Timer service: periodic watch work runs off one wheel in the LVGL task
+// Wakeup retry when the UI command queue was full
+#define TIMER_SVC_RETRY_MS 10
+
+// Wi-Fi reconnect backoff: doubles per failed attempt up to the max, half of
+// each delay is random jitter
+#define WIFI_BACKOFF_BASE_MS 1000
+#define WIFI_BACKOFF_MAX_MS (5 * 60 * 1000)
+#define WIFI_SNTP_SERVER "pool.ntp.org"
+// The cached AP and IP are skipped when their DHCP lease has less than this
+// left. Times before WIFI_CLOCK_SET_AFTER (2024-01-01) mean an unset clock.
+#define WIFI_LEASE_MARGIN_S 60
+#define WIFI_CLOCK_SET_AFTER 1704067200
+// Eastern Time, parsed once by the time service
+#define WATCH_TZ "EST5EDT,M3.2.0/2,M11.1.0"
+// Time service: ticks land this long after the wall-clock boundary, so the
+// system clock has turned over when they read it
+#define TIME_SVC_TICK_SLACK_MS 2
+#define TIME_SVC_MAX_SUBSCRIBERS 4
 
 #endif //__CONFIG_H__
@@ -0,0 +1,120 @@
+#ifndef __DLOG_H__
+#define __DLOG_H__
+
+#include "dlog_record.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <string.h>
+
+/* Deferred binary logging for runtime paths. DLOGx(tag, fmt, ...) stores
+ * the format string's address and the raw arguments in a per-core ring and
+ * returns: nothing is formatted and nothing waits on the UART. A low
+ * priority task prints the records as hex, and host/tools/dlog_decode turns
+ * them back into text with the strings from the firmware ELF. Records left
+ * in the ring by a panic are printed on the next boot.
+ *
+ * Same arguments as ESP_LOGx, at most 8 and no buffers for %s (see
+ * dlog_record.h). Pointers other than char * are passed as void *. Without
+ * CONFIG_EXAMPLE_DEFERRED_LOG, and on the host, these are ESP_LOGx. */
+
+#if CONFIG_EXAMPLE_DEFERRED_LOG
+
+#define DLOGE(tag, fmt, ...) DLOG_WRITE_(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...) DLOG_WRITE_(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) DLOG_WRITE_(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) DLOG_WRITE_(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+#else
+
+#define DLOGE ESP_LOGE
+#define DLOGW ESP_LOGW
+#define DLOGI ESP_LOGI
+#define DLOGD ESP_LOGD
+
+#endif
+
+typedef struct {
+  uint32_t written;
+  uint32_t filtered; // under the level set with dlog_set_level
+  uint32_t lost;     // overwritten before the flush task printed them
+  uint32_t truncated;
+  uint32_t flushed;
+  uint32_t panic_records; // printed at boot, left by a panic
+} dlog_stats_t;
+
+/* Print what a panic left in the rings, reset them and start the flush
+ * task. Call first thing in app_main, before anything logs through DLOGx. */
+void dlog_init(void);
+
+// Records above level are dropped at the call, like esp_log_level_set
+void dlog_set_level(esp_log_level_t level);
+
+// Print everything recorded so far now, from the calling task
+void dlog_flush(void);
+
+void dlog_get_stats(dlog_stats_t *out);
+
+/* Backend of the macros: nargs arguments, bit i of wide set when argument i
+ * takes two words. Lock-free, callable from any task or ISR. */
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                uint32_t wide, uint32_t nargs, const uint64_t *args);
+
+static inline uint64_t dlog_arg_int(uint64_t v) { return v; }
+
+static inline uint64_t dlog_arg_f64(double v) {
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return bits;
+}
+
+static inline uint64_t dlog_arg_ptr(const void *p) { return (uintptr_t)p; }
+
+// Floats are promoted to double like any variadic argument
+#define DLOG_ARG_(i, x)                                                        \
+  _Generic((x),                                                                \
+      float: dlog_arg_f64,                                                     \
+      double: dlog_arg_f64,                                                    \
+      char *: dlog_arg_ptr,                                                    \
+      const char *: dlog_arg_ptr,                                              \
+      void *: dlog_arg_ptr,                                                    \
+      const void *: dlog_arg_ptr,                                              \
+      default: dlog_arg_int)(x),
+#define DLOG_WIDE_(i, x)                                                       \
+  | ((uint32_t)_Generic((x), float: 1, default: sizeof((x) + 0) > 4) << (i))
+
+#define DLOG_NARGS_(...)                                                       \
+  DLOG_NARGS_N_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_N_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define DLOG_CAT_(a, b) DLOG_CAT2_(a, b)
+#define DLOG_CAT2_(a, b) a##b
+/* The argument list goes through DLOG_APPLY_ so macros in it (IP2STR)
+ * are expanded before the map sees it, as they are when DLOG_NARGS_ counts */
+#define DLOG_APPLY_(f, args) f args
+#define DLOG_MAP_(m, ...)                                                      \
+  DLOG_APPLY_(DLOG_CAT_(DLOG_MAP_, DLOG_NARGS_(__VA_ARGS__)),                  \
+              (m, ##__VA_ARGS__))
+#define DLOG_MAP_0(m)
+#define DLOG_MAP_1(m, a) m(0, a)
+#define DLOG_MAP_2(m, a, b) DLOG_MAP_1(m, a) m(1, b)
+#define DLOG_MAP_3(m, a, b, c) DLOG_MAP_2(m, a, b) m(2, c)
+#define DLOG_MAP_4(m, a, b, c, d) DLOG_MAP_3(m, a, b, c) m(3, d)
+#define DLOG_MAP_5(m, a, b, c, d, e) DLOG_MAP_4(m, a, b, c, d) m(4, e)
+#define DLOG_MAP_6(m, a, b, c, d, e, f) DLOG_MAP_5(m, a, b, c, d, e) m(5, f)
+#define DLOG_MAP_7(m, a, b, c, d, e, f, g)                                     \
+  DLOG_MAP_6(m, a, b, c, d, e, f) m(6, g)
+#define DLOG_MAP_8(m, a, b, c, d, e, f, g, h)                                  \
+  DLOG_MAP_7(m, a, b, c, d, e, f, g) m(7, h)
+
+// The leading 0 keeps the array non-empty for calls without arguments
+#define DLOG_WRITE_(level, tag, fmt, ...)                                      \
+  do {                                                                         \
+    if (LOG_LOCAL_LEVEL >= (level)) {                                          \
+      const uint64_t dlog_args_[] = {0, DLOG_MAP_(DLOG_ARG_, ##__VA_ARGS__)};  \
+      dlog_write((level), (tag), (fmt),                                        \
+                 0u DLOG_MAP_(DLOG_WIDE_, ##__VA_ARGS__),                      \
+                 DLOG_NARGS_(__VA_ARGS__), dlog_args_ + 1);                    \
+    }                                                                          \
+  } while (0)
+
+#endif //__DLOG_H__
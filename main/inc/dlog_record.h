@@ -0,0 +1,34 @@
+#ifndef __DLOG_RECORD_H__
+#define __DLOG_RECORD_H__
+
+#include <stdint.h>
+
+/* One deferred log call as it sits in the ring and goes over the console,
+ * shared with host/tools/dlog_decode. fmt and tag are addresses of the
+ * strings in the firmware image: the decoder reads them from the ELF.
+ * Arguments are raw 32-bit words, 64-bit integers and doubles take two, low
+ * word first. A %s argument is an address too, so it must point into the
+ * image (a literal or a const table), not at a buffer. */
+
+#define DLOG_MAX_WORDS 8
+// nwords flag: arguments past DLOG_MAX_WORDS were dropped
+#define DLOG_WORDS_TRUNCATED 0x80
+/* Console lines: "DLOG <hex record>", "DLOG LOST <n>" records overwritten,
+ * "DLOG PANIC <n>" records a panic left follow, "DLOG BOOT" the boot's own
+ * records follow */
+#define DLOG_LINE_PREFIX "DLOG "
+
+typedef struct {
+  uint32_t time_us; // esp_timer time
+  uint32_t fmt;
+  uint32_t tag;
+  uint8_t level;  // esp_log_level_t
+  uint8_t nwords; // argument words used, DLOG_WORDS_TRUNCATED
+  uint8_t core;
+  uint8_t lap; // ring pass the record was written in, 0 while writing
+  uint32_t args[DLOG_MAX_WORDS];
+} dlog_record_t;
+
+_Static_assert(sizeof(dlog_record_t) == 48, "dlog records are dumped as-is");
+
+#endif //__DLOG_RECORD_H__
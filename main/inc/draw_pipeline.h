@@ -0,0 +1,74 @@
+#ifndef __DRAW_PIPELINE_H__
+#define __DRAW_PIPELINE_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DRAW_PIPELINE_MAX_BUFS 8
+
+/* Ring of DMA draw buffers shared between the renderer and the SPI
+ * transfer-done ISR. LVGL always renders into render_buf; submitted buffers
+ * complete in order, and the renderer only has to wait when every other
+ * buffer is still queued for DMA. */
+typedef struct {
+  uint8_t *bufs[DRAW_PIPELINE_MAX_BUFS];
+  uint32_t count;
+  size_t buf_size;
+  uint8_t *render_buf;
+  uint32_t render_idx;
+  // Free buffer bitmask, plus DRAW_PIPELINE_WAITING while LVGL is blocked
+  _Atomic uint32_t state;
+  // In-flight buffers in submission order, written by the renderer and
+  // consumed by the ISR
+  uint8_t inflight[DRAW_PIPELINE_MAX_BUFS];
+  // Transfers each in-flight buffer goes out in, and how many of the oldest
+  // one's are done (ISR only)
+  uint8_t transfers[DRAW_PIPELINE_MAX_BUFS];
+  uint8_t head_done;
+  _Atomic uint32_t inflight_head;
+  _Atomic uint32_t inflight_tail;
+  uint32_t stalls; // submits that found no free buffer
+} draw_pipeline_t;
+
+typedef struct {
+  uint32_t count_max;   // never use more buffers than this
+  uint32_t lines_min;   // smallest useful buffer height
+  uint32_t lines_max;   // buffers never get taller than this
+  uint32_t heap_percent; // share of the free DMA heap we may take
+  size_t heap_reserve;  // DMA heap always left for Wi-Fi/BLE
+  bool prefer_count;    // more buffers first, otherwise taller buffers first
+} draw_pipeline_policy_t;
+
+typedef struct {
+  uint32_t count;
+  uint32_t lines;
+} draw_pipeline_plan_t;
+
+// Pick buffer count and height from the free DMA-capable heap. Returns false
+// when not even one lines_min buffer fits; out then holds that minimum.
+bool draw_pipeline_plan(const draw_pipeline_policy_t *policy,
+                        size_t line_bytes, size_t free_bytes,
+                        size_t largest_block, draw_pipeline_plan_t *out);
+
+void draw_pipeline_init(draw_pipeline_t *p, uint8_t *const *bufs,
+                        uint32_t count, size_t buf_size);
+
+// Renderer side: queue render_buf for DMA as this many transfers. Call before
+// starting them, the completions may fire before the transfer call returns.
+void draw_pipeline_submit(draw_pipeline_t *p, uint32_t transfers);
+
+// Renderer side, after submit: move render_buf to a free buffer. Returns false
+// when none is free; draw_pipeline_complete() then hands one over.
+bool draw_pipeline_acquire(draw_pipeline_t *p);
+
+// ISR side: a transfer of the oldest submitted buffer finished. Returns true
+// when that was its last and it was handed to a waiting renderer as the new
+// render_buf.
+bool draw_pipeline_complete(draw_pipeline_t *p);
+
+// Buffers submitted and not completed yet
+uint32_t draw_pipeline_inflight(draw_pipeline_t *p);
+
+#endif //__DRAW_PIPELINE_H__
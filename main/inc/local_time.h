@@ -0,0 +1,71 @@
+#ifndef __LOCAL_TIME_H__
+#define __LOCAL_TIME_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/* UTC to local time for one POSIX TZ rule, without libc's localtime_r:
+ *
+ *   std offset [dst [offset] [,start[/time],end[/time]]]
+ *
+ * e.g. "EST5EDT,M3.2.0/2,M11.1.0". Offsets are west of UTC as in POSIX,
+ * names may be quoted in <>, rules are Mm.w.d, Jn or n. A dst name without
+ * rules uses the US ones. The rule is parsed once. Each conversion checks
+ * the instant against the span between the last and the next DST
+ * transition and the local day it last fell in, and otherwise only divides
+ * the seconds of the day. Both are worked out again when the instant leaves
+ * them. */
+
+typedef enum {
+  LOCAL_TZ_RULE_MONTH,   // Mm.w.d: day d (0 Sunday) of week w (5 last)
+  LOCAL_TZ_RULE_JULIAN1, // Jn: day n 1..365, February 29 not counted
+  LOCAL_TZ_RULE_JULIAN0, // n: day n 0..365, February 29 counted
+} local_tz_rule_kind_t;
+
+typedef struct {
+  uint8_t kind; // local_tz_rule_kind_t
+  uint8_t month;
+  uint8_t week;
+  uint8_t wday;
+  uint16_t day;
+  int32_t time; // seconds from local midnight, may be negative or past 24 h
+} local_tz_rule_t;
+
+typedef struct {
+  int32_t std_offset; // seconds east of UTC
+  int32_t dst_offset;
+  bool has_dst;
+  local_tz_rule_t start; // in standard time
+  local_tz_rule_t end;   // in daylight time
+} local_tz_t;
+
+typedef struct {
+  uint32_t conversions;
+  uint32_t span_changes; // DST transitions worked out
+  uint32_t day_changes;  // dates worked out
+} local_time_stats_t;
+
+typedef struct {
+  local_tz_t tz;
+  // UTC seconds over which offset holds, from one transition to the next
+  int64_t span_start;
+  int64_t span_end;
+  int32_t offset;
+  bool dst;
+  // Local seconds at the midnight starting the cached day, and its date
+  int64_t day_start;
+  struct tm day;
+  local_time_stats_t stats;
+} local_time_t;
+
+// False when rule is not a POSIX TZ rule this understands
+bool local_tz_parse(const char *rule, local_tz_t *out);
+
+void local_time_init(local_time_t *lt, const local_tz_t *tz);
+
+// Like localtime_r, tm_isdst included. Not thread-safe, the owner
+// serialises calls.
+void local_time_get(local_time_t *lt, int64_t utc, struct tm *out);
+
+#endif //__LOCAL_TIME_H__
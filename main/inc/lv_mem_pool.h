@@ -0,0 +1,75 @@
+#ifndef __LV_MEM_POOL_H__
+#define __LV_MEM_POOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* LVGL allocator backend (LV_USE_STDLIB_MALLOC = LV_STDLIB_CUSTOM) over a
+ * static region of LV_MEM_POOL_SIZE bytes, so LVGL neither grows into nor
+ * fragments the heap shared with Wi-Fi and the DMA draw buffers.
+ *
+ * The region is cut into LV_MEM_POOL_PAGE_SIZE pages. Requests up to the
+ * largest size class come from per-class slab pages, larger ones take a run
+ * of whole pages. Slabs fill from the top of the region and runs from the
+ * bottom, so small long-lived objects do not split the runs.
+ *
+ * Allocations made while an arena is entered go to pages owned by that
+ * arena. A screen built in its own arena keeps its slabs apart from
+ * long-lived allocations, and releasing the arena when the screen is
+ * deleted hands its pages back as whole pages. LVGL task only. */
+
+#define LV_MEM_POOL_CLASSES 8
+// The shared arena plus one per screen_mgr screen
+#define LV_MEM_POOL_ARENAS 9
+
+typedef uint8_t lv_mem_arena_t;
+#define LV_MEM_ARENA_SHARED 0
+
+typedef struct {
+  uint16_t size;
+  uint16_t pages;      // slab pages of this class
+  uint32_t slots_used; // live allocations
+  uint32_t slots_total;
+} lv_mem_pool_class_stats_t;
+
+typedef struct {
+  uint32_t total;        // region size
+  uint32_t used;         // slab pages and runs, bytes
+  uint32_t requested;    // live allocations, slab ones at their class size
+  uint32_t max_used;     // high-water of used
+  uint32_t largest_free; // longest run of free pages, bytes
+  uint8_t frag_pct;      // 100 - largest_free / free
+  uint16_t pages_free;
+  uint16_t pages_slab;
+  uint16_t pages_run;
+  uint32_t allocs; // since lv_init
+  uint32_t live;
+  uint32_t failures;          // requests the region could not satisfy
+  uint32_t arena_releases;    // arenas closed
+  uint32_t arena_pages_freed; // pages handed back by those releases
+  uint32_t arena_survivors;   // allocations that outlived their arena
+  uint16_t arena_pages[LV_MEM_POOL_ARENAS]; // pages owned per arena
+  lv_mem_pool_class_stats_t classes[LV_MEM_POOL_CLASSES];
+} lv_mem_pool_stats_t;
+
+// Returns LV_MEM_ARENA_SHARED when all arenas are open
+lv_mem_arena_t lv_mem_arena_open(void);
+
+// Route allocations to an arena, returns the previous one to restore
+lv_mem_arena_t lv_mem_arena_enter(lv_mem_arena_t arena);
+
+/* Close an arena once everything allocated in it has been freed, normally
+ * right after deleting its screen. Its pages go back to the region at once.
+ * Allocations still alive move to the shared arena and are counted. */
+void lv_mem_arena_release(lv_mem_arena_t arena);
+
+void lv_mem_pool_get_stats(lv_mem_pool_stats_t *out);
+
+/* Used, fragmentation and largest free block in a sysmon label on the
+ * default display, refreshed every LV_MEM_POOL_MONITOR_MS. LVGL's own
+ * memory monitor is tied to its builtin allocator, this one reads the pool.
+ * Needs LV_USE_SYSMON. */
+void lv_mem_pool_monitor_show(bool show);
+
+#endif //__LV_MEM_POOL_H__
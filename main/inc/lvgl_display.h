@@ -2,6 +2,39 @@
 #define __LVGL_DISPLAY_H__
 
 #include "lvgl.h"
+
+typedef struct {
+  uint32_t windows;         // strips that needed CASET/RASET/RAMWR
+  uint32_t strips_streamed; // strips appended to the running RAMWR
+  uint32_t strips_resumed;  // strips resumed with RAMWRC after a command
+  uint32_t areas_merged;    // invalid areas coalesced into a pending one
+  uint32_t draw_bufs;       // DMA draw buffers chosen at boot
+  uint32_t draw_buf_lines;  // height of each draw buffer
+  uint32_t render_stalls;   // flushes where LVGL waited for a free buffer
+  // Tile skipping: tiles_skipped / tiles_hashed is the hit rate
+  uint32_t tiles_hashed;   // tiles compared with what the panel shows
+  uint32_t tiles_skipped;  // identical, not sent
+  uint32_t tiles_partial;  // only partly in a strip, sent unchecked
+  uint32_t strips_skipped; // flushes that sent nothing
+  uint64_t bytes_skipped;  // pixel bytes not sent
+} display_flush_stats_t;
+
+typedef struct {
+  uint32_t cmds_sent;    // panel commands that changed state
+  uint32_t cmds_skipped; // commands the shadow found redundant
+} display_panel_stats_t;
+
 lv_display_t *display_init(void);
+void display_get_flush_stats(display_flush_stats_t *out);
+void display_get_panel_stats(display_panel_stats_t *out);
+
+// Backlight in percent; lowering it fades, raising it is immediate
+void display_set_backlight(uint8_t percent);
+uint8_t display_get_backlight(void);
+// Drop tiles the panel already shows from each flush; the default comes from
+// CONFIG_EXAMPLE_LCD_FLUSH_TILE_SKIP. LVGL task only.
+void display_set_tile_skip(bool on);
+// Strips queued or on the wire to the panel
+uint32_t display_transfers_inflight(void);
 
 #endif //__LVGL_DISPLAY_H__
@@ -0,0 +1,23 @@
+#ifndef __LVGL_PORT_H__
+#define __LVGL_PORT_H__
+
+#include "lvgl.h"
+#include <stdbool.h>
+
+// Start the LVGL task. It sleeps until the next LVGL timer deadline or until
+// one of the wake functions below is called. From then on only that task may
+// call LVGL, other tasks post UI commands (ui_cmd.h).
+void lvgl_port_start(lv_display_t *display);
+
+// Switch an input device to event mode and read it on every LVGL task
+// wakeup instead of from a polling timer. Call before lvgl_port_start().
+void lvgl_port_add_indev(lv_indev_t *indev);
+
+// Have the LVGL task run lv_timer_handler now (touch, UI commands, ...)
+void lvgl_port_wake(void);
+// Same from an ISR, returns true if a higher priority task was woken
+bool lvgl_port_wake_from_isr(void);
+// Called by the panel transfer-done ISR after lv_display_flush_ready
+bool lvgl_port_flush_done_from_isr(void);
+
+#endif //__LVGL_PORT_H__
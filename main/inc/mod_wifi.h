@@ -1,7 +1,36 @@
 #ifndef __MOD_WIFI_H__
 #define __MOD_WIFI_H__
 
+#include "esp_event.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+  MOD_WIFI_STOPPED,
+  MOD_WIFI_CONNECTING, // association and DHCP in progress
+  MOD_WIFI_BACKOFF,    // disconnected, waiting before the next attempt
+  MOD_WIFI_CONNECTED,  // got an IP
+} mod_wifi_state_t;
+
+typedef struct {
+  mod_wifi_state_t state;
+  bool time_synced;       // SNTP set the clock at least once since boot
+  uint32_t attempt;       // failed attempts since the last IP
+  uint32_t retry_in_ms;   // MOD_WIFI_BACKOFF: delay before the next attempt
+  uint8_t last_reason;    // wifi_err_reason_t of the last disconnect
+  bool fast_connect;      // last IP came through the NVS cache path
+  uint32_t time_to_ip_ms; // connect start to IP, for the last IP
+} mod_wifi_status_t;
+
+// Posted to the default event loop with a mod_wifi_status_t on every change
+ESP_EVENT_DECLARE_BASE(MOD_WIFI_EVENT);
+enum {
+  MOD_WIFI_EVENT_STATUS,
+};
+
 void mod_wifi_init(void);
+// Start connecting and return, progress is reported through MOD_WIFI_EVENT
 void wifi_connection_start(void);
+void mod_wifi_get_status(mod_wifi_status_t *out);
 
 #endif //__MOD_WIFI_H__
@@ -0,0 +1,49 @@
+#ifndef __NOTIF_LIST_H__
+#define __NOTIF_LIST_H__
+
+#include "lvgl.h"
+#include "notif_ring.h"
+
+#define NOTIF_LIST_ROW_H 64
+// Rows kept bound above and below the visible ones, so a fling does not
+// show empty rows before the next rebind
+#define NOTIF_LIST_MARGIN_ROWS 2
+#define NOTIF_LIST_MAX_ROWS 16
+
+typedef struct {
+  lv_obj_t *obj;
+  lv_obj_t *title;
+  lv_obj_t *text;
+  int32_t index; // notification shown, -1 for none
+} notif_list_row_t;
+
+typedef struct {
+  uint32_t binds;      // rows pointed at another notification
+  uint32_t bind_fails; // the store could not read the record back
+} notif_list_stats_t;
+
+/* Scrolling list of a notif_ring, newest first. Only the visible rows plus
+ * NOTIF_LIST_MARGIN_ROWS above and below are widgets: notification i always
+ * goes to row i % row_count, and a row is filled again from the store when
+ * scrolling brings another notification to it. The widget count stays the
+ * same whatever the backlog. */
+typedef struct {
+  lv_obj_t *obj;    // scrollable container, size/position it like any widget
+  lv_obj_t *spacer; // sets the content height to count rows
+  lv_obj_t *empty;  // shown when there is nothing to list
+  notif_ring_t *ring;
+  notif_list_row_t rows[NOTIF_LIST_MAX_ROWS];
+  uint32_t row_count;
+  uint32_t count;         // notifications the list is laid out for
+  uint32_t appended_seen; // ring appends already laid out
+  notif_list_stats_t stats;
+} notif_list_t;
+
+// ring may be NULL, the list then stays empty
+void notif_list_init(notif_list_t *l, lv_obj_t *parent, notif_ring_t *ring);
+
+// Pick up notifications appended since the last call. The rows already
+// scrolled to stay in place.
+void notif_list_refresh(notif_list_t *l);
+
+#endif //__NOTIF_LIST_H__
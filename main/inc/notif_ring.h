@@ -0,0 +1,91 @@
+#ifndef __NOTIF_RING_H__
+#define __NOTIF_RING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Notifications as a log in a flash region of erase sectors, used as a ring:
+ *
+ *   sector: magic:u32 | seq:u32 | record ... | 0xff ...
+ *   record: len:u16 | crc:u16 | time:u32 | app:u8 | title_len:u8 |
+ *           title | text | pad to 4
+ *
+ * len counts the record from time on, without the padding; 0xffff is the
+ * erased end of a sector. The CRC is CRC-16/CCITT-FALSE over those bytes.
+ * The record goes in before its length, so a write cut short by a reset
+ * never reads as a record. When the newest sector is full the oldest one is
+ * erased and reused, dropping its notifications. Records never span
+ * sectors. RAM holds per-sector counts and the record offsets of one
+ * sector, whatever the backlog. */
+
+#define NOTIF_RING_MAGIC 0x3146544e // "NTF1"
+#define NOTIF_RING_SECTOR_SIZE 4096
+#define NOTIF_RING_MAX_SECTORS 32
+#define NOTIF_TITLE_MAX 32
+#define NOTIF_TEXT_MAX 160
+// Smallest record with its padding, bounds the records a sector holds
+#define NOTIF_RING_MIN_RECORD 12
+
+// Flash access, offsets from the start of the region. Erase takes whole
+// sectors and leaves them reading 0xff, writes only clear bits.
+typedef struct {
+  bool (*read)(void *ctx, uint32_t offset, void *dst, uint32_t len);
+  bool (*write)(void *ctx, uint32_t offset, const void *src, uint32_t len);
+  bool (*erase)(void *ctx, uint32_t offset, uint32_t len);
+  void *ctx;
+  uint32_t size; // bytes, at least two sectors
+} notif_flash_t;
+
+typedef struct {
+  uint32_t time; // unix seconds from the phone
+  uint8_t app;   // source app id, picks the row's icon
+  char title[NOTIF_TITLE_MAX + 1];
+  char text[NOTIF_TEXT_MAX + 1];
+} notif_t;
+
+typedef struct {
+  uint32_t seq;   // age of the sector's contents, 0 when it holds none
+  uint16_t count; // records
+  uint16_t used;  // bytes, header included
+} notif_sector_t;
+
+typedef struct {
+  uint32_t appended;
+  uint32_t dropped; // erased with the oldest sector
+  uint32_t erases;
+  uint32_t torn;         // records cut short by a reset, found at mount
+  uint32_t index_builds; // sectors walked to find their records
+} notif_ring_stats_t;
+
+/* Not thread-safe, the owner serialises all calls. */
+typedef struct {
+  notif_flash_t flash;
+  notif_sector_t sectors[NOTIF_RING_MAX_SECTORS];
+  uint32_t sector_count;
+  uint32_t head; // sector appended to, valid when count or sectors[head].seq
+  uint32_t count;
+  // Record offsets of the last sector read from, oldest first, so
+  // scrolling through it reads each record directly
+  uint32_t index_sector; // NOTIF_RING_MAX_SECTORS for none
+  uint16_t index[NOTIF_RING_SECTOR_SIZE / NOTIF_RING_MIN_RECORD];
+  notif_ring_stats_t stats;
+} notif_ring_t;
+
+// Scan the region and pick up the log where it stopped. An erased or
+// foreign region mounts empty and is formatted sector by sector as it fills.
+bool notif_ring_mount(notif_ring_t *r, const notif_flash_t *flash);
+
+// Longer titles and texts are cut, they are display-only
+bool notif_ring_append(notif_ring_t *r, const notif_t *n);
+
+// 0 is the newest. False past the end or when the record does not read back.
+bool notif_ring_get(notif_ring_t *r, uint32_t index, notif_t *out);
+
+static inline uint32_t notif_ring_count(const notif_ring_t *r) {
+  return r->count;
+}
+
+// Erase everything
+bool notif_ring_clear(notif_ring_t *r);
+
+#endif //__NOTIF_RING_H__
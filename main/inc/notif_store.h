@@ -0,0 +1,17 @@
+#ifndef __NOTIF_STORE_H__
+#define __NOTIF_STORE_H__
+
+#include "notif_ring.h"
+#include <stdbool.h>
+
+#define NOTIF_PARTITION_LABEL "notif"
+
+/* Notifications kept across reboots in the "notif" data partition, as a
+ * notif_ring log. False when the partition is missing, the watch then keeps
+ * none. LVGL task only after boot, other tasks post a UI command. */
+bool notif_store_init(void);
+
+// NULL when the store is not mounted
+notif_ring_t *notif_store_ring(void);
+
+#endif //__NOTIF_STORE_H__
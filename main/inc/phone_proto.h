@@ -0,0 +1,182 @@
+#ifndef __PHONE_PROTO_H__
+#define __PHONE_PROTO_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Wire format of the watch-phone command/status channel (W-BLE-2). A packet
+ * is one transport write, a BLE notification or GATT write, and carries one
+ * or more frames back to back:
+ *
+ *   len:u16 | version:u8 | type:u8 | payload[len - 4] | crc:u16
+ *
+ * len counts the whole frame from the length field to the CRC. The CRC is
+ * CRC-16/CCITT-FALSE over everything before it. Little-endian throughout.
+ * Frames are parsed in place: payloads and strings point into the receive
+ * buffer and are only valid as long as it is. */
+
+#define PHONE_PROTO_VERSION 1
+#define PHONE_PROTO_FRAME_OVERHEAD 6
+// Largest frame payload, keeps every frame inside a minimum-size packet
+#define PHONE_PROTO_MAX_PAYLOAD 200
+// ATT payload of a 247-byte MTU, what current phones negotiate
+#define PHONE_PROTO_DEFAULT_MTU 244
+// Largest ATT payload, packets are never longer
+#define PHONE_PROTO_MAX_MTU 512
+#define PHONE_PROTO_MIN_MTU                                                    \
+  (PHONE_PROTO_MAX_PAYLOAD + PHONE_PROTO_FRAME_OVERHEAD)
+
+typedef enum {
+  PHONE_MSG_TIME_SYNC = 1,   // phone -> watch
+  PHONE_MSG_STEPS = 2,       // watch -> phone, status
+  PHONE_MSG_BATTERY = 3,     // watch -> phone, status
+  PHONE_MSG_MEDIA_STATE = 4, // phone -> watch, status (Spotify)
+  PHONE_MSG_MEDIA_CMD = 5,   // watch -> phone, command
+  PHONE_MSG_TYPE_COUNT,
+} phone_msg_type_t;
+
+typedef enum {
+  PHONE_PROTO_OK,
+  PHONE_PROTO_END,         // no more frames in the packet
+  PHONE_PROTO_ERR_SHORT,   // frame runs past the end of the packet
+  PHONE_PROTO_ERR_LEN,     // payload length outside 0..MAX_PAYLOAD
+  PHONE_PROTO_ERR_CRC,     // frame corrupted
+  PHONE_PROTO_ERR_VERSION, // frame from an incompatible peer, skipped
+  PHONE_PROTO_ERR_COUNT,
+} phone_proto_err_t;
+
+extern const char *const phone_proto_err_names[];
+
+typedef struct {
+  uint8_t version;
+  uint8_t type;           // phone_msg_type_t, or newer types to ignore
+  const uint8_t *payload; // into the packet
+  uint16_t len;
+} phone_proto_frame_t;
+
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+} phone_proto_reader_t;
+
+void phone_proto_reader_init(phone_proto_reader_t *r, const void *packet,
+                             size_t len);
+
+/* Next frame of the packet. After ERR_VERSION the reader is past the frame
+ * and parsing can go on; after any other error the rest of the packet is
+ * dropped and the next call returns PHONE_PROTO_END. */
+phone_proto_err_t phone_proto_next(phone_proto_reader_t *r,
+                                   phone_proto_frame_t *frame);
+
+uint16_t phone_proto_crc16(uint16_t crc, const void *data, size_t len);
+
+/* Payloads. Decoders accept payloads longer than they know, so a newer peer
+ * can append fields, and return false when one is too short. Strings are
+ * not NUL-terminated. */
+
+typedef struct {
+  uint32_t unix_s;
+  int16_t utc_offset_min;
+} phone_time_sync_t;
+
+typedef struct {
+  uint32_t steps; // since local midnight
+} phone_steps_t;
+
+typedef struct {
+  uint8_t percent;
+  bool charging;
+} phone_battery_t;
+
+typedef struct {
+  bool playing;
+  uint16_t position_s;
+  uint16_t duration_s;
+  const char *title;
+  uint8_t title_len;
+  const char *artist;
+  uint8_t artist_len;
+} phone_media_state_t;
+
+typedef enum {
+  PHONE_MEDIA_PLAY_PAUSE,
+  PHONE_MEDIA_NEXT,
+  PHONE_MEDIA_PREVIOUS,
+} phone_media_cmd_t;
+
+// Encoders return the payload size, 0 when out is too small
+size_t phone_proto_encode_time_sync(const phone_time_sync_t *m, uint8_t *out,
+                                    size_t cap);
+size_t phone_proto_encode_steps(const phone_steps_t *m, uint8_t *out,
+                                size_t cap);
+size_t phone_proto_encode_battery(const phone_battery_t *m, uint8_t *out,
+                                  size_t cap);
+size_t phone_proto_encode_media_state(const phone_media_state_t *m,
+                                      uint8_t *out, size_t cap);
+size_t phone_proto_encode_media_cmd(phone_media_cmd_t cmd, uint8_t *out,
+                                    size_t cap);
+
+bool phone_proto_decode_time_sync(const phone_proto_frame_t *f,
+                                  phone_time_sync_t *m);
+bool phone_proto_decode_steps(const phone_proto_frame_t *f, phone_steps_t *m);
+bool phone_proto_decode_battery(const phone_proto_frame_t *f,
+                                phone_battery_t *m);
+bool phone_proto_decode_media_state(const phone_proto_frame_t *f,
+                                    phone_media_state_t *m);
+bool phone_proto_decode_media_cmd(const phone_proto_frame_t *f,
+                                  phone_media_cmd_t *cmd);
+
+typedef struct {
+  uint8_t *buf;
+  size_t cap; // the transport's MTU
+  size_t len;
+} phone_proto_writer_t;
+
+void phone_proto_writer_init(phone_proto_writer_t *w, void *buf, size_t cap);
+
+// Append a frame, false if it does not fit what is left of the packet
+bool phone_proto_write(phone_proto_writer_t *w, uint8_t type,
+                       const void *payload, size_t len);
+
+/* Sends packets. Implemented per link: BLE on the watch, a socket pair on
+ * the host. Returns 0 once the packet is queued. */
+typedef struct {
+  int (*send)(void *ctx, const void *packet, size_t len);
+  void *ctx;
+  uint16_t mtu;
+} phone_proto_transport_t;
+
+/* Status updates waiting for the next packet. Only the newest update of each
+ * type is kept: a step count that is superseded before it goes out is never
+ * sent. Pending updates go out together in as few packets as fit. */
+typedef struct {
+  uint8_t payload[PHONE_MSG_TYPE_COUNT][PHONE_PROTO_MAX_PAYLOAD];
+  uint8_t len[PHONE_MSG_TYPE_COUNT];
+  uint32_t pending; // bit per type
+  uint32_t posted;
+  uint32_t superseded;
+  uint32_t packets;
+  uint32_t frames;
+} phone_proto_coalescer_t;
+
+void phone_proto_coalescer_init(phone_proto_coalescer_t *c);
+
+// Queue a status payload, false for an unknown type or oversized payload
+bool phone_proto_post(phone_proto_coalescer_t *c, phone_msg_type_t type,
+                      const void *payload, size_t len);
+
+bool phone_proto_pending(const phone_proto_coalescer_t *c);
+
+/* Pack pending updates into one packet of at most mtu bytes, in type order.
+ * Returns its length, 0 when nothing is pending. mtu is at least
+ * PHONE_PROTO_MIN_MTU, which the link negotiates before any traffic. */
+size_t phone_proto_coalesce(phone_proto_coalescer_t *c, void *packet,
+                            size_t mtu);
+
+/* Send everything pending, returns the packets sent or the negative send
+ * error. The packet that failed stays pending. */
+int phone_proto_flush(phone_proto_coalescer_t *c,
+                      const phone_proto_transport_t *t);
+
+#endif //__PHONE_PROTO_H__
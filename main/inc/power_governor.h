@@ -0,0 +1,49 @@
+#ifndef __POWER_GOVERNOR_H__
+#define __POWER_GOVERNOR_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+  POWER_GOVERNOR_INTERACTIVE, // input within the hold time, full frame rate
+  POWER_GOVERNOR_ANIMATING,   // no input but LVGL animations are running
+  POWER_GOVERNOR_IDLE,        // static screen, only the clock ticks
+  POWER_GOVERNOR_DIMMED,      // idle long enough to dim the backlight
+  POWER_GOVERNOR_STATE_COUNT,
+} power_governor_state_t;
+
+typedef struct {
+  uint32_t interactive_period_ms;
+  uint32_t animating_period_ms;
+  uint32_t idle_period_ms;
+  uint32_t interactive_hold_ms; // stay interactive this long after the input
+  uint32_t dim_after_ms;        // inactivity before the backlight dims
+  uint8_t backlight_full;       // percent
+  uint8_t backlight_dim;        // percent
+} power_governor_config_t;
+
+/* Picks the display refresh period and backlight level from UI activity.
+ * Pure state machine: the LVGL task feeds it the time since the last input
+ * and whether animations run, a host tool feeds it simulated traces. */
+typedef struct {
+  power_governor_config_t cfg;
+  power_governor_state_t state;
+  uint32_t entered_ms; // when the current state was entered
+  uint32_t time_in_state_ms[POWER_GOVERNOR_STATE_COUNT];
+  uint32_t transitions;
+} power_governor_t;
+
+extern const char *const power_governor_state_names[];
+
+void power_governor_init(power_governor_t *g,
+                         const power_governor_config_t *cfg, uint32_t now_ms);
+
+// Returns true when the state changed, the period and backlight then need
+// to be applied
+bool power_governor_update(power_governor_t *g, uint32_t now_ms,
+                           uint32_t inactive_ms, bool animating);
+
+uint32_t power_governor_period_ms(const power_governor_t *g);
+uint8_t power_governor_backlight(const power_governor_t *g);
+
+#endif //__POWER_GOVERNOR_H__
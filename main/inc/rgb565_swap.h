@@ -0,0 +1,10 @@
+#ifndef __RGB565_SWAP_H__
+#define __RGB565_SWAP_H__
+
+#include <stddef.h>
+
+// Byte-swap px_count RGB565 pixels in place, two pixels per 32-bit word.
+// buf must be at least 2-byte aligned.
+void rgb565_swap_words(void *buf, size_t px_count);
+
+#endif //__RGB565_SWAP_H__
@@ -0,0 +1,50 @@
+#ifndef __SCREEN_MGR_H__
+#define __SCREEN_MGR_H__
+
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCREEN_MGR_MAX_SCREENS 8
+
+typedef struct {
+  const char *name;
+  // Build the widgets on a fresh screen. Runs on the first visit and again
+  // after an eviction, so state that must survive lives outside the widgets
+  void (*create)(lv_obj_t *screen);
+  // Changes every second, a bitmap of it is only reused while that fresh
+  bool ticks;
+} screen_def_t;
+
+typedef struct {
+  uint32_t created;        // first visits plus rebuilds after eviction
+  uint32_t evicted;        // screens deleted to get under the heap budget
+  uint32_t live;           // screens with widgets right now
+  uint32_t snapshots;      // bitmaps rendered for transitions
+  uint32_t swipe_renders;  // of which rendered when a swipe started
+  uint32_t snapshot_hits;  // bitmaps a swipe reused
+  uint32_t live_fallbacks; // swipes animated live, no heap for bitmaps
+  uint32_t heap_used;      // LVGL heap after the last screen change
+  uint32_t snapshot_bytes; // bitmaps kept, outside the LVGL heap
+} screen_mgr_stats_t;
+
+/* Screens in swipe order, left to right. Screens are created on their first
+ * visit. When the LVGL heap goes over heap_budget, the least recently shown
+ * ones are deleted. Swipes slide bitmaps of the two screens instead of their
+ * widget trees. The bitmaps are rendered while input is idle where they can
+ * be, so a swipe mostly starts without rendering. Once per display, LVGL
+ * task only. */
+void screen_mgr_init(lv_display_t *disp, const screen_def_t *defs,
+                     uint32_t count, uint32_t heap_budget);
+
+// Show a screen without a transition
+void screen_mgr_show(uint32_t index);
+
+// Slide to the next (dir > 0) or previous screen, false at either end or
+// while a swipe is running
+bool screen_mgr_swipe(int dir);
+
+uint32_t screen_mgr_active(void);
+void screen_mgr_get_stats(screen_mgr_stats_t *out);
+
+#endif //__SCREEN_MGR_H__
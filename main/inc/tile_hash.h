@@ -0,0 +1,69 @@
+#ifndef __TILE_HASH_H__
+#define __TILE_HASH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Tiles are TILE_HASH_SIZE pixels square on a grid anchored at (0, 0)
+#define TILE_HASH_SIZE 16
+// A flushed strip is sent as at most this many windows
+#define TILE_HASH_MAX_SPANS 8
+// Hash of a tile whose panel content is not known
+#define TILE_HASH_UNKNOWN 0
+
+/* Flush filter for RGB565 strips: remembers a 32-bit hash of what each tile
+ * of the panel shows and drops the tiles of a strip that hash the same, so
+ * pixels LVGL re-rendered unchanged are not sent again. Only tiles a strip
+ * covers whole are compared; the rest are always sent and forgotten, which
+ * is why invalid areas should be rounded out to the grid. */
+typedef struct {
+  uint32_t tiles_hashed;   // tiles compared against the panel
+  uint32_t tiles_skipped;  // of those, identical and not sent
+  uint32_t tiles_partial;  // tiles a strip only partly covered
+  uint32_t strips_skipped; // strips with nothing left to send
+  uint64_t bytes_skipped;  // pixel bytes not sent
+} tile_hash_stats_t;
+
+typedef struct {
+  int32_t x1; // inclusive, display coordinates
+  int32_t y1;
+  int32_t x2;
+  int32_t y2;
+  size_t offset; // the span's packed pixels start at this byte of the strip
+} tile_hash_span_t;
+
+typedef struct {
+  uint32_t *hashes; // row-major, TILE_HASH_UNKNOWN until a tile is sent whole
+  uint32_t capacity;
+  int32_t hor_res;
+  int32_t ver_res;
+  uint32_t cols;
+  uint32_t rows;
+  tile_hash_stats_t stats;
+} tile_hash_t;
+
+// hashes holds capacity tiles, enough for the display in any rotation
+void tile_hash_init(tile_hash_t *t, uint32_t *hashes, uint32_t capacity);
+
+// Lay the grid over a display of this size, forgetting what the panel shows.
+// Returns false when the grid needs more tiles than the table holds.
+bool tile_hash_set_resolution(tile_hash_t *t, int32_t hor_res,
+                              int32_t ver_res);
+
+// The panel content is unknown again, e.g. after a controller reset
+void tile_hash_reset(tile_hash_t *t);
+
+// Grow an area (inclusive corners) to whole tiles, clipped to the display
+void tile_hash_round(const tile_hash_t *t, int32_t *x1, int32_t *y1,
+                     int32_t *x2, int32_t *y2);
+
+/* Compare the strip's tiles with the panel and record the new hashes. The
+ * pixels of the tiles that changed are packed in place at the start of px,
+ * one span per window to send, and the number of spans is returned; 0 means
+ * the panel already shows the whole strip. */
+uint32_t tile_hash_filter(tile_hash_t *t, int32_t x1, int32_t y1, int32_t x2,
+                          int32_t y2, uint8_t *px,
+                          tile_hash_span_t spans[TILE_HASH_MAX_SPANS]);
+
+#endif //__TILE_HASH_H__
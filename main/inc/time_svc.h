@@ -0,0 +1,37 @@
+#ifndef __TIME_SVC_H__
+#define __TIME_SVC_H__
+
+#include "local_time.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Boundaries crossed since the last tick, a day change sets all the others
+#define TIME_SVC_SECOND (1u << 0)
+#define TIME_SVC_MINUTE (1u << 1)
+#define TIME_SVC_HOUR (1u << 2)
+#define TIME_SVC_DAY (1u << 3)
+
+typedef void (*time_svc_cb_t)(const struct tm *local, uint32_t changed,
+                              void *arg);
+
+/* Local wall-clock time for the watch. The TZ rule is parsed once into a
+ * local_time_t, and one timer of the timer service ticks just after the
+ * next boundary any subscriber wants, read from the system clock each time
+ * so SNTP corrections show up at the next tick. Subscribers are called with
+ * the boundaries crossed.
+ *
+ * LVGL task only, like the timer service, or before lvgl_port_start(). */
+void time_svc_init(const char *tz_rule);
+
+// False when all TIME_SVC_MAX_SUBSCRIBERS slots are taken
+bool time_svc_subscribe(uint32_t events, time_svc_cb_t cb, void *arg);
+
+void time_svc_now(struct tm *out);
+
+// Tick now, after the system clock was set. ui_cmd_post_call() compatible.
+void time_svc_resync(void *arg);
+
+void time_svc_get_stats(local_time_stats_t *out);
+
+#endif //__TIME_SVC_H__
@@ -0,0 +1,32 @@
+#ifndef __TIMER_SVC_H__
+#define __TIMER_SVC_H__
+
+#include "timer_wheel.h"
+#include <stdint.h>
+
+typedef struct {
+  timer_wheel_stats_t wheel;
+  uint32_t runs;    // wheel advances run in the LVGL task
+  uint32_t arms;    // esp_timer re-armed for a new deadline
+  uint32_t retries; // UI command queue was full, tried again later
+} timer_svc_stats_t;
+
+/* Every periodic job of the watch (clock tick, Pomodoro, vibration patterns,
+ * status polls) is a timer in one wheel instead of a task of its own. A
+ * single esp_timer one-shot is armed for the earliest deadline, and when it
+ * fires the wheel is advanced by a UI command, so all callbacks run in the
+ * LVGL task and may touch LVGL. Times are esp_timer ms.
+ *
+ * Call the functions below from the LVGL task only, or before
+ * lvgl_port_start(). Other tasks post a UI command that calls them. */
+void timer_svc_init(void);
+
+void timer_svc_start(timer_wheel_timer_t *t, uint32_t delay_ms,
+                     uint32_t period_ms);
+void timer_svc_stop(timer_wheel_timer_t *t);
+void timer_svc_pause(timer_wheel_timer_t *t);
+void timer_svc_resume(timer_wheel_timer_t *t);
+
+void timer_svc_get_stats(timer_svc_stats_t *out);
+
+#endif //__TIMER_SVC_H__
@@ -0,0 +1,82 @@
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Slots per level and the bits of the deadline each level indexes with
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVELS 4
+// Deadlines further out than this wait in an overflow list
+#define TIMER_WHEEL_SPAN_BITS (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)
+
+typedef enum {
+  TIMER_WHEEL_IDLE,
+  TIMER_WHEEL_ARMED,
+  TIMER_WHEEL_PAUSED,
+} timer_wheel_state_t;
+
+struct timer_wheel_timer;
+typedef void (*timer_wheel_cb_t)(struct timer_wheel_timer *t);
+
+/* Caller-owned timer, linked into the wheel while armed. Times are in ms on
+ * whatever clock the owner advances the wheel with. */
+typedef struct timer_wheel_timer {
+  struct timer_wheel_timer *next;
+  struct timer_wheel_timer *prev;
+  uint64_t expires;
+  uint32_t period;    // 0 for one-shot
+  uint32_t remaining; // PAUSED: time that was left
+  uint8_t state;      // timer_wheel_state_t
+  uint8_t level;      // TIMER_WHEEL_LEVELS for the overflow list
+  timer_wheel_cb_t cb;
+  void *arg;
+} timer_wheel_timer_t;
+
+typedef struct {
+  uint32_t armed;    // timers in the wheel
+  uint32_t fired;    // callbacks run
+  uint32_t cascaded; // timers moved down a level
+  uint32_t advances; // timer_wheel_advance calls that moved time
+} timer_wheel_stats_t;
+
+/* Hierarchical timing wheel: level L keys a timer by bits 6L..6L+5 of its
+ * deadline once the bits above match the current time, so inserting and
+ * stopping are O(1) and a timer moves down at most once per level. Time
+ * can jump straight to the next deadline, nothing runs per elapsed ms.
+ * Not thread-safe, the owner serialises all calls. */
+typedef struct {
+  uint64_t now;
+  timer_wheel_timer_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint64_t occupied[TIMER_WHEEL_LEVELS]; // bit per non-empty slot
+  timer_wheel_timer_t *overflow;
+  timer_wheel_stats_t stats;
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t *w, uint64_t now);
+
+void timer_wheel_timer_init(timer_wheel_timer_t *t, timer_wheel_cb_t cb,
+                            void *arg);
+
+// Fire after delay ms, then every period ms unless period is 0. Restarts an
+// armed or paused timer.
+void timer_wheel_start(timer_wheel_t *w, timer_wheel_timer_t *t,
+                       uint32_t delay, uint32_t period);
+
+void timer_wheel_stop(timer_wheel_t *w, timer_wheel_timer_t *t);
+
+// Keep the time left and take the timer out of the wheel until resumed
+void timer_wheel_pause(timer_wheel_t *w, timer_wheel_timer_t *t);
+void timer_wheel_resume(timer_wheel_t *w, timer_wheel_timer_t *t);
+
+// Earliest deadline of an armed timer. Returns false when none is armed.
+bool timer_wheel_next(const timer_wheel_t *w, uint64_t *deadline);
+
+/* Move time forward to now and run the callbacks of every timer due on the
+ * way, in deadline order. Periodic timers are re-armed from their deadline,
+ * so they do not drift with late calls. Callbacks may start and stop
+ * timers. Returns the number of callbacks run. */
+uint32_t timer_wheel_advance(timer_wheel_t *w, uint64_t now);
+
+#endif //__TIMER_WHEEL_H__
@@ -0,0 +1,55 @@
+#ifndef __TOUCH_CAL_H__
+#define __TOUCH_CAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Affine touch calibration in Q16 fixed point, the C6 has no FPU:
+ *
+ *   x' = (a * x + b * y + c) >> 16
+ *   y' = (d * x + e * y + f) >> 16
+ *
+ * Solved once from three touches on known targets, then applied to every
+ * sample with four multiplies. Rotations compose into the same six numbers,
+ * so a calibrated and rotated point still costs one transform. */
+typedef struct {
+  int32_t a, b, c;
+  int32_t d, e, f;
+} touch_cal_t;
+
+typedef struct {
+  int32_t x;
+  int32_t y;
+} touch_cal_point_t;
+
+// Coefficients past this, in Q16, are a bad calibration, and the sums in
+// touch_cal_apply stay in 32 bits for panel-sized inputs
+#define TOUCH_CAL_MAX_SCALE (8 << 16)
+#define TOUCH_CAL_MAX_OFFSET (4096 << 16)
+// Twice the area of the target triangle, in raw units, below which the
+// touches are too close or too close to a line to solve from
+#define TOUCH_CAL_MIN_DET 1024
+
+void touch_cal_identity(touch_cal_t *cal);
+
+/* The transform taking each raw point to its target. False when the raw
+ * points are degenerate or the result is out of range, *out is untouched. */
+bool touch_cal_solve(const touch_cal_point_t raw[3],
+                     const touch_cal_point_t target[3], touch_cal_t *out);
+
+/* Follow cal with an LVGL display rotation (lv_display_rotation_t, quarter
+ * turns clockwise), mapping the way lv_indev does: hor_res and ver_res are
+ * the unrotated resolution. unrotate is the inverse. */
+void touch_cal_rotate(const touch_cal_t *cal, uint8_t rotation,
+                      int32_t hor_res, int32_t ver_res, touch_cal_t *out);
+void touch_cal_unrotate(const touch_cal_t *cal, uint8_t rotation,
+                        int32_t hor_res, int32_t ver_res, touch_cal_t *out);
+
+static inline void touch_cal_apply(const touch_cal_t *cal, int32_t x,
+                                   int32_t y, int32_t *out_x,
+                                   int32_t *out_y) {
+  *out_x = (cal->a * x + cal->b * y + cal->c + (1 << 15)) >> 16;
+  *out_y = (cal->d * x + cal->e * y + cal->f + (1 << 15)) >> 16;
+}
+
+#endif //__TOUCH_CAL_H__
@@ -4,4 +4,11 @@
 #include "display/lv_display_private.h"
 void touch_controller_init(lv_display_t *display);
 
+/* Put up three targets and solve the touch calibration from the touches on
+ * them, then keep it in NVS. LVGL task, post it with ui_cmd_post_call. */
+void touch_controller_calibrate(void *arg);
+
+// Back to the uncalibrated mapping, forgetting the stored one. LVGL task.
+void touch_controller_reset_calibration(void *arg);
+
 #endif //__TOUCH_CONTROLLER_H__
@@ -0,0 +1,30 @@
+#ifndef __TOUCH_FILTER_H__
+#define __TOUCH_FILTER_H__
+
+#include <stdint.h>
+
+#define TOUCH_FILTER_MEDIAN_LEN 3
+
+/* Per-stroke smoothing for resistive touch samples: a 3-tap median drops
+ * single-sample spikes, then a first-order IIR takes out the jitter. Reset
+ * between strokes so a new press does not drift in from the last one. */
+typedef struct {
+  uint16_t x[TOUCH_FILTER_MEDIAN_LEN];
+  uint16_t y[TOUCH_FILTER_MEDIAN_LEN];
+  uint8_t count; // samples in the median window, saturates at its length
+  uint8_t next;  // median window slot the next sample goes to
+  uint8_t alpha; // weight of a new sample in the IIR, Q8, 0 = no smoothing
+  int32_t iir_x; // Q8
+  int32_t iir_y; // Q8
+} touch_filter_t;
+
+void touch_filter_init(touch_filter_t *f, uint8_t alpha_q8);
+
+// Start a new stroke
+void touch_filter_reset(touch_filter_t *f);
+
+// Feed one raw sample and get the filtered point
+void touch_filter_push(touch_filter_t *f, uint16_t x, uint16_t y,
+                       uint16_t *out_x, uint16_t *out_y);
+
+#endif //__TOUCH_FILTER_H__
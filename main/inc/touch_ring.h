@@ -0,0 +1,42 @@
+#ifndef __TOUCH_RING_H__
+#define __TOUCH_RING_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Power of two
+#define TOUCH_RING_LEN 32
+
+typedef struct {
+  int64_t time_us; // esp_timer time the sample was taken
+  uint16_t x;
+  uint16_t y;
+  bool pressed;
+} touch_event_t;
+
+/* Single-producer single-consumer ring between the touch sampling task and
+ * the LVGL read callback. Neither side blocks or takes a lock. */
+typedef struct {
+  touch_event_t events[TOUCH_RING_LEN];
+  _Atomic uint32_t head; // next slot to write, producer only
+  _Atomic uint32_t tail; // next slot to read, consumer only
+  _Atomic uint32_t dropped; // events lost to a full ring
+} touch_ring_t;
+
+void touch_ring_init(touch_ring_t *r);
+
+// Producer side. Returns false and counts a drop when the ring is full.
+bool touch_ring_push(touch_ring_t *r, const touch_event_t *ev);
+
+// Consumer side. Returns false when the ring is empty.
+bool touch_ring_pop(touch_ring_t *r, touch_event_t *ev);
+
+bool touch_ring_empty(touch_ring_t *r);
+
+// Producer side, a push would fail
+bool touch_ring_full(touch_ring_t *r);
+
+uint32_t touch_ring_dropped(touch_ring_t *r);
+
+#endif //__TOUCH_RING_H__
@@ -0,0 +1,31 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "trace_stats.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Power of two
+#define TRACE_RING_LEN 1024
+
+typedef struct {
+  trace_hist_t stages[TRACE_STAGE_COUNT];
+  uint32_t over_budget; // interactions over TOUCH_LATENCY_BUDGET_MS
+  uint32_t lost;        // events overwritten before trace_collect() saw them
+} trace_summary_t;
+
+// Record an event. Lock-free, callable from any task or ISR.
+void trace_event(trace_event_id_t id, uint16_t arg);
+
+// Run new events through the touch-to-photon correlator into the summary.
+// Single consumer: only call from the LVGL task.
+void trace_collect(void);
+
+const trace_summary_t *trace_get_summary(void);
+
+void trace_reset_summary(void);
+
+// Copy up to max of the newest events out, oldest first. Returns the count.
+size_t trace_snapshot(trace_record_t *out, size_t max);
+
+#endif //__TRACE_H__
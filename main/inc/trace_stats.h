@@ -0,0 +1,74 @@
+#ifndef __TRACE_STATS_H__
+#define __TRACE_STATS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Trace points on the touch-to-photon path, in pipeline order
+typedef enum {
+  TRACE_TOUCH_SAMPLE,   // touch task read the panel, arg: pressed
+  TRACE_INPUT_DISPATCH, // LVGL read callback took a sample, arg: pressed
+  TRACE_RENDER_START,   // LVGL started a refresh
+  TRACE_RENDER_END,     // LVGL rendered it all, arg: strips still in flight
+  TRACE_FLUSH_SUBMIT,   // strip queued to the panel, arg: last of the frame
+  TRACE_FLUSH_DONE,     // strip transfer finished, arg: strips still in flight
+  TRACE_EVENT_COUNT,
+} trace_event_id_t;
+
+/* One trace event as stored in the ring and dumped over the console. 8 bytes,
+ * little-endian on both the ESP32-C6 and the host. */
+typedef struct {
+  uint32_t time_us; // low 32 bits of esp_timer_get_time()
+  uint16_t arg;
+  uint8_t id;  // trace_event_id_t
+  uint8_t lap; // ring pass that wrote the slot, 0 = never written
+} trace_record_t;
+
+// Stages of one interaction, TRACE_STAGE_TOTAL is their sum
+typedef enum {
+  TRACE_STAGE_INPUT,    // touch sample -> LVGL took it
+  TRACE_STAGE_QUEUE,    // LVGL took it -> render start
+  TRACE_STAGE_RENDER,   // render start -> render end
+  TRACE_STAGE_TRANSFER, // render end -> last strip on the panel
+  TRACE_STAGE_TOTAL,
+  TRACE_STAGE_COUNT,
+} trace_stage_t;
+
+typedef struct {
+  uint32_t touch_us; // time of the touch sample that started it
+  uint32_t stage_us[TRACE_STAGE_COUNT];
+} trace_interaction_t;
+
+/* Follows one touch sample through the pipeline. Samples that arrive while
+ * one is already being followed are not measured. */
+typedef struct {
+  uint32_t phase;
+  uint32_t t[TRACE_STAGE_COUNT];
+} trace_correlator_t;
+
+// Log-linear latency histogram: exact below 8 µs, 8 buckets per power of two
+// above, up to about 4 s
+#define TRACE_HIST_BUCKETS 160
+
+typedef struct {
+  uint32_t buckets[TRACE_HIST_BUCKETS];
+  uint32_t count;
+  uint32_t max_us;
+  uint64_t sum_us;
+} trace_hist_t;
+
+extern const char *const trace_stage_names[TRACE_STAGE_COUNT];
+
+void trace_correlator_init(trace_correlator_t *c);
+
+// Feed events in time order. Returns true when rec completed an interaction,
+// which is then written to out.
+bool trace_correlator_feed(trace_correlator_t *c, const trace_record_t *rec,
+                           trace_interaction_t *out);
+
+void trace_hist_add(trace_hist_t *h, uint32_t us);
+
+// Upper bound of the bucket holding the given percentile, 0 when empty
+uint32_t trace_hist_percentile(const trace_hist_t *h, uint32_t percent);
+
+#endif //__TRACE_STATS_H__
@@ -3,10 +3,20 @@
 #define __UI_H__
 
 #include "lvgl.h"
+#include "notif_list.h"
 
 void lv_screen(lv_disp_t *disp);
-void increment_time();
 void update_time_display();
 void set_time(uint8_t h, uint8_t m, uint8_t s);
 
+// Store a notification and show it if the list is up. False when the store
+// is not mounted or the write failed.
+bool ui_add_notification(const notif_t *n);
+// Notifications screen, NULL while it is not built
+notif_list_t *ui_notif_list(void);
+
+// Demo screen (lvgl_demo_ui.c), built on a screen owned by the screen manager
+void example_lvgl_demo_ui_create(lv_obj_t *scr);
+void example_lvgl_demo_ui(lv_display_t *disp);
+
 #endif //__UI_H__
@@ -0,0 +1,43 @@
+#ifndef __UI_CMD_H__
+#define __UI_CMD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Power of two
+#define UI_CMD_QUEUE_LEN 32
+
+typedef enum {
+  UI_CMD_CALL, // run fn(arg) in the LVGL task
+  UI_CMD_TYPE_COUNT,
+} ui_cmd_type_t;
+
+typedef struct {
+  ui_cmd_type_t type;
+  union {
+    struct {
+      void (*fn)(void *arg);
+      void *arg;
+    } call;
+  };
+} ui_cmd_t;
+
+typedef struct {
+  uint32_t posted;
+  uint32_t dropped; // queue was full
+  uint32_t applied;
+} ui_cmd_stats_t;
+
+/* Queue a command for the LVGL task and wake it. Lock-free and never blocks,
+ * callable from any task. Returns false when the queue is full. */
+bool ui_cmd_post(const ui_cmd_t *cmd);
+
+bool ui_cmd_post_call(void (*fn)(void *arg), void *arg);
+
+// LVGL task only: apply everything queued so far, in order. Returns the
+// number of commands applied.
+uint32_t ui_cmd_dispatch(void);
+
+void ui_cmd_get_stats(ui_cmd_stats_t *out);
+
+#endif //__UI_CMD_H__
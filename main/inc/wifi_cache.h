@@ -0,0 +1,30 @@
+#ifndef __WIFI_CACHE_H__
+#define __WIFI_CACHE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Last good association and IP setup, kept in NVS so the next boot can skip
+ * the full scan and DHCP. Addresses are esp_ip4_addr_t values. */
+typedef struct {
+  uint32_t ssid_crc; // SSID the entry belongs to
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip;
+  uint32_t netmask;
+  uint32_t gw;
+  uint32_t dns;
+  // UTC second the DHCP lease runs out, 0 when the clock was not set yet
+  uint32_t lease_end;
+} wifi_cache_t;
+
+// False when there is no entry, or it is for another SSID
+bool wifi_cache_load(const char *ssid, wifi_cache_t *out);
+
+// Stores the entry for ssid, skips the flash write when nothing changed
+void wifi_cache_save(const char *ssid, wifi_cache_t *entry);
+
+void wifi_cache_erase(void);
+
+#endif //__WIFI_CACHE_H__
@@ -3,65 +3,60 @@
  *
  * SPDX-License-Identifier: CC0-1.0
  */
+#include "app_console.h"
+#include "assets.h"
+#include "boot.h"
 #include "config.h"
+#include "dlog.h"
 #include "esp_log.h"
+#include "esp_pm.h"
 #include "freertos/task.h"
 #include "lvgl_display.h"
+#include "lvgl_port.h"
 #include "mod_wifi.h"
+#include "notif_store.h"
 #include "nvs_flash.h"
+#include "time_svc.h"
+#include "timer_svc.h"
 #include "touch_controller.h"
 #include "ui.h"
+#include "ui_cmd.h"
 #include <stdio.h>
-#include <sys/lock.h>
-#include <sys/param.h>
-#include <time.h>
-#include <unistd.h>
-
-static const char *TAG = "MAIN";
-
-// LVGL library is not thread-safe, this example will call LVGL APIs from
-// different tasks, so use a mutex to protect it
-static _lock_t lvgl_api_lock;
-
-static void example_lvgl_port_task(void *arg) {
-  ESP_LOGI(TAG, "Starting LVGL task");
-  uint32_t time_till_next_ms = 0;
-  while (1) {
-    _lock_acquire(&lvgl_api_lock);
-    time_till_next_ms = lv_timer_handler();
-    _lock_release(&lvgl_api_lock);
-    // in case of triggering a task watch dog time out
-    time_till_next_ms = MAX(time_till_next_ms, LVGL_TASK_MIN_DELAY_MS);
-    // in case of lvgl display not ready yet
-    time_till_next_ms = MIN(time_till_next_ms, LVGL_TASK_MAX_DELAY_MS);
-    usleep(1000 * time_till_next_ms);
-  }
-}
 
-// Task to update time every second
-static void time_update_task(void *arg) {
-  while (1) {
-    vTaskDelay(pdMS_TO_TICKS(1000)); // Wait 1 second
+enum {
+  STAGE_NVS,
+  STAGE_CONSOLE,
+  STAGE_WIFI,
+  STAGE_DISPLAY,
+  STAGE_TOUCH,
+  STAGE_ASSETS,
+  STAGE_NOTIFS,
+  STAGE_UI,
+};
+
+static lv_display_t *s_display;
 
-    // Protect LVGL API calls with mutex
-    _lock_acquire(&lvgl_api_lock);
-    increment_time(); // This will update the display
-    _lock_release(&lvgl_api_lock);
+// Runs in the LVGL task, on each second of the time service
+static void clock_update(const struct tm *local, uint32_t changed, void *arg) {
+  (void)changed;
+  (void)arg;
+  set_time(local->tm_hour, local->tm_min, local->tm_sec);
+}
+
+static void wifi_status_handler(void *arg, esp_event_base_t event_base,
+                                int32_t event_id, void *event_data) {
+  const mod_wifi_status_t *status = event_data;
+  if (status->state == MOD_WIFI_CONNECTED) {
+    boot_mark(BOOT_MARK_GOT_IP);
+  }
+  if (status->time_synced) {
+    boot_mark(BOOT_MARK_TIME_SYNC);
+    // The clock jumped, show it now rather than at the next tick
+    ui_cmd_post_call(time_svc_resync, NULL);
   }
 }
 
-void app_main(void) {
-  // Init hardware
-  /* lv_display_t *display = display_init(); */
-  /* touch_controller_init(display); */
-  /**/
-  /* // Initialize the screen once */
-  /* _lock_acquire(&lvgl_api_lock); */
-  /* lv_screen(display); */
-  /* set_time(12, 30, 45); // Set initial time (12:30:45) */
-  /* _lock_release(&lvgl_api_lock); */
-
-  // Initialize NVS
+static void stage_nvs(void) {
   esp_err_t ret = nvs_flash_init();
   if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
       ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -69,17 +64,80 @@ void app_main(void) {
     ret = nvs_flash_init();
   }
   ESP_ERROR_CHECK(ret);
+}
 
+static void stage_wifi(void) {
   mod_wifi_init();
+  ESP_ERROR_CHECK(esp_event_handler_instance_register(
+      MOD_WIFI_EVENT, MOD_WIFI_EVENT_STATUS, wifi_status_handler, NULL, NULL));
+  wifi_connection_start();
+}
 
-  /* // Create LVGL task */
-  /* xTaskCreate(example_lvgl_port_task, "LVGL", LVGL_TASK_STACK_SIZE, NULL, */
-  /*             LVGL_TASK_PRIORITY, NULL); */
-  /**/
-  /* // Create time update task */
-  /* xTaskCreate(time_update_task, "TIME", 2048, NULL, LVGL_TASK_PRIORITY - 1,
-   */
-  /*             NULL); */
+// Panel reset/init and LVGL init, the panel's reset and sleep-out delays
+// overlap with NVS and the radio
+static void stage_display(void) { s_display = display_init(); }
 
-  wifi_connection_start();
+// Needs NVS for the stored calibration, it is up long before the panel
+static void stage_touch(void) { touch_controller_init(s_display); }
+
+// The UI falls back to built-in drawing for anything missing
+static void stage_assets(void) { assets_mount(); }
+
+// Scans the notification log, without it the list stays empty
+static void stage_notifs(void) { notif_store_init(); }
+
+// Build the screen before the LVGL task owns LVGL, the task renders it as
+// its first frame
+static void stage_ui(void) {
+  timer_svc_init();
+  time_svc_init(WATCH_TZ);
+  struct tm local;
+  time_svc_now(&local);
+  lv_screen(s_display);
+  set_time(local.tm_hour, local.tm_min, local.tm_sec);
+  time_svc_subscribe(TIME_SVC_SECOND, clock_update, NULL);
+
+  lvgl_port_start(s_display);
+}
+
+// The display chain runs above the rest so the first frame is not queued
+// behind Wi-Fi init
+static const boot_stage_t boot_stages[] = {
+    [STAGE_NVS] = {"nvs", stage_nvs, 0, BOOT_STAGE_STACK_SIZE,
+                   BOOT_STAGE_PRIORITY},
+    [STAGE_CONSOLE] = {"console", app_console_start, 0, BOOT_STAGE_STACK_SIZE,
+                       BOOT_STAGE_PRIORITY},
+    [STAGE_WIFI] = {"wifi", stage_wifi, BOOT_DEP(STAGE_NVS),
+                    BOOT_STAGE_STACK_SIZE, BOOT_STAGE_PRIORITY},
+    [STAGE_DISPLAY] = {"display", stage_display, 0, BOOT_STAGE_STACK_SIZE,
+                       BOOT_DISPLAY_STAGE_PRIORITY},
+    [STAGE_TOUCH] = {"touch", stage_touch,
+                     BOOT_DEP(STAGE_DISPLAY) | BOOT_DEP(STAGE_NVS),
+                     BOOT_STAGE_STACK_SIZE, BOOT_DISPLAY_STAGE_PRIORITY},
+    [STAGE_ASSETS] = {"assets", stage_assets, 0, BOOT_STAGE_STACK_SIZE,
+                      BOOT_DISPLAY_STAGE_PRIORITY},
+    [STAGE_NOTIFS] = {"notifs", stage_notifs, 0, BOOT_STAGE_STACK_SIZE,
+                      BOOT_STAGE_PRIORITY},
+    [STAGE_UI] = {"ui", stage_ui,
+                  BOOT_DEP(STAGE_DISPLAY) | BOOT_DEP(STAGE_TOUCH) |
+                      BOOT_DEP(STAGE_ASSETS) | BOOT_DEP(STAGE_NOTIFS),
+                  LVGL_TASK_STACK_SIZE, BOOT_DISPLAY_STAGE_PRIORITY},
+};
+
+void app_main(void) {
+  dlog_init();
+
+#if CONFIG_PM_ENABLE
+  // Let the CPU and APB drop to XTAL between frames, the display holds locks
+  // while it renders and transfers. No light sleep: it would stop the
+  // backlight PWM.
+  esp_pm_config_t pm_config = {
+      .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+      .min_freq_mhz = CONFIG_XTAL_FREQ,
+      .light_sleep_enable = false,
+  };
+  ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+#endif
+
+  boot_run(boot_stages, sizeof(boot_stages) / sizeof(boot_stages[0]));
 }
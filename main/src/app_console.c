@@ -0,0 +1,296 @@
+#include "app_console.h"
+#include "assets.h"
+#include "boot.h"
+#include "config.h"
+#include "dlog.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "lv_mem_pool.h"
+#include "touch_controller.h"
+#include "trace.h"
+#include "ui_cmd.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "APP_CONSOLE";
+
+// Records per "TRACE" line of a dump
+#define TRACE_DUMP_PER_LINE 4
+
+// How long a console command waits for the LVGL task to run its request
+#define CONSOLE_UI_TIMEOUT_MS 1000
+
+typedef struct {
+  SemaphoreHandle_t done;
+  trace_summary_t summary;
+} trace_stats_req_t;
+
+// Runs in the LVGL task, which owns the trace summary
+static void trace_stats_copy(void *arg) {
+  trace_stats_req_t *req = arg;
+  trace_collect();
+  req->summary = *trace_get_summary();
+  xSemaphoreGive(req->done);
+}
+
+static void trace_reset(void *arg) {
+  (void)arg;
+  trace_reset_summary();
+}
+
+static void trace_print_stats(void) {
+  static trace_stats_req_t req;
+  if (!req.done) {
+    req.done = xSemaphoreCreateBinary();
+  }
+  // Drop a late answer to an earlier request that timed out
+  xSemaphoreTake(req.done, 0);
+  if (!ui_cmd_post_call(trace_stats_copy, &req) ||
+      xSemaphoreTake(req.done, pdMS_TO_TICKS(CONSOLE_UI_TIMEOUT_MS)) !=
+          pdTRUE) {
+    printf("LVGL task busy, try again\n");
+    return;
+  }
+  const trace_summary_t *summary = &req.summary;
+
+  printf("%-9s %7s %8s %8s %8s %8s\n", "stage", "count", "p50_us", "p90_us",
+         "p99_us", "max_us");
+  for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+    const trace_hist_t *h = &summary->stages[s];
+    printf("%-9s %7u %8u %8u %8u %8u\n", trace_stage_names[s],
+           (unsigned)h->count, (unsigned)trace_hist_percentile(h, 50),
+           (unsigned)trace_hist_percentile(h, 90),
+           (unsigned)trace_hist_percentile(h, 99), (unsigned)h->max_us);
+  }
+  printf("over %d ms budget: %u, events lost: %u\n", TOUCH_LATENCY_BUDGET_MS,
+         (unsigned)summary->over_budget, (unsigned)summary->lost);
+}
+
+/* Raw ring as hex for host/tools/trace_decode, one line per few records */
+static void trace_print_dump(void) {
+  static trace_record_t records[TRACE_RING_LEN];
+  size_t n = trace_snapshot(records, TRACE_RING_LEN);
+  const uint8_t *bytes = (const uint8_t *)records;
+  for (size_t i = 0; i < n; i += TRACE_DUMP_PER_LINE) {
+    printf("TRACE ");
+    for (size_t r = i; r < n && r < i + TRACE_DUMP_PER_LINE; r++) {
+      for (size_t b = 0; b < sizeof(trace_record_t); b++) {
+        printf("%02x", bytes[r * sizeof(trace_record_t) + b]);
+      }
+    }
+    printf("\n");
+  }
+  printf("TRACE END %u\n", (unsigned)n);
+}
+
+static int cmd_trace(int argc, char **argv) {
+  if (argc == 2 && !strcmp(argv[1], "stats")) {
+    trace_print_stats();
+  } else if (argc == 2 && !strcmp(argv[1], "dump")) {
+    trace_print_dump();
+  } else if (argc == 2 && !strcmp(argv[1], "reset")) {
+    ui_cmd_post_call(trace_reset, NULL);
+  } else {
+    printf("usage: trace stats|dump|reset\n");
+    return 1;
+  }
+  return 0;
+}
+
+typedef struct {
+  SemaphoreHandle_t done;
+  lv_mem_pool_stats_t stats;
+} lvmem_stats_req_t;
+
+// Runs in the LVGL task, which owns the pool
+static void lvmem_stats_copy(void *arg) {
+  lvmem_stats_req_t *req = arg;
+  lv_mem_pool_get_stats(&req->stats);
+  xSemaphoreGive(req->done);
+}
+
+static void lvmem_monitor_on(void *arg) {
+  (void)arg;
+  lv_mem_pool_monitor_show(true);
+}
+
+static void lvmem_monitor_off(void *arg) {
+  (void)arg;
+  lv_mem_pool_monitor_show(false);
+}
+
+static void lvmem_print_stats(void) {
+  static lvmem_stats_req_t req;
+  if (!req.done) {
+    req.done = xSemaphoreCreateBinary();
+  }
+  xSemaphoreTake(req.done, 0);
+  if (!ui_cmd_post_call(lvmem_stats_copy, &req) ||
+      xSemaphoreTake(req.done, pdMS_TO_TICKS(CONSOLE_UI_TIMEOUT_MS)) !=
+          pdTRUE) {
+    printf("LVGL task busy, try again\n");
+    return;
+  }
+  const lv_mem_pool_stats_t *st = &req.stats;
+
+  printf("used %u / %u bytes (max %u), requested %u, largest free %u, "
+         "frag %u%%\n",
+         (unsigned)st->used, (unsigned)st->total, (unsigned)st->max_used,
+         (unsigned)st->requested, (unsigned)st->largest_free,
+         (unsigned)st->frag_pct);
+  printf("pages: %u free, %u slab, %u run; %u live of %u allocs, "
+         "%u failed\n",
+         st->pages_free, st->pages_slab, st->pages_run, (unsigned)st->live,
+         (unsigned)st->allocs, (unsigned)st->failures);
+  printf("%-6s %6s %8s %8s\n", "class", "pages", "used", "slots");
+  for (int c = 0; c < LV_MEM_POOL_CLASSES; c++) {
+    const lv_mem_pool_class_stats_t *cls = &st->classes[c];
+    printf("%-6u %6u %8u %8u\n", cls->size, cls->pages,
+           (unsigned)cls->slots_used, (unsigned)cls->slots_total);
+  }
+  printf("arenas: %u released, %u pages freed, %u survivors; pages",
+         (unsigned)st->arena_releases, (unsigned)st->arena_pages_freed,
+         (unsigned)st->arena_survivors);
+  for (int a = 0; a < LV_MEM_POOL_ARENAS; a++) {
+    printf(" %u", st->arena_pages[a]);
+  }
+  printf("\n");
+}
+
+static int cmd_lvmem(int argc, char **argv) {
+  if (argc == 1 || (argc == 2 && !strcmp(argv[1], "stats"))) {
+    lvmem_print_stats();
+  } else if (argc == 3 && !strcmp(argv[1], "monitor") &&
+             (!strcmp(argv[2], "on") || !strcmp(argv[2], "off"))) {
+    ui_cmd_post_call(strcmp(argv[2], "on") ? lvmem_monitor_off
+                                           : lvmem_monitor_on,
+                     NULL);
+  } else {
+    printf("usage: lvmem [stats|monitor on|off]\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int cmd_boot(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  boot_print_timeline();
+  return 0;
+}
+
+static int cmd_assets(int argc, char **argv) {
+  if (argc == 1 || (argc == 2 && !strcmp(argv[1], "list"))) {
+    assets_print();
+  } else if (argc == 2 && !strcmp(argv[1], "verify")) {
+    return assets_verify() ? 0 : 1;
+  } else {
+    printf("usage: assets [list|verify]\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int cmd_dlog(int argc, char **argv) {
+  static const char levels[] = "NEWIDV"; // esp_log_level_t order
+  if (argc == 1 || (argc == 2 && !strcmp(argv[1], "stats"))) {
+    dlog_stats_t st;
+    dlog_get_stats(&st);
+    printf("written %u, filtered %u, lost %u, truncated %u, flushed %u, "
+           "after panic %u\n",
+           (unsigned)st.written, (unsigned)st.filtered, (unsigned)st.lost,
+           (unsigned)st.truncated, (unsigned)st.flushed,
+           (unsigned)st.panic_records);
+  } else if (argc == 2 && !strcmp(argv[1], "flush")) {
+    dlog_flush();
+  } else if (argc == 3 && !strcmp(argv[1], "level") &&
+             strlen(argv[2]) == 1 && strchr(levels, argv[2][0])) {
+    dlog_set_level((esp_log_level_t)(strchr(levels, argv[2][0]) - levels));
+  } else {
+    printf("usage: dlog [stats|flush|level N|E|W|I|D|V]\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int cmd_touchcal(int argc, char **argv) {
+  if (argc == 1 || (argc == 2 && !strcmp(argv[1], "start"))) {
+    ui_cmd_post_call(touch_controller_calibrate, NULL);
+  } else if (argc == 2 && !strcmp(argv[1], "reset")) {
+    ui_cmd_post_call(touch_controller_reset_calibration, NULL);
+  } else {
+    printf("usage: touchcal [start|reset]\n");
+    return 1;
+  }
+  return 0;
+}
+
+void app_console_start(void) {
+  esp_console_repl_t *repl = NULL;
+  esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+  repl_config.prompt = "watch>";
+
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+  esp_console_dev_usb_serial_jtag_config_t hw_config =
+      ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+  ESP_ERROR_CHECK(
+      esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl));
+#else
+  esp_console_dev_uart_config_t hw_config =
+      ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+  ESP_ERROR_CHECK(esp_console_new_repl_uart(&hw_config, &repl_config, &repl));
+#endif
+
+  const esp_console_cmd_t trace_cmd = {
+      .command = "trace",
+      .help = "Touch-to-photon latency: per-stage percentiles (stats), raw "
+              "events for host/tools/trace_decode (dump), clear (reset)",
+      .func = cmd_trace,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&trace_cmd));
+
+  const esp_console_cmd_t boot_cmd = {
+      .command = "boot",
+      .help = "Bring-up timeline: stage start/end and time to first pixel, "
+              "IP and time sync",
+      .func = cmd_boot,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&boot_cmd));
+
+  const esp_console_cmd_t assets_cmd = {
+      .command = "assets",
+      .help = "Assets in the flash partition (list), re-check their pixel "
+              "data CRCs (verify)",
+      .func = cmd_assets,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&assets_cmd));
+
+  const esp_console_cmd_t lvmem_cmd = {
+      .command = "lvmem",
+      .help = "LVGL memory pool: usage, fragmentation, size classes and "
+              "screen arenas (stats), on-screen monitor (monitor on|off)",
+      .func = cmd_lvmem,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&lvmem_cmd));
+
+  const esp_console_cmd_t touchcal_cmd = {
+      .command = "touchcal",
+      .help = "Touch calibration: tap three targets on screen (start), back "
+              "to the uncalibrated mapping (reset)",
+      .func = cmd_touchcal,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&touchcal_cmd));
+
+  const esp_console_cmd_t dlog_cmd = {
+      .command = "dlog",
+      .help = "Deferred log: record counts (stats), print pending records "
+              "now (flush), drop records above a level (level)",
+      .func = cmd_dlog,
+  };
+  ESP_ERROR_CHECK(esp_console_cmd_register(&dlog_cmd));
+
+  ESP_LOGI(TAG, "Starting console");
+  ESP_ERROR_CHECK(esp_console_start_repl(repl));
+}
@@ -0,0 +1,120 @@
+#include "asset_pack.h"
+#include <string.h>
+
+const char *const asset_format_names[] = {
+    [ASSET_FORMAT_RGB565] = "rgb565",
+    [ASSET_FORMAT_RGB565_SWAPPED] = "rgb565-swapped",
+    [ASSET_FORMAT_RGB565A8] = "rgb565a8",
+    [ASSET_FORMAT_A8] = "a8",
+};
+
+const char *const asset_pack_err_names[] = {
+    [ASSET_PACK_OK] = "ok",
+    [ASSET_PACK_ERR_SIZE] = "truncated",
+    [ASSET_PACK_ERR_MAGIC] = "bad magic",
+    [ASSET_PACK_ERR_VERSION] = "unsupported version",
+    [ASSET_PACK_ERR_INDEX_CRC] = "index CRC mismatch",
+    [ASSET_PACK_ERR_ENTRY] = "bad entry",
+    [ASSET_PACK_ERR_DATA_CRC] = "data CRC mismatch",
+};
+
+// Reflected 0xEDB88320, a nibble at a time: 64 bytes of table instead of 1 KB
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+    0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+uint32_t asset_pack_crc32(uint32_t crc, const void *data, size_t len) {
+  const uint8_t *p = data;
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ crc32_nibble[crc & 0xf];
+    crc = (crc >> 4) ^ crc32_nibble[crc & 0xf];
+  }
+  return ~crc;
+}
+
+uint32_t asset_pack_stride(asset_format_t format, uint32_t w) {
+  return format == ASSET_FORMAT_A8 ? w : w * 2;
+}
+
+uint32_t asset_pack_data_size(asset_format_t format, uint32_t w, uint32_t h) {
+  uint32_t px = w * h;
+  switch (format) {
+  case ASSET_FORMAT_RGB565A8:
+    return px * 3;
+  case ASSET_FORMAT_A8:
+    return px;
+  default:
+    return px * 2;
+  }
+}
+
+static bool entry_valid(const asset_entry_t *e, uint32_t data_start,
+                        uint32_t total_size) {
+  if (memchr(e->name, '\0', ASSET_NAME_LEN) == NULL || e->name[0] == '\0' ||
+      e->format >= ASSET_FORMAT_COUNT || e->width == 0 || e->height == 0) {
+    return false;
+  }
+  asset_format_t format = e->format;
+  return e->offset >= data_start && e->offset % ASSET_DATA_ALIGN == 0 &&
+         e->size == asset_pack_data_size(format, e->width, e->height) &&
+         e->stride == asset_pack_stride(format, e->width) &&
+         // Unsigned: an offset past the end must not wrap the subtraction
+         e->offset <= total_size && e->size <= total_size - e->offset;
+}
+
+asset_pack_err_t asset_pack_check(const void *blob, size_t len,
+                                  bool check_data, uint32_t *bad_entry) {
+  const asset_pack_header_t *hdr = blob;
+  if (len < sizeof(*hdr)) {
+    return ASSET_PACK_ERR_SIZE;
+  }
+  if (hdr->magic != ASSET_PACK_MAGIC) {
+    return ASSET_PACK_ERR_MAGIC;
+  }
+  if (hdr->version != ASSET_PACK_VERSION) {
+    return ASSET_PACK_ERR_VERSION;
+  }
+  uint32_t data_start = sizeof(*hdr) + hdr->count * sizeof(asset_entry_t);
+  if (hdr->total_size > len || hdr->total_size < data_start) {
+    return ASSET_PACK_ERR_SIZE;
+  }
+  const asset_entry_t *entries = asset_pack_entries(blob);
+  if (asset_pack_crc32(0, entries, hdr->count * sizeof(asset_entry_t)) !=
+      hdr->index_crc) {
+    return ASSET_PACK_ERR_INDEX_CRC;
+  }
+  for (uint32_t i = 0; i < hdr->count; i++) {
+    const asset_entry_t *e = &entries[i];
+    if (!entry_valid(e, data_start, hdr->total_size)) {
+      *bad_entry = i;
+      return ASSET_PACK_ERR_ENTRY;
+    }
+    if (check_data &&
+        asset_pack_crc32(0, (const uint8_t *)blob + e->offset, e->size) !=
+            e->crc) {
+      *bad_entry = i;
+      return ASSET_PACK_ERR_DATA_CRC;
+    }
+  }
+  return ASSET_PACK_OK;
+}
+
+const asset_entry_t *asset_pack_entries(const void *blob) {
+  return (const asset_entry_t *)((const uint8_t *)blob +
+                                 sizeof(asset_pack_header_t));
+}
+
+const asset_entry_t *asset_pack_find(const void *blob, const char *name) {
+  const asset_pack_header_t *hdr = blob;
+  const asset_entry_t *entries = asset_pack_entries(blob);
+  for (uint32_t i = 0; i < hdr->count; i++) {
+    if (strncmp(entries[i].name, name, ASSET_NAME_LEN) == 0) {
+      return &entries[i];
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,149 @@
+#include "assets.h"
+#include "asset_pack.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "ASSETS";
+
+static const void *s_blob;
+static esp_partition_mmap_handle_t s_map;
+static lv_image_dsc_t *s_images;
+static uint32_t s_count;
+
+static bool assets_color_format(asset_format_t format,
+                                lv_color_format_t *out) {
+  switch (format) {
+  case ASSET_FORMAT_RGB565:
+    *out = LV_COLOR_FORMAT_RGB565;
+    return true;
+#if LVGL_VERSION_MAJOR > 9 ||                                                 \
+    (LVGL_VERSION_MAJOR == 9 && LVGL_VERSION_MINOR >= 3)
+  case ASSET_FORMAT_RGB565_SWAPPED:
+    *out = LV_COLOR_FORMAT_RGB565_SWAPPED;
+    return true;
+#endif
+  case ASSET_FORMAT_RGB565A8:
+    *out = LV_COLOR_FORMAT_RGB565A8;
+    return true;
+  case ASSET_FORMAT_A8:
+    *out = LV_COLOR_FORMAT_A8;
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void assets_unmount(void) {
+  free(s_images);
+  s_images = NULL;
+  s_count = 0;
+  esp_partition_munmap(s_map);
+  s_blob = NULL;
+}
+
+bool assets_mount(void) {
+  const esp_partition_t *part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+      ASSETS_PARTITION_LABEL);
+  if (!part) {
+    ESP_LOGW(TAG, "No %s partition", ASSETS_PARTITION_LABEL);
+    return false;
+  }
+  // The whole partition goes into the data cache's address space, reads
+  // fault pages in from flash as LVGL draws
+  esp_err_t err = esp_partition_mmap(part, 0, part->size,
+                                     ESP_PARTITION_MMAP_DATA, &s_blob, &s_map);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "mmap failed: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  uint32_t bad = 0;
+  asset_pack_err_t check = asset_pack_check(s_blob, part->size, false, &bad);
+  if (check != ASSET_PACK_OK) {
+    // An erased partition reads as 0xff: nothing flashed yet
+    ESP_LOGW(TAG, "%s partition not usable: %s", ASSETS_PARTITION_LABEL,
+             asset_pack_err_names[check]);
+    assets_unmount();
+    return false;
+  }
+
+  const asset_pack_header_t *hdr = s_blob;
+  const asset_entry_t *entries = asset_pack_entries(s_blob);
+  s_images = calloc(hdr->count, sizeof(*s_images));
+  if (hdr->count && !s_images) {
+    assets_unmount();
+    return false;
+  }
+  for (uint32_t i = 0; i < hdr->count; i++) {
+    const asset_entry_t *e = &entries[i];
+    lv_image_dsc_t *img = &s_images[i];
+    lv_color_format_t cf;
+    if (!assets_color_format(e->format, &cf)) {
+      ESP_LOGW(TAG, "%s: %s not drawable by this LVGL", e->name,
+               asset_format_names[e->format]);
+      continue;
+    }
+    img->header.magic = LV_IMAGE_HEADER_MAGIC;
+    img->header.cf = cf;
+    img->header.w = e->width;
+    img->header.h = e->height;
+    img->header.stride = e->stride;
+    img->data_size = e->size;
+    img->data = (const uint8_t *)s_blob + e->offset;
+  }
+  s_count = hdr->count;
+  ESP_LOGI(TAG, "%u assets, %u bytes mapped", (unsigned)s_count,
+           (unsigned)hdr->total_size);
+  return true;
+}
+
+const lv_image_dsc_t *assets_image(const char *name) {
+  if (!s_blob) {
+    return NULL;
+  }
+  const asset_entry_t *e = asset_pack_find(s_blob, name);
+  if (!e) {
+    return NULL;
+  }
+  const lv_image_dsc_t *img = &s_images[e - asset_pack_entries(s_blob)];
+  return img->data ? img : NULL;
+}
+
+bool assets_verify(void) {
+  if (!s_blob) {
+    printf("assets not mounted\n");
+    return false;
+  }
+  const asset_pack_header_t *hdr = s_blob;
+  uint32_t bad = 0;
+  asset_pack_err_t err = asset_pack_check(s_blob, hdr->total_size, true, &bad);
+  if (err == ASSET_PACK_OK) {
+    printf("%u assets ok\n", (unsigned)s_count);
+    return true;
+  }
+  if (err == ASSET_PACK_ERR_ENTRY || err == ASSET_PACK_ERR_DATA_CRC) {
+    printf("%s: %s\n", asset_pack_entries(s_blob)[bad].name,
+           asset_pack_err_names[err]);
+  } else {
+    printf("%s\n", asset_pack_err_names[err]);
+  }
+  return false;
+}
+
+void assets_print(void) {
+  if (!s_blob) {
+    printf("assets not mounted\n");
+    return;
+  }
+  const asset_entry_t *entries = asset_pack_entries(s_blob);
+  for (uint32_t i = 0; i < s_count; i++) {
+    const asset_entry_t *e = &entries[i];
+    printf("%-24s %-14s %4ux%-4u %7u bytes\n", e->name,
+           asset_format_names[e->format], e->width, e->height,
+           (unsigned)e->size);
+  }
+}
@@ -0,0 +1,112 @@
+#include "boot.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+static const char *TAG = "BOOT";
+
+typedef struct {
+  const boot_stage_t *stage;
+  uint32_t index;
+  int64_t start_us;
+  int64_t end_us;
+} boot_stage_run_t;
+
+static boot_stage_run_t s_runs[BOOT_MAX_STAGES];
+static size_t s_count;
+static EventGroupHandle_t s_done;
+// esp_timer time of each milestone, 0 until reached
+static _Atomic int64_t s_marks_us[BOOT_MARK_COUNT];
+
+static const char *const mark_names[] = {
+    [BOOT_MARK_FIRST_PIXEL] = "first pixel",
+    [BOOT_MARK_GOT_IP] = "got IP",
+    [BOOT_MARK_TIME_SYNC] = "time sync",
+};
+
+static void boot_stage_task(void *arg) {
+  boot_stage_run_t *run = arg;
+  if (run->stage->deps) {
+    xEventGroupWaitBits(s_done, run->stage->deps, pdFALSE, pdTRUE,
+                        portMAX_DELAY);
+  }
+  run->start_us = esp_timer_get_time();
+  run->stage->run();
+  run->end_us = esp_timer_get_time();
+  xEventGroupSetBits(s_done, BOOT_DEP(run->index));
+  vTaskDelete(NULL);
+}
+
+void boot_run(const boot_stage_t *stages, size_t count) {
+  assert(count <= BOOT_MAX_STAGES);
+  s_done = xEventGroupCreate();
+  assert(s_done);
+  int64_t start_us = esp_timer_get_time();
+  for (size_t i = 0; i < count; i++) {
+    // Only backwards edges, so the graph has no cycles
+    assert((stages[i].deps >> i) == 0);
+    s_runs[i] = (boot_stage_run_t){.stage = &stages[i], .index = i};
+    BaseType_t ret =
+        xTaskCreate(boot_stage_task, stages[i].name, stages[i].stack_size,
+                    &s_runs[i], stages[i].priority, NULL);
+    assert(ret == pdPASS);
+  }
+  s_count = count;
+
+  xEventGroupWaitBits(s_done, BOOT_DEP(count) - 1, pdFALSE, pdTRUE,
+                      portMAX_DELAY);
+  ESP_LOGI(TAG, "Bring-up done in %d ms",
+           (int)((esp_timer_get_time() - start_us) / 1000));
+  boot_print_timeline();
+}
+
+void boot_mark(boot_mark_t mark) {
+  int64_t expected = 0;
+  int64_t now_us = esp_timer_get_time();
+  if (!atomic_compare_exchange_strong(&s_marks_us[mark], &expected, now_us)) {
+    return;
+  }
+  if (mark == BOOT_MARK_FIRST_PIXEL) {
+    // W-2: UI rendered within 3 s of power-on
+    int ms = (int)(now_us / 1000);
+    if (ms > BOOT_FIRST_PIXEL_BUDGET_MS) {
+      ESP_LOGW(TAG, "First pixel at %d ms, over the %d ms budget", ms,
+               BOOT_FIRST_PIXEL_BUDGET_MS);
+    } else {
+      ESP_LOGI(TAG, "First pixel at %d ms (budget %d ms)", ms,
+               BOOT_FIRST_PIXEL_BUDGET_MS);
+    }
+  }
+}
+
+void boot_print_timeline(void) {
+  // Time since esp_timer started, the ROM and bootloader come before that
+  printf("%-11s %8s %8s %8s\n", "stage", "start_ms", "end_ms", "took_ms");
+  for (size_t i = 0; i < s_count; i++) {
+    const boot_stage_run_t *run = &s_runs[i];
+    if (!run->start_us) {
+      printf("%-11s %8s %8s %8s\n", run->stage->name, "-", "-", "-");
+    } else if (!run->end_us) {
+      printf("%-11s %8d %8s %8s\n", run->stage->name,
+             (int)(run->start_us / 1000), "-", "-");
+    } else {
+      printf("%-11s %8d %8d %8d\n", run->stage->name,
+             (int)(run->start_us / 1000), (int)(run->end_us / 1000),
+             (int)((run->end_us - run->start_us) / 1000));
+    }
+  }
+  for (int m = 0; m < BOOT_MARK_COUNT; m++) {
+    int64_t us = atomic_load(&s_marks_us[m]);
+    if (us) {
+      printf("%-11s %8d\n", mark_names[m], (int)(us / 1000));
+    } else {
+      printf("%-11s %8s\n", mark_names[m], "-");
+    }
+  }
+}
@@ -0,0 +1,106 @@
+#include "clock_widget.h"
+#include <assert.h>
+#include <string.h>
+
+#define GLYPH_COLON 10
+
+// Render ch centred into an opaque cell-sized bitmap
+static lv_draw_buf_t *clock_render_glyph(lv_obj_t *canvas, char ch,
+                                         int32_t w, int32_t h,
+                                         const lv_font_t *font, lv_color_t fg,
+                                         lv_color_t bg) {
+  lv_draw_buf_t *buf =
+      lv_draw_buf_create(w, h, LV_COLOR_FORMAT_RGB565, LV_STRIDE_AUTO);
+  assert(buf);
+  lv_canvas_set_draw_buf(canvas, buf);
+  lv_canvas_fill_bg(canvas, bg, LV_OPA_COVER);
+
+  char text[2] = {ch, '\0'};
+  lv_draw_label_dsc_t dsc;
+  lv_draw_label_dsc_init(&dsc);
+  dsc.font = font;
+  dsc.color = fg;
+  dsc.align = LV_TEXT_ALIGN_CENTER;
+  dsc.text = text;
+  lv_area_t area = {0, 0, w - 1, h - 1};
+
+  lv_layer_t layer;
+  lv_canvas_init_layer(canvas, &layer);
+  lv_draw_label(&layer, &dsc, &area);
+  lv_canvas_finish_layer(canvas, &layer);
+  return buf;
+}
+
+static void clock_widget_delete_cb(lv_event_t *e) {
+  clock_widget_t *w = lv_event_get_user_data(e);
+  for (int i = 0; i < CLOCK_WIDGET_GLYPHS; i++) {
+    lv_draw_buf_destroy(w->glyphs[i]);
+    w->glyphs[i] = NULL;
+  }
+}
+
+void clock_widget_init(clock_widget_t *w, lv_obj_t *parent,
+                       const lv_font_t *font, lv_color_t fg, lv_color_t bg) {
+  memset(w, 0, sizeof(*w));
+  memset(w->shown, -1, sizeof(w->shown));
+
+  // Every digit gets the widest digit's cell so nothing shifts on a tick
+  int32_t digit_w = 0;
+  for (char c = '0'; c <= '9'; c++) {
+    int32_t gw = lv_font_get_glyph_width(font, c, '\0');
+    digit_w = gw > digit_w ? gw : digit_w;
+  }
+  int32_t colon_w = lv_font_get_glyph_width(font, ':', '\0');
+  int32_t h = lv_font_get_line_height(font);
+
+  // Scratch canvas, only used to render the glyph bitmaps
+  lv_obj_t *canvas = lv_canvas_create(parent);
+  lv_obj_add_flag(canvas, LV_OBJ_FLAG_HIDDEN);
+  for (int i = 0; i < 10; i++) {
+    w->glyphs[i] =
+        clock_render_glyph(canvas, '0' + i, digit_w, h, font, fg, bg);
+  }
+  w->glyphs[GLYPH_COLON] =
+      clock_render_glyph(canvas, ':', colon_w, h, font, fg, bg);
+  lv_obj_delete(canvas);
+
+  // Plain container: no style, no layout, no scrolling
+  w->obj = lv_obj_create(parent);
+  lv_obj_remove_style_all(w->obj);
+  lv_obj_remove_flag(w->obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_add_event_cb(w->obj, clock_widget_delete_cb, LV_EVENT_DELETE, w);
+
+  int32_t x = 0;
+  for (int i = 0; i < CLOCK_WIDGET_CELLS; i++) {
+    bool colon = i == 2 || i == 5;
+    int32_t cw = colon ? colon_w : digit_w;
+    w->cells[i] = lv_image_create(w->obj);
+    lv_obj_remove_flag(w->cells[i], LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_pos(w->cells[i], x, 0);
+    lv_obj_set_size(w->cells[i], cw, h);
+    if (colon) {
+      lv_image_set_src(w->cells[i], w->glyphs[GLYPH_COLON]);
+      w->shown[i] = GLYPH_COLON;
+    }
+    x += cw;
+  }
+  lv_obj_set_size(w->obj, x, h);
+}
+
+static void clock_widget_set_cell(clock_widget_t *w, int cell, int digit) {
+  if (w->shown[cell] == digit) {
+    return; // unchanged, nothing to invalidate
+  }
+  w->shown[cell] = digit;
+  lv_image_set_src(w->cells[cell], w->glyphs[digit]);
+}
+
+void clock_widget_set_time(clock_widget_t *w, uint8_t h, uint8_t m,
+                           uint8_t s) {
+  const uint8_t fields[3] = {h, m, s};
+  for (int f = 0; f < 3; f++) {
+    // cells 0-1, 3-4, 6-7
+    clock_widget_set_cell(w, f * 3, fields[f] / 10 % 10);
+    clock_widget_set_cell(w, f * 3 + 1, fields[f] % 10);
+  }
+}
@@ -1,76 +1,599 @@
 #include "config.h"
 #include "display/lv_display.h"
+#include "display/lv_display_private.h"
 #include "draw/sw/lv_draw_sw.h"
-#include "driver/gpio.h"
+#include "draw_pipeline.h"
+#include "driver/ledc.h"
 #include "driver/spi_common.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_commands.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 #include "lv_init.h"
 #include "lvgl_display.h"
+#include "lvgl_port.h"
+#include "rgb565_swap.h"
+#include "tile_hash.h"
+#include "trace.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <string.h>
 #include <sys/unistd.h>
 
+#if CONFIG_EXAMPLE_LCD_RGB565_RENDER_SWAPPED &&                               \
+    LVGL_VERSION_MAJOR == 9 && LVGL_VERSION_MINOR < 3
+#error "LV_COLOR_FORMAT_RGB565_SWAPPED rendering needs LVGL 9.3 or newer"
+#endif
+
 static const char *TAG = "LVGL_DISPLAY";
 
+#define BK_LIGHT_LEDC_MODE LEDC_LOW_SPEED_MODE
+#define BK_LIGHT_LEDC_TIMER LEDC_TIMER_0
+#define BK_LIGHT_LEDC_CHANNEL LEDC_CHANNEL_0
+#define BK_LIGHT_LEDC_BITS LEDC_TIMER_10_BIT
+
+// Tile grid over the display, the same count in any rotation
+#define DISPLAY_TILES                                                          \
+  (((EXAMPLE_LCD_H_RES + TILE_HASH_SIZE - 1) / TILE_HASH_SIZE) *               \
+   ((EXAMPLE_LCD_V_RES + TILE_HASH_SIZE - 1) / TILE_HASH_SIZE))
+
+typedef enum {
+  WINDOW_CLOSED,      // next strip needs CASET/RASET/RAMWR
+  WINDOW_STREAMING,   // RAMWR still active, raw pixel data keeps landing
+  WINDOW_INTERRUPTED, // another command was sent, resume with RAMWRC
+} window_state_t;
+
+// Bits of panel_shadow_t.known, a field is only trusted once we set it
+#define PANEL_KNOWN_SWAP_XY (1u << 0)
+#define PANEL_KNOWN_MIRROR (1u << 1)
+#define PANEL_KNOWN_INVERT (1u << 2)
+#define PANEL_KNOWN_ON (1u << 3)
+#define PANEL_KNOWN_CASET (1u << 4)
+#define PANEL_KNOWN_RASET (1u << 5)
+
+/* What the panel was last told. swap_xy and mirror both end up in MADCTL but
+ * the driver keeps them apart and rewrites the whole register for each. */
+typedef struct {
+  uint32_t known;
+  bool swap_xy;
+  bool mirror_x;
+  bool mirror_y;
+  bool inverted;
+  bool on;
+  int32_t caset[2];
+  int32_t raset[2];
+} panel_shadow_t;
+
+typedef struct {
+  esp_lcd_panel_handle_t panel;
+  esp_lcd_panel_io_handle_t io;
+  panel_shadow_t shadow;
+  // Panel RAM window left open by the previous flush
+  window_state_t window;
+  int32_t window_x1;
+  int32_t window_x2;
+  int32_t window_next_y;
+  // DMA draw buffers LVGL renders into, swapped under its single draw buffer
+  draw_pipeline_t pipeline;
+  lv_draw_buf_t *draw_buf;
+  // What the panel shows, per tile, so unchanged tiles are not sent again
+  tile_hash_t tiles;
+  bool tile_skip;
+  display_flush_stats_t stats;
+  display_panel_stats_t panel_stats;
+  uint8_t backlight; // percent
+#if CONFIG_PM_ENABLE
+  // Held from render start until the frame's last strip left over SPI DMA
+  esp_pm_lock_handle_t pm_cpu;
+  esp_pm_lock_handle_t pm_apb;
+  atomic_bool pm_held;
+  atomic_bool frame_rendered;
+#endif
+} display_ctx_t;
+
+static display_ctx_t s_display_ctx;
+static uint32_t s_tile_hashes[DISPLAY_TILES];
+
+/* After reset/init the controller is back to its power-on state, whatever the
+ * driver's init sequence wrote is not something we track */
+static void panel_state_forget(display_ctx_t *ctx) {
+  memset(&ctx->shadow, 0, sizeof(ctx->shadow));
+  ctx->window = WINDOW_CLOSED;
+  tile_hash_reset(&ctx->tiles);
+}
+
+/* A command that failed may or may not have reached the panel, so nothing
+ * the shadow holds can be trusted after it. True when the shadow may take
+ * the new value. */
+static bool panel_state_sent(display_ctx_t *ctx, esp_err_t err) {
+  if (err != ESP_OK) {
+    panel_state_forget(ctx);
+    return false;
+  }
+  return true;
+}
+
+/* Returns true when the command has to go out, and accounts for it */
+static bool panel_state_needs(display_ctx_t *ctx, uint32_t field,
+                              bool unchanged) {
+  if ((ctx->shadow.known & field) && unchanged) {
+    ctx->panel_stats.cmds_skipped++;
+    return false;
+  }
+  ctx->shadow.known |= field;
+  ctx->panel_stats.cmds_sent++;
+  // Any command ends the running memory write, the address counter survives
+  if (ctx->window == WINDOW_STREAMING) {
+    ctx->window = WINDOW_INTERRUPTED;
+  }
+  return true;
+}
+
+static esp_err_t panel_state_swap_xy(display_ctx_t *ctx, bool swap_xy) {
+  if (!panel_state_needs(ctx, PANEL_KNOWN_SWAP_XY,
+                         ctx->shadow.swap_xy == swap_xy)) {
+    return ESP_OK;
+  }
+  esp_err_t err = esp_lcd_panel_swap_xy(ctx->panel, swap_xy);
+  if (panel_state_sent(ctx, err)) {
+    ctx->shadow.swap_xy = swap_xy;
+  }
+  return err;
+}
+
+static esp_err_t panel_state_mirror(display_ctx_t *ctx, bool mirror_x,
+                                    bool mirror_y) {
+  if (!panel_state_needs(ctx, PANEL_KNOWN_MIRROR,
+                         ctx->shadow.mirror_x == mirror_x &&
+                             ctx->shadow.mirror_y == mirror_y)) {
+    return ESP_OK;
+  }
+  esp_err_t err = esp_lcd_panel_mirror(ctx->panel, mirror_x, mirror_y);
+  if (panel_state_sent(ctx, err)) {
+    ctx->shadow.mirror_x = mirror_x;
+    ctx->shadow.mirror_y = mirror_y;
+  }
+  return err;
+}
+
+static esp_err_t __attribute__((unused))
+panel_state_invert(display_ctx_t *ctx, bool inverted) {
+  if (!panel_state_needs(ctx, PANEL_KNOWN_INVERT,
+                         ctx->shadow.inverted == inverted)) {
+    return ESP_OK;
+  }
+  esp_err_t err = esp_lcd_panel_invert_color(ctx->panel, inverted);
+  if (panel_state_sent(ctx, err)) {
+    ctx->shadow.inverted = inverted;
+  }
+  return err;
+}
+
+static esp_err_t panel_state_on_off(display_ctx_t *ctx, bool on) {
+  if (!panel_state_needs(ctx, PANEL_KNOWN_ON, ctx->shadow.on == on)) {
+    return ESP_OK;
+  }
+  esp_err_t err = esp_lcd_panel_disp_on_off(ctx->panel, on);
+  if (panel_state_sent(ctx, err)) {
+    ctx->shadow.on = on;
+  }
+  return err;
+}
+
+// False when the command failed and the panel's range is unknown
+static bool panel_state_range(display_ctx_t *ctx, int cmd, uint32_t field,
+                              int32_t *shadow, int32_t start, int32_t end) {
+  if (!panel_state_needs(ctx, field, shadow[0] == start && shadow[1] == end)) {
+    return true;
+  }
+  esp_err_t err = esp_lcd_panel_io_tx_param(ctx->io, cmd,
+                                            (uint8_t[]){
+                                                (start >> 8) & 0xFF,
+                                                start & 0xFF,
+                                                (end >> 8) & 0xFF,
+                                                end & 0xFF,
+                                            },
+                                            4);
+  if (!panel_state_sent(ctx, err)) {
+    return false;
+  }
+  shadow[0] = start;
+  shadow[1] = end;
+  return true;
+}
+
+/* Point LVGL's draw buffer at the pipeline's current render buffer */
+static void example_lvgl_use_render_buf(display_ctx_t *ctx) {
+  ctx->draw_buf->data = ctx->pipeline.render_buf;
+  ctx->draw_buf->unaligned_data = ctx->pipeline.render_buf;
+}
+
+/* Frame starts rendering: keep CPU and APB at full speed until it is on the
+ * panel, DFS may drop them between frames */
+static void display_pm_frame_begin(display_ctx_t *ctx) {
+#if CONFIG_PM_ENABLE
+  atomic_store(&ctx->frame_rendered, false);
+  if (!atomic_exchange(&ctx->pm_held, true)) {
+    esp_pm_lock_acquire(ctx->pm_cpu);
+    esp_pm_lock_acquire(ctx->pm_apb);
+  }
+#else
+  (void)ctx;
+#endif
+}
+
+/* Called from render ready and from the transfer-done ISR, whichever sees the
+ * frame rendered with nothing in flight releases the locks */
+static void display_pm_frame_check_done(display_ctx_t *ctx) {
+#if CONFIG_PM_ENABLE
+  if (atomic_load(&ctx->frame_rendered) &&
+      draw_pipeline_inflight(&ctx->pipeline) == 0 &&
+      atomic_exchange(&ctx->pm_held, false)) {
+    esp_pm_lock_release(ctx->pm_apb);
+    esp_pm_lock_release(ctx->pm_cpu);
+  }
+#else
+  (void)ctx;
+#endif
+}
+
 static bool
 example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io,
                                 esp_lcd_panel_io_event_data_t *edata,
                                 void *user_ctx) {
   lv_display_t *disp = (lv_display_t *)user_ctx;
-  lv_display_flush_ready(disp);
+  display_ctx_t *ctx = lv_display_get_user_data(disp);
+  bool handed_over = draw_pipeline_complete(&ctx->pipeline);
+  uint32_t inflight = draw_pipeline_inflight(&ctx->pipeline);
+  trace_event(TRACE_FLUSH_DONE, inflight);
+  display_pm_frame_check_done(ctx);
+  // Only unblock LVGL if it was waiting for this buffer, otherwise it is
+  // already rendering into another one
+  if (handed_over) {
+    example_lvgl_use_render_buf(ctx);
+    lv_display_flush_ready(disp);
+  }
+  // Also wake anyone waiting for the panel to drain
+  if (handed_over || inflight == 0) {
+    return lvgl_port_flush_done_from_isr();
+  }
   return false;
 }
 
-static void example_increase_lvgl_tick(void *arg) {
-  /* Tell LVGL how many milliseconds has elapsed */
-  lv_tick_inc(EXAMPLE_LVGL_TICK_PERIOD_MS);
+static void example_lvgl_render_start_cb(lv_event_t *e) {
+  display_ctx_t *ctx = lv_event_get_user_data(e);
+  trace_event(TRACE_RENDER_START, 0);
+  display_pm_frame_begin(ctx);
+}
+
+static void example_lvgl_render_ready_cb(lv_event_t *e) {
+  display_ctx_t *ctx = lv_event_get_user_data(e);
+  // Strips still in flight: the frame is on the panel when they drain
+  trace_event(TRACE_RENDER_END, draw_pipeline_inflight(&ctx->pipeline));
+#if CONFIG_PM_ENABLE
+  atomic_store(&ctx->frame_rendered, true);
+#endif
+  display_pm_frame_check_done(ctx);
+}
+
+static uint32_t example_lvgl_tick_get(void) {
+  /* LVGL reads the time when it needs it instead of a periodic tick ISR */
+  return (uint32_t)(esp_timer_get_time() / 1000);
 }
 
 /* Rotate display and touch, when rotated screen in LVGL. Called when driver
  * parameters are updated. */
 static void example_lvgl_port_update_callback(lv_display_t *disp) {
-  esp_lcd_panel_handle_t panel_handle = lv_display_get_user_data(disp);
+  display_ctx_t *ctx = lv_display_get_user_data(disp);
   lv_display_rotation_t rotation = lv_display_get_rotation(disp);
 
+  // Goes through the panel shadow, so this only costs SPI commands when the
+  // rotation actually changed
   switch (rotation) {
   case LV_DISPLAY_ROTATION_0:
     // Rotate LCD display
-    esp_lcd_panel_swap_xy(panel_handle, false);
-    esp_lcd_panel_mirror(panel_handle, true, false);
+    panel_state_swap_xy(ctx, false);
+    panel_state_mirror(ctx, true, false);
     break;
   case LV_DISPLAY_ROTATION_90:
     // Rotate LCD display
-    esp_lcd_panel_swap_xy(panel_handle, true);
-    esp_lcd_panel_mirror(panel_handle, true, true);
+    panel_state_swap_xy(ctx, true);
+    panel_state_mirror(ctx, true, true);
     break;
   case LV_DISPLAY_ROTATION_180:
     // Rotate LCD display
-    esp_lcd_panel_swap_xy(panel_handle, false);
-    esp_lcd_panel_mirror(panel_handle, false, true);
+    panel_state_swap_xy(ctx, false);
+    panel_state_mirror(ctx, false, true);
     break;
   case LV_DISPLAY_ROTATION_270:
     // Rotate LCD display
-    esp_lcd_panel_swap_xy(panel_handle, true);
-    esp_lcd_panel_mirror(panel_handle, false, false);
+    panel_state_swap_xy(ctx, true);
+    panel_state_mirror(ctx, false, false);
     break;
   }
 }
 
+static uint32_t area_size(int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+  return (uint32_t)(x2 - x1 + 1) * (uint32_t)(y2 - y1 + 1);
+}
+
+/* Coalesce a freshly invalidated area into an already pending one when the
+ * extra pixels the bounding box would re-render cost less than the
+ * CASET/RASET/RAMWR round trip of flushing it as a separate window. LVGL's own
+ * join only merges when the bounding box is smaller than both areas.
+ *
+ * LVGL also sends this event while rendering, with a one-column area as tall
+ * as a strip could be, to learn how rounding changes strip heights. Merging
+ * that probe would grow it past the draw buffer, and rewrite inv_areas under
+ * the refresh that is walking them.
+ *
+ * With tile skipping the area is first rounded out to whole tiles, the probe
+ * too, so strips then cover whole tile rows. */
+static void example_lvgl_invalidate_cb(lv_event_t *e) {
+  lv_display_t *disp = lv_event_get_user_data(e);
+  display_ctx_t *ctx = lv_display_get_user_data(disp);
+  lv_area_t *area = lv_event_get_param(e);
+  if (ctx->tile_skip) {
+    tile_hash_round(&ctx->tiles, &area->x1, &area->y1, &area->x2, &area->y2);
+  }
+  // The strip height probe is not an invalid area
+  if (disp->rendering_in_progress) {
+    return;
+  }
+  uint32_t area_px = area_size(area->x1, area->y1, area->x2, area->y2);
+
+  for (uint32_t i = 0; i < disp->inv_p; i++) {
+    lv_area_t *inv = &disp->inv_areas[i];
+    int32_t x1 = LV_MIN(inv->x1, area->x1);
+    int32_t y1 = LV_MIN(inv->y1, area->y1);
+    int32_t x2 = LV_MAX(inv->x2, area->x2);
+    int32_t y2 = LV_MAX(inv->y2, area->y2);
+
+    uint32_t covered = area_px + area_size(inv->x1, inv->y1, inv->x2, inv->y2);
+    int32_t ix1 = LV_MAX(inv->x1, area->x1);
+    int32_t iy1 = LV_MAX(inv->y1, area->y1);
+    int32_t ix2 = LV_MIN(inv->x2, area->x2);
+    int32_t iy2 = LV_MIN(inv->y2, area->y2);
+    if (ix1 <= ix2 && iy1 <= iy2) {
+      covered -= area_size(ix1, iy1, ix2, iy2);
+    }
+
+    if (area_size(x1, y1, x2, y2) - covered <= EXAMPLE_LVGL_MERGE_SLACK_PX) {
+      inv->x1 = x1;
+      inv->y1 = y1;
+      inv->x2 = x2;
+      inv->y2 = y2;
+      // LVGL drops the new area since it now lies inside inv_areas[i]
+      *area = *inv;
+      ctx->stats.areas_merged++;
+      return;
+    }
+  }
+}
+
+static bool example_lvgl_set_window(display_ctx_t *ctx, int32_t x1,
+                                    int32_t y1, int32_t x2, int32_t y2) {
+  bool ok = panel_state_range(ctx, LCD_CMD_CASET, PANEL_KNOWN_CASET,
+                              ctx->shadow.caset, x1, x2);
+  return panel_state_range(ctx, LCD_CMD_RASET, PANEL_KNOWN_RASET,
+                           ctx->shadow.raset, y1, y2) &&
+         ok;
+}
+
+/* Send a block of pixels, appending to the panel window the previous block
+ * left open when this one continues it */
+static void example_lvgl_send(display_ctx_t *ctx, lv_display_t *disp,
+                              int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                              const uint8_t *px) {
+  size_t len = area_size(x1, y1, x2, y2) * 2;
+  bool continues = ctx->window != WINDOW_CLOSED && ctx->window_x1 == x1 &&
+                   ctx->window_x2 == x2 && ctx->window_next_y == y1;
+  if (continues && ctx->window == WINDOW_STREAMING) {
+    // LVGL is handing out the next strip of the same area: append the pixels
+    // to the running RAMWR. No command phase, so the transaction is queued
+    // behind the previous one instead of waiting for it to drain.
+    esp_lcd_panel_io_tx_color(ctx->io, -1, px, len);
+    ctx->stats.strips_streamed++;
+  } else if (continues) {
+    esp_lcd_panel_io_tx_color(ctx->io, LCD_CMD_RAMWRC, px, len);
+    ctx->stats.strips_resumed++;
+  } else {
+    // Open the window down to the last row so following strips of the same
+    // area can continue without another CASET/RASET
+    bool opened = example_lvgl_set_window(
+        ctx, x1, y1, x2, lv_display_get_vertical_resolution(disp) - 1);
+    // Sent either way, the pipeline counts on the transfer completing
+    esp_lcd_panel_io_tx_color(ctx->io, LCD_CMD_RAMWR, px, len);
+    ctx->stats.windows++;
+    if (!opened) {
+      // Not continued: the next strip sets its window again
+      return;
+    }
+  }
+  ctx->window = WINDOW_STREAMING;
+  ctx->window_x1 = x1;
+  ctx->window_x2 = x2;
+  ctx->window_next_y = y2 + 1;
+}
+
 static void example_lvgl_flush_cb(lv_display_t *disp, const lv_area_t *area,
                                   uint8_t *px_map) {
   example_lvgl_port_update_callback(disp);
-  esp_lcd_panel_handle_t panel_handle = lv_display_get_user_data(disp);
-  int offsetx1 = area->x1;
-  int offsetx2 = area->x2;
-  int offsety1 = area->y1;
-  int offsety2 = area->y2;
-  // because SPI LCD is big-endian, we need to swap the RGB bytes order
-  lv_draw_sw_rgb565_swap(px_map,
-                         (offsetx2 + 1 - offsetx1) * (offsety2 + 1 - offsety1));
-  // copy a buffer's content to a specific area of the display
-  esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1,
-                            offsety2 + 1, px_map);
+  display_ctx_t *ctx = lv_display_get_user_data(disp);
+  tile_hash_span_t spans[TILE_HASH_MAX_SPANS];
+  uint32_t n = 1;
+  if (ctx->tile_skip) {
+    // Before the byte swap, so the swap skips the dropped tiles as well
+    n = tile_hash_filter(&ctx->tiles, area->x1, area->y1, area->x2, area->y2,
+                         px_map, spans);
+  } else {
+    spans[0] = (tile_hash_span_t){area->x1, area->y1, area->x2, area->y2, 0};
+  }
+  if (n == 0) {
+    // The panel already shows all of it, LVGL can have the buffer back
+    trace_event(TRACE_FLUSH_SUBMIT, lv_display_flush_is_last(disp));
+    lv_display_flush_ready(disp);
+    return;
+  }
+  const tile_hash_span_t *last = &spans[n - 1];
+  size_t px_count =
+      last->offset / 2 + area_size(last->x1, last->y1, last->x2, last->y2);
+  // because SPI LCD is big-endian, we need to swap the RGB bytes order unless
+  // LVGL already rendered them that way
+#if CONFIG_EXAMPLE_LCD_RGB565_SWAP_LVGL
+  lv_draw_sw_rgb565_swap(px_map, px_count);
+#elif CONFIG_EXAMPLE_LCD_RGB565_SWAP_WORDS
+  rgb565_swap_words(px_map, px_count);
+#else
+  (void)px_count;
+#endif
+
+  // the transfers may complete before tx_color returns
+  draw_pipeline_submit(&ctx->pipeline, n);
+  trace_event(TRACE_FLUSH_SUBMIT, lv_display_flush_is_last(disp));
+  for (uint32_t i = 0; i < n; i++) {
+    example_lvgl_send(ctx, disp, spans[i].x1, spans[i].y1, spans[i].x2,
+                      spans[i].y2, px_map + spans[i].offset);
+  }
+
+  // Let LVGL render the next chunk right away if a buffer is free, else the
+  // transfer-done callback hands it the first one that finishes
+  if (draw_pipeline_acquire(&ctx->pipeline)) {
+    example_lvgl_use_render_buf(ctx);
+    lv_display_flush_ready(disp);
+  }
+}
+
+/* Rotation lays the grid out again, and the panel content is unknown until
+ * the full redraw that follows */
+static void example_lvgl_resolution_cb(lv_event_t *e) {
+  lv_display_t *disp = lv_event_get_target(e);
+  display_ctx_t *ctx = lv_display_get_user_data(disp);
+  tile_hash_set_resolution(&ctx->tiles,
+                           lv_display_get_horizontal_resolution(disp),
+                           lv_display_get_vertical_resolution(disp));
+}
+
+void display_set_tile_skip(bool on) {
+  display_ctx_t *ctx = &s_display_ctx;
+  if (on && ctx->pipeline.buf_size <
+                EXAMPLE_LCD_H_RES * TILE_HASH_SIZE * sizeof(lv_color16_t)) {
+    // LVGL cannot fit a strip rounded to whole tiles into the buffer
+    ESP_LOGW(TAG, "Draw buffers under %d lines, no tile skipping",
+             TILE_HASH_SIZE);
+    on = false;
+  }
+  if (on && !ctx->tile_skip) {
+    tile_hash_reset(&ctx->tiles);
+  }
+  ctx->tile_skip = on;
+}
+
+void display_get_flush_stats(display_flush_stats_t *out) {
+  *out = s_display_ctx.stats;
+  out->draw_bufs = s_display_ctx.pipeline.count;
+  out->draw_buf_lines = s_display_ctx.pipeline.buf_size /
+                        (EXAMPLE_LCD_H_RES * sizeof(lv_color16_t));
+  out->render_stalls = s_display_ctx.pipeline.stalls;
+  const tile_hash_stats_t *tiles = &s_display_ctx.tiles.stats;
+  out->tiles_hashed = tiles->tiles_hashed;
+  out->tiles_skipped = tiles->tiles_skipped;
+  out->tiles_partial = tiles->tiles_partial;
+  out->strips_skipped = tiles->strips_skipped;
+  out->bytes_skipped = tiles->bytes_skipped;
+}
+
+/* Size the draw buffers from what the DMA-capable heap can spare right now */
+static void example_lvgl_alloc_draw_bufs(display_ctx_t *ctx) {
+  const draw_pipeline_policy_t policy = {
+      .count_max = CONFIG_EXAMPLE_LVGL_DRAW_BUF_COUNT_MAX,
+      .lines_min = CONFIG_EXAMPLE_LVGL_DRAW_BUF_LINES_MIN,
+      .lines_max = CONFIG_EXAMPLE_LVGL_DRAW_BUF_LINES_MAX,
+      .heap_percent = CONFIG_EXAMPLE_LVGL_DRAW_BUF_HEAP_PERCENT,
+      .heap_reserve = CONFIG_EXAMPLE_LVGL_DRAW_BUF_HEAP_RESERVE_KB * 1024,
+#if CONFIG_EXAMPLE_LVGL_DRAW_BUF_PREFER_COUNT
+      .prefer_count = true,
+#endif
+  };
+  size_t line_bytes = EXAMPLE_LCD_H_RES * sizeof(lv_color16_t);
+  size_t free_bytes = heap_caps_get_free_size(MALLOC_CAP_DMA);
+  draw_pipeline_plan_t plan;
+  if (!draw_pipeline_plan(&policy, line_bytes, free_bytes,
+                          heap_caps_get_largest_free_block(MALLOC_CAP_DMA),
+                          &plan)) {
+    ESP_LOGW(TAG, "Only %u bytes DMA heap free, using minimal draw buffer",
+             (unsigned)free_bytes);
+  }
+  ESP_LOGI(TAG, "%u draw buffers of %u lines (%u bytes DMA heap free)",
+           (unsigned)plan.count, (unsigned)plan.lines, (unsigned)free_bytes);
+
+  size_t draw_buffer_sz = plan.lines * line_bytes;
+  uint8_t *bufs[DRAW_PIPELINE_MAX_BUFS];
+  for (uint32_t i = 0; i < plan.count; i++) {
+    bufs[i] = spi_bus_dma_memory_alloc(LCD_HOST, draw_buffer_sz, 0);
+    assert(bufs[i]);
+  }
+  draw_pipeline_init(&ctx->pipeline, bufs, plan.count, draw_buffer_sz);
+}
+
+void display_get_panel_stats(display_panel_stats_t *out) {
+  *out = s_display_ctx.panel_stats;
+}
+
+/* Backlight on LEDC so the governor can dim it. The channel starts dark and
+ * stays that way until the panel shows something. */
+static void example_backlight_init(void) {
+  ledc_timer_config_t timer_config = {
+      .speed_mode = BK_LIGHT_LEDC_MODE,
+      .duty_resolution = BK_LIGHT_LEDC_BITS,
+      .timer_num = BK_LIGHT_LEDC_TIMER,
+      .freq_hz = EXAMPLE_LCD_BK_LIGHT_PWM_HZ,
+      .clk_cfg = LEDC_USE_XTAL_CLK,
+  };
+  ESP_ERROR_CHECK(ledc_timer_config(&timer_config));
+  ledc_channel_config_t channel_config = {
+      .gpio_num = EXAMPLE_PIN_NUM_BK_LIGHT,
+      .speed_mode = BK_LIGHT_LEDC_MODE,
+      .channel = BK_LIGHT_LEDC_CHANNEL,
+      .timer_sel = BK_LIGHT_LEDC_TIMER,
+      .duty = 0,
+      .flags.output_invert = !EXAMPLE_LCD_BK_LIGHT_ON_LEVEL,
+  };
+  ESP_ERROR_CHECK(ledc_channel_config(&channel_config));
+  ESP_ERROR_CHECK(ledc_fade_func_install(0));
+}
+
+void display_set_backlight(uint8_t percent) {
+  percent = LV_MIN(percent, 100);
+  if (percent == s_display_ctx.backlight) {
+    return;
+  }
+  uint32_t duty = ((1u << BK_LIGHT_LEDC_BITS) - 1) * percent / 100;
+  // A fade still running holds the LEDC fade lock, and the calls below would
+  // block on it until it ends: cut it short at the duty it reached
+  ledc_fade_stop(BK_LIGHT_LEDC_MODE, BK_LIGHT_LEDC_CHANNEL);
+  if (percent < s_display_ctx.backlight) {
+    // Dimming fades out, anything brighter is there at once for the touch
+    // that woke the screen
+    ledc_set_fade_time_and_start(BK_LIGHT_LEDC_MODE, BK_LIGHT_LEDC_CHANNEL,
+                                 duty, EXAMPLE_LCD_BK_LIGHT_FADE_MS,
+                                 LEDC_FADE_NO_WAIT);
+  } else {
+    ledc_set_duty_and_update(BK_LIGHT_LEDC_MODE, BK_LIGHT_LEDC_CHANNEL, duty,
+                             0);
+  }
+  s_display_ctx.backlight = percent;
+}
+
+uint8_t display_get_backlight(void) { return s_display_ctx.backlight; }
+
+uint32_t display_transfers_inflight(void) {
+  return draw_pipeline_inflight(&s_display_ctx.pipeline);
 }
 
 lv_display_t *display_init(void) {
@@ -78,11 +601,18 @@ lv_display_t *display_init(void) {
   /*
    * Initalize the SPI bus
    */
+  tile_hash_init(&s_display_ctx.tiles, s_tile_hashes, DISPLAY_TILES);
+  tile_hash_set_resolution(&s_display_ctx.tiles, EXAMPLE_LCD_H_RES,
+                           EXAMPLE_LCD_V_RES);
+
   ESP_LOGI(TAG, "Turn off LCD backlight");
-  gpio_config_t bk_gpio_config = {.mode = GPIO_MODE_OUTPUT,
-                                  .pin_bit_mask = 1ULL
-                                                  << EXAMPLE_PIN_NUM_BK_LIGHT};
-  ESP_ERROR_CHECK(gpio_config(&bk_gpio_config));
+  example_backlight_init();
+#if CONFIG_PM_ENABLE
+  ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "lcd_cpu",
+                                     &s_display_ctx.pm_cpu));
+  ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "lcd_apb",
+                                     &s_display_ctx.pm_apb));
+#endif
 
   ESP_LOGI(TAG, "Initialize SPI bus");
   spi_bus_config_t buscfg = {
@@ -129,19 +659,21 @@ lv_display_t *display_init(void) {
       esp_lcd_new_panel_gc9a01(io_handle, &panel_config, &panel_handle));
 #endif
 
+  s_display_ctx.panel = panel_handle;
+  s_display_ctx.io = io_handle;
+
   ESP_ERROR_CHECK(esp_lcd_panel_reset(panel_handle));
   ESP_ERROR_CHECK(esp_lcd_panel_init(panel_handle));
+  panel_state_forget(&s_display_ctx);
 #if CONFIG_EXAMPLE_LCD_CONTROLLER_GC9A01
-  ESP_ERROR_CHECK(esp_lcd_panel_invert_color(panel_handle, true));
+  ESP_ERROR_CHECK(panel_state_invert(&s_display_ctx, true));
 #endif
-  ESP_ERROR_CHECK(esp_lcd_panel_mirror(panel_handle, true, false));
+  ESP_ERROR_CHECK(panel_state_swap_xy(&s_display_ctx, false));
+  ESP_ERROR_CHECK(panel_state_mirror(&s_display_ctx, true, false));
 
-  // user can flush pre-defined pattern to the screen before we turn on the
-  // screen or backlight
-  ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
-
-  ESP_LOGI(TAG, "Turn on LCD backlight");
-  gpio_set_level(EXAMPLE_PIN_NUM_BK_LIGHT, EXAMPLE_LCD_BK_LIGHT_ON_LEVEL);
+  // The backlight stays off until the LVGL task has the first frame on the
+  // panel, so the power-on RAM content is never seen
+  ESP_ERROR_CHECK(panel_state_on_off(&s_display_ctx, true));
 
   /*
    * Initalize the LVGL library
@@ -154,34 +686,42 @@ lv_display_t *display_init(void) {
       lv_display_create(EXAMPLE_LCD_H_RES, EXAMPLE_LCD_V_RES);
 
   // alloc draw buffers used by LVGL
-  // it's recommended to choose the size of the draw buffer(s) to be at least
-  // 1/10 screen sized
-  size_t draw_buffer_sz =
-      EXAMPLE_LCD_H_RES * EXAMPLE_LVGL_DRAW_BUF_LINES * sizeof(lv_color16_t);
-
-  void *buf1 = spi_bus_dma_memory_alloc(LCD_HOST, draw_buffer_sz, 0);
-  assert(buf1);
-  void *buf2 = spi_bus_dma_memory_alloc(LCD_HOST, draw_buffer_sz, 0);
-  assert(buf2);
-  // initialize LVGL draw buffers
-  lv_display_set_buffers(display, buf1, buf2, draw_buffer_sz,
+  // LVGL runs single-buffered on top of the pipeline: each flush swaps its
+  // draw buffer to a free DMA buffer, so it can run ahead of the transfers by
+  // as many buffers as the heap allowed
+  example_lvgl_alloc_draw_bufs(&s_display_ctx);
+  lv_display_set_buffers(display, s_display_ctx.pipeline.render_buf, NULL,
+                         s_display_ctx.pipeline.buf_size,
                          LV_DISPLAY_RENDER_MODE_PARTIAL);
-  // associate the mipi panel handle to the display
-  lv_display_set_user_data(display, panel_handle);
+  s_display_ctx.draw_buf = lv_display_get_buf_active(display);
+  // associate the mipi panel and its IO handle to the display
+  lv_display_set_user_data(display, &s_display_ctx);
   // set color depth
+#if CONFIG_EXAMPLE_LCD_RGB565_RENDER_SWAPPED
+  lv_display_set_color_format(display, LV_COLOR_FORMAT_RGB565_SWAPPED);
+#else
   lv_display_set_color_format(display, LV_COLOR_FORMAT_RGB565);
+#endif
   // set the callback which can copy the rendered image to an area of the
   // display
   lv_display_set_flush_cb(display, example_lvgl_flush_cb);
+  // merge small neighbouring invalid areas before LVGL renders them
+  lv_display_add_event_cb(display, example_lvgl_invalidate_cb,
+                          LV_EVENT_INVALIDATE_AREA, display);
+  lv_display_add_event_cb(display, example_lvgl_resolution_cb,
+                          LV_EVENT_RESOLUTION_CHANGED, NULL);
+#if CONFIG_EXAMPLE_LCD_FLUSH_TILE_SKIP
+  display_set_tile_skip(true);
+#endif
+  // touch-to-photon trace points and the frame's power locks
+  lv_display_add_event_cb(display, example_lvgl_render_start_cb,
+                          LV_EVENT_RENDER_START, &s_display_ctx);
+  lv_display_add_event_cb(display, example_lvgl_render_ready_cb,
+                          LV_EVENT_RENDER_READY, &s_display_ctx);
 
-  ESP_LOGI(TAG, "Install LVGL tick timer");
-  // Tick interface for LVGL (using esp_timer to generate 2ms periodic event)
-  const esp_timer_create_args_t lvgl_tick_timer_args = {
-      .callback = &example_increase_lvgl_tick, .name = "lvgl_tick"};
-  esp_timer_handle_t lvgl_tick_timer = NULL;
-  ESP_ERROR_CHECK(esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer));
-  ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer,
-                                           EXAMPLE_LVGL_TICK_PERIOD_MS * 1000));
+  ESP_LOGI(TAG, "Install LVGL tick source");
+  // Tick interface for LVGL (read from esp_timer, no periodic wakeup)
+  lv_tick_set_cb(example_lvgl_tick_get);
 
   ESP_LOGI(
       TAG,
@@ -0,0 +1,209 @@
+#include "dlog.h"
+#include "config.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+_Static_assert((DLOG_RING_LEN & (DLOG_RING_LEN - 1)) == 0,
+               "DLOG_RING_LEN must be a power of two");
+
+#define DLOG_RING_MAGIC 0x474f4c44 // "DLOG"
+
+/* One ring per core, so the cores never contend. Tasks and ISRs on the same
+ * core claim slots with an atomic add and publish them through lap, like
+ * trace.c. The rings live in RAM a software reset leaves alone, so what a
+ * panic interrupted can be printed after the reboot. */
+typedef struct {
+  uint32_t magic;
+  _Atomic uint32_t head; // next record index, never wraps in practice
+  uint32_t cursor;       // next record the flush task prints
+  dlog_record_t records[DLOG_RING_LEN];
+} dlog_ring_t;
+
+static __NOINIT_ATTR dlog_ring_t s_rings[portNUM_PROCESSORS];
+static _Atomic uint8_t s_level = ESP_LOG_VERBOSE;
+static _Atomic uint32_t s_filtered;
+static _Atomic uint32_t s_truncated;
+static uint32_t s_lost;    // under s_flush_lock
+static uint32_t s_flushed; // under s_flush_lock
+static uint32_t s_panic_records;
+static TaskHandle_t s_task;
+// The flush task and a console command may both drain
+static SemaphoreHandle_t s_flush_lock;
+
+// Non-zero tag of the ring pass record idx belongs to
+static uint8_t dlog_lap(uint32_t idx) {
+  return (uint8_t)((idx / DLOG_RING_LEN) % 255 + 1);
+}
+
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt,
+                uint32_t wide, uint32_t nargs, const uint64_t *args) {
+  if (level > atomic_load_explicit(&s_level, memory_order_relaxed)) {
+    atomic_fetch_add_explicit(&s_filtered, 1, memory_order_relaxed);
+    return;
+  }
+  uint32_t core = esp_cpu_get_core_id();
+  dlog_ring_t *ring = &s_rings[core];
+  uint32_t idx = atomic_fetch_add_explicit(&ring->head, 1,
+                                           memory_order_relaxed);
+  dlog_record_t *slot = &ring->records[idx % DLOG_RING_LEN];
+  // Readers skip the slot while lap does not match, publish it last
+  __atomic_store_n(&slot->lap, 0, __ATOMIC_RELAXED);
+  slot->time_us = (uint32_t)esp_timer_get_time();
+  slot->fmt = (uint32_t)(uintptr_t)fmt;
+  slot->tag = (uint32_t)(uintptr_t)tag;
+  slot->level = level;
+  slot->core = core;
+  uint32_t n = 0;
+  bool truncated = false;
+  for (uint32_t i = 0; i < nargs; i++) {
+    uint32_t words = (wide >> i) & 1 ? 2 : 1;
+    if (n + words > DLOG_MAX_WORDS) {
+      truncated = true;
+      break;
+    }
+    slot->args[n++] = (uint32_t)args[i];
+    if (words == 2) {
+      slot->args[n++] = (uint32_t)(args[i] >> 32);
+    }
+  }
+  slot->nwords = n | (truncated ? DLOG_WORDS_TRUNCATED : 0);
+  if (truncated) {
+    atomic_fetch_add_explicit(&s_truncated, 1, memory_order_relaxed);
+  }
+  __atomic_store_n(&slot->lap, dlog_lap(idx), __ATOMIC_RELEASE);
+
+  // Half full: flush before the period is up rather than lose records
+  if (s_task && idx - ring->cursor == DLOG_RING_LEN / 2) {
+    if (xPortInIsrContext()) {
+      BaseType_t woken = pdFALSE;
+      vTaskNotifyGiveFromISR(s_task, &woken);
+      portYIELD_FROM_ISR(woken);
+    } else {
+      xTaskNotifyGive(s_task);
+    }
+  }
+}
+
+// False when the record at idx is not written yet or was overwritten
+static bool dlog_read(const dlog_ring_t *ring, uint32_t idx,
+                      dlog_record_t *out) {
+  const dlog_record_t *slot = &ring->records[idx % DLOG_RING_LEN];
+  uint8_t lap = dlog_lap(idx);
+  if (__atomic_load_n(&slot->lap, __ATOMIC_ACQUIRE) != lap) {
+    return false;
+  }
+  *out = *slot;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&slot->lap, __ATOMIC_RELAXED) == lap;
+}
+
+static void dlog_print_record(const dlog_record_t *rec) {
+  char line[sizeof(DLOG_LINE_PREFIX) + 2 * sizeof(*rec)];
+  char *p = line + sprintf(line, "%s", DLOG_LINE_PREFIX);
+  const uint8_t *bytes = (const uint8_t *)rec;
+  for (size_t b = 0; b < sizeof(*rec); b++) {
+    p += sprintf(p, "%02x", bytes[b]);
+  }
+  puts(line);
+}
+
+/* Print the records of ring from its cursor on, returns how many. A record
+ * still being written stops the drain, unless this is the last one: after a
+ * panic it never will be. */
+static uint32_t dlog_drain(dlog_ring_t *ring, bool last) {
+  uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  uint32_t printed = 0;
+  if (head - ring->cursor > DLOG_RING_LEN) {
+    uint32_t lost = head - ring->cursor - DLOG_RING_LEN;
+    printf(DLOG_LINE_PREFIX "LOST %u\n", (unsigned)lost);
+    s_lost += lost;
+    ring->cursor = head - DLOG_RING_LEN;
+  }
+  for (; ring->cursor != head; ring->cursor++) {
+    dlog_record_t rec;
+    if (!dlog_read(ring, ring->cursor, &rec)) {
+      if (last) {
+        continue;
+      }
+      break; // pick it up next time
+    }
+    dlog_print_record(&rec);
+    printed++;
+  }
+  return printed;
+}
+
+void dlog_flush(void) {
+  if (!s_flush_lock) {
+    return;
+  }
+  xSemaphoreTake(s_flush_lock, portMAX_DELAY);
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    s_flushed += dlog_drain(&s_rings[core], false);
+  }
+  xSemaphoreGive(s_flush_lock);
+}
+
+static void dlog_task(void *arg) {
+  (void)arg;
+  while (1) {
+    // Woken early when a ring is half full, see dlog_write
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DLOG_FLUSH_PERIOD_MS));
+    dlog_flush();
+  }
+}
+
+/* Records a panic left behind: everything not printed before the reset. On
+ * any other reset the RAM holds nothing worth reading. */
+static void dlog_recover(void) {
+  esp_reset_reason_t reason = esp_reset_reason();
+  bool crashed = reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+                 reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    dlog_ring_t *ring = &s_rings[core];
+    if (crashed && ring->magic == DLOG_RING_MAGIC) {
+      uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+      uint32_t pending = head - ring->cursor;
+      pending = pending > DLOG_RING_LEN ? DLOG_RING_LEN : pending;
+      printf(DLOG_LINE_PREFIX "PANIC %u\n", (unsigned)pending);
+      ring->cursor = head - pending;
+      s_panic_records += dlog_drain(ring, true);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->magic = DLOG_RING_MAGIC;
+  }
+  puts(DLOG_LINE_PREFIX "BOOT");
+}
+
+void dlog_init(void) {
+  dlog_recover();
+  s_flush_lock = xSemaphoreCreateMutex();
+  assert(s_flush_lock);
+  xTaskCreate(dlog_task, "DLOG", DLOG_TASK_STACK_SIZE, NULL,
+              DLOG_TASK_PRIORITY, &s_task);
+}
+
+void dlog_set_level(esp_log_level_t level) {
+  atomic_store_explicit(&s_level, level, memory_order_relaxed);
+}
+
+void dlog_get_stats(dlog_stats_t *out) {
+  uint32_t written = 0;
+  for (int core = 0; core < portNUM_PROCESSORS; core++) {
+    written += atomic_load_explicit(&s_rings[core].head, memory_order_relaxed);
+  }
+  out->written = written;
+  out->filtered = atomic_load_explicit(&s_filtered, memory_order_relaxed);
+  out->lost = s_lost;
+  out->truncated = atomic_load_explicit(&s_truncated, memory_order_relaxed);
+  out->flushed = s_flushed;
+  out->panic_records = s_panic_records;
+}
@@ -0,0 +1,140 @@
+#include "draw_pipeline.h"
+#include <string.h>
+
+#define DRAW_PIPELINE_WAITING (1u << 31)
+
+static bool plan_fits(uint32_t count, uint32_t lines, size_t line_bytes,
+                      size_t budget, size_t largest_block) {
+  size_t buf_size = lines * line_bytes;
+  return buf_size <= largest_block && count * buf_size <= budget;
+}
+
+bool draw_pipeline_plan(const draw_pipeline_policy_t *policy,
+                        size_t line_bytes, size_t free_bytes,
+                        size_t largest_block, draw_pipeline_plan_t *out) {
+  size_t budget = free_bytes * policy->heap_percent / 100;
+  if (free_bytes < policy->heap_reserve) {
+    budget = 0;
+  } else if (budget > free_bytes - policy->heap_reserve) {
+    budget = free_bytes - policy->heap_reserve;
+  }
+
+  uint32_t count_max = policy->count_max;
+  if (count_max > DRAW_PIPELINE_MAX_BUFS) {
+    count_max = DRAW_PIPELINE_MAX_BUFS;
+  }
+
+  if (policy->prefer_count) {
+    // As many buffers as possible, each as tall as the rest of the budget
+    // allows
+    for (uint32_t count = count_max; count > 0; count--) {
+      uint32_t lines = budget / count / line_bytes;
+      if (lines > policy->lines_max) {
+        lines = policy->lines_max;
+      }
+      while (lines >= policy->lines_min &&
+             !plan_fits(count, lines, line_bytes, budget, largest_block)) {
+        lines--;
+      }
+      if (lines >= policy->lines_min) {
+        *out = (draw_pipeline_plan_t){.count = count, .lines = lines};
+        return true;
+      }
+    }
+  } else {
+    // Two buffers are the minimum for render/transfer overlap: make those as
+    // tall as possible, then add buffers of that height while they fit
+    uint32_t count_min = count_max < 2 ? count_max : 2;
+    for (uint32_t count = count_min; count > 0; count--) {
+      for (uint32_t lines = policy->lines_max;
+           lines >= policy->lines_min && lines > 0; lines--) {
+        if (!plan_fits(count, lines, line_bytes, budget, largest_block)) {
+          continue;
+        }
+        while (count < count_max &&
+               plan_fits(count + 1, lines, line_bytes, budget, largest_block)) {
+          count++;
+        }
+        *out = (draw_pipeline_plan_t){.count = count, .lines = lines};
+        return true;
+      }
+    }
+  }
+
+  *out = (draw_pipeline_plan_t){.count = 1, .lines = policy->lines_min};
+  return false;
+}
+
+void draw_pipeline_init(draw_pipeline_t *p, uint8_t *const *bufs,
+                        uint32_t count, size_t buf_size) {
+  memset(p, 0, sizeof(*p));
+  memcpy(p->bufs, bufs, count * sizeof(bufs[0]));
+  p->count = count;
+  p->buf_size = buf_size;
+  p->render_idx = 0;
+  p->render_buf = bufs[0];
+  // Every buffer but the one LVGL starts rendering into is free
+  atomic_init(&p->state, ((1u << count) - 1) & ~1u);
+}
+
+void draw_pipeline_submit(draw_pipeline_t *p, uint32_t transfers) {
+  uint32_t tail = atomic_load_explicit(&p->inflight_tail, memory_order_relaxed);
+  p->inflight[tail % DRAW_PIPELINE_MAX_BUFS] = p->render_idx;
+  p->transfers[tail % DRAW_PIPELINE_MAX_BUFS] = transfers;
+  atomic_store_explicit(&p->inflight_tail, tail + 1, memory_order_release);
+}
+
+bool draw_pipeline_acquire(draw_pipeline_t *p) {
+  uint32_t state = atomic_load(&p->state);
+  while (1) {
+    uint32_t free_mask = state & ~DRAW_PIPELINE_WAITING;
+    if (free_mask) {
+      uint32_t idx = __builtin_ctz(free_mask);
+      if (atomic_compare_exchange_weak(&p->state, &state,
+                                       state & ~(1u << idx))) {
+        p->render_idx = idx;
+        p->render_buf = p->bufs[idx];
+        return true;
+      }
+    } else if (atomic_compare_exchange_weak(&p->state, &state,
+                                            state | DRAW_PIPELINE_WAITING)) {
+      p->stalls++;
+      return false;
+    }
+  }
+}
+
+bool draw_pipeline_complete(draw_pipeline_t *p) {
+  uint32_t head = atomic_load_explicit(&p->inflight_head, memory_order_relaxed);
+  if (head ==
+      atomic_load_explicit(&p->inflight_tail, memory_order_acquire)) {
+    return false; // spurious, nothing in flight
+  }
+  if (++p->head_done < p->transfers[head % DRAW_PIPELINE_MAX_BUFS]) {
+    return false;
+  }
+  p->head_done = 0;
+  uint32_t idx = p->inflight[head % DRAW_PIPELINE_MAX_BUFS];
+  atomic_store_explicit(&p->inflight_head, head + 1, memory_order_release);
+
+  uint32_t state = atomic_load(&p->state);
+  while (1) {
+    if (state & DRAW_PIPELINE_WAITING) {
+      if (atomic_compare_exchange_weak(&p->state, &state,
+                                       state & ~DRAW_PIPELINE_WAITING)) {
+        // The renderer is blocked, hand the buffer straight over
+        p->render_idx = idx;
+        p->render_buf = p->bufs[idx];
+        return true;
+      }
+    } else if (atomic_compare_exchange_weak(&p->state, &state,
+                                            state | (1u << idx))) {
+      return false;
+    }
+  }
+}
+
+uint32_t draw_pipeline_inflight(draw_pipeline_t *p) {
+  return atomic_load_explicit(&p->inflight_tail, memory_order_acquire) -
+         atomic_load_explicit(&p->inflight_head, memory_order_acquire);
+}
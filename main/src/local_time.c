@@ -0,0 +1,268 @@
+#include "local_time.h"
+#include <ctype.h>
+#include <string.h>
+
+#define SECS_PER_DAY 86400
+#define MAX_RULE_HOURS 167 // POSIX allows transition times up to a week out
+
+static int64_t floor_div(int64_t a, int64_t b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+static bool is_leap(int64_t y) {
+  return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+static int month_days(int64_t y, int m) {
+  static const uint8_t days[12] = {31, 28, 31, 30, 31, 30,
+                                   31, 31, 30, 31, 30, 31};
+  return days[m - 1] + (m == 2 && is_leap(y));
+}
+
+/* Days from 1970-01-01 to y-m-d in the proleptic Gregorian calendar, by
+ * counting from March so the leap day ends the year. */
+static int64_t days_from_civil(int64_t y, int m, int d) {
+  y -= m <= 2;
+  int64_t era = floor_div(y, 400);
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// The inverse, y-m-d of a day count
+static void civil_from_days(int64_t days, int64_t *y, int *m, int *d) {
+  days += 719468;
+  int64_t era = floor_div(days, 146097);
+  int64_t doe = days - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  *d = (int)(doy - (153 * mp + 2) / 5 + 1);
+  *m = (int)(mp < 10 ? mp + 3 : mp - 9);
+  *y = yoe + era * 400 + (*m <= 2);
+}
+
+// 0 for Sunday, 1970-01-01 was a Thursday
+static int weekday(int64_t days) {
+  int64_t w = (days + 4) % 7;
+  return (int)(w < 0 ? w + 7 : w);
+}
+
+// Day count of the rule's date in year y
+static int64_t rule_days(const local_tz_rule_t *r, int64_t y) {
+  int64_t jan1 = days_from_civil(y, 1, 1);
+  switch (r->kind) {
+  case LOCAL_TZ_RULE_JULIAN1:
+    return jan1 + r->day - 1 + (is_leap(y) && r->day >= 60);
+  case LOCAL_TZ_RULE_JULIAN0:
+    return jan1 + r->day;
+  default: {
+    int64_t first = days_from_civil(y, r->month, 1);
+    int d = 1 + (r->wday - weekday(first) + 7) % 7 + (r->week - 1) * 7;
+    while (d > month_days(y, r->month)) {
+      d -= 7; // week 5 is the last one, whichever that is
+    }
+    return first + d - 1;
+  }
+  }
+}
+
+static const char *parse_name(const char *p) {
+  if (*p == '<') {
+    const char *end = strchr(p, '>');
+    return end && end - p >= 4 ? end + 1 : NULL;
+  }
+  const char *start = p;
+  while (isalpha((unsigned char)*p)) {
+    p++;
+  }
+  return p - start >= 3 ? p : NULL;
+}
+
+static const char *parse_num(const char *p, int max, int *out) {
+  if (!isdigit((unsigned char)*p)) {
+    return NULL;
+  }
+  int v = 0;
+  while (isdigit((unsigned char)*p)) {
+    v = v * 10 + (*p++ - '0');
+    if (v > max) {
+      return NULL;
+    }
+  }
+  *out = v;
+  return p;
+}
+
+// [+-]hh[:mm[:ss]] in seconds
+static const char *parse_hms(const char *p, int max_hours, int32_t *out) {
+  int sign = 1;
+  if (*p == '+' || *p == '-') {
+    sign = *p++ == '-' ? -1 : 1;
+  }
+  int h, m = 0, s = 0;
+  if (!(p = parse_num(p, max_hours, &h))) {
+    return NULL;
+  }
+  if (*p == ':' && !(p = parse_num(p + 1, 59, &m))) {
+    return NULL;
+  }
+  if (*p == ':' && !(p = parse_num(p + 1, 59, &s))) {
+    return NULL;
+  }
+  *out = sign * (h * 3600 + m * 60 + s);
+  return p;
+}
+
+static const char *parse_rule(const char *p, local_tz_rule_t *r) {
+  int a, b, c;
+  *r = (local_tz_rule_t){.time = 2 * 3600};
+  if (*p == 'M') {
+    if (!(p = parse_num(p + 1, 12, &a)) || a < 1 || *p != '.' ||
+        !(p = parse_num(p + 1, 5, &b)) || b < 1 || *p != '.' ||
+        !(p = parse_num(p + 1, 6, &c))) {
+      return NULL;
+    }
+    r->kind = LOCAL_TZ_RULE_MONTH;
+    r->month = a;
+    r->week = b;
+    r->wday = c;
+  } else if (*p == 'J') {
+    if (!(p = parse_num(p + 1, 365, &a)) || a < 1) {
+      return NULL;
+    }
+    r->kind = LOCAL_TZ_RULE_JULIAN1;
+    r->day = a;
+  } else {
+    if (!(p = parse_num(p, 365, &a))) {
+      return NULL;
+    }
+    r->kind = LOCAL_TZ_RULE_JULIAN0;
+    r->day = a;
+  }
+  if (*p == '/') {
+    p = parse_hms(p + 1, MAX_RULE_HOURS, &r->time);
+  }
+  return p;
+}
+
+bool local_tz_parse(const char *rule, local_tz_t *out) {
+  local_tz_t tz = {0};
+  const char *p = parse_name(rule);
+  int32_t west;
+  if (!p || !(p = parse_hms(p, 24, &west))) {
+    return false;
+  }
+  tz.std_offset = tz.dst_offset = -west;
+  if (*p) {
+    if (!(p = parse_name(p))) {
+      return false;
+    }
+    tz.has_dst = true;
+    tz.dst_offset = tz.std_offset + 3600;
+    if (*p && *p != ',') {
+      if (!(p = parse_hms(p, 24, &west))) {
+        return false;
+      }
+      tz.dst_offset = -west;
+    }
+    if (!*p) {
+      p = ",M3.2.0,M11.1.0";
+    }
+    if (*p != ',' || !(p = parse_rule(p + 1, &tz.start)) || *p != ',' ||
+        !(p = parse_rule(p + 1, &tz.end)) || *p) {
+      return false;
+    }
+  }
+  *out = tz;
+  return true;
+}
+
+void local_time_init(local_time_t *lt, const local_tz_t *tz) {
+  memset(lt, 0, sizeof(*lt));
+  lt->tz = *tz;
+  // Empty span and day, the first conversion works both out
+  lt->span_start = INT64_MAX;
+  lt->day_start = INT64_MAX;
+}
+
+typedef struct {
+  int64_t at; // UTC
+  bool dst;   // in effect from then on
+} transition_t;
+
+/* The transitions of the years around utc, in order, bound the span. Three
+ * years cover rules past the turn of the year and southern zones, where
+ * DST spans it. */
+static void local_time_find_span(local_time_t *lt, int64_t utc) {
+  const local_tz_t *tz = &lt->tz;
+  lt->stats.span_changes++;
+  if (!tz->has_dst) {
+    lt->span_start = INT64_MIN;
+    lt->span_end = INT64_MAX;
+    lt->offset = tz->std_offset;
+    lt->dst = false;
+    return;
+  }
+  int64_t y;
+  int m, d;
+  civil_from_days(floor_div(utc + tz->std_offset, SECS_PER_DAY), &y, &m, &d);
+  transition_t t[6];
+  int n = 0;
+  for (int64_t yy = y - 1; yy <= y + 1; yy++) {
+    t[n++] = (transition_t){rule_days(&tz->start, yy) * SECS_PER_DAY +
+                                tz->start.time - tz->std_offset,
+                            true};
+    t[n++] = (transition_t){rule_days(&tz->end, yy) * SECS_PER_DAY +
+                                tz->end.time - tz->dst_offset,
+                            false};
+  }
+  for (int i = 1; i < n; i++) {
+    for (int j = i; j > 0 && t[j].at < t[j - 1].at; j--) {
+      transition_t tmp = t[j];
+      t[j] = t[j - 1];
+      t[j - 1] = tmp;
+    }
+  }
+  int last = 0;
+  while (last + 1 < n && t[last + 1].at <= utc) {
+    last++;
+  }
+  lt->span_start = t[last].at;
+  lt->span_end = last + 1 < n ? t[last + 1].at : INT64_MAX;
+  lt->dst = t[last].dst;
+  lt->offset = lt->dst ? tz->dst_offset : tz->std_offset;
+}
+
+static void local_time_set_day(local_time_t *lt, int64_t days) {
+  lt->stats.day_changes++;
+  int64_t y;
+  int m, d;
+  civil_from_days(days, &y, &m, &d);
+  lt->day_start = days * SECS_PER_DAY;
+  lt->day = (struct tm){
+      .tm_year = (int)(y - 1900),
+      .tm_mon = m - 1,
+      .tm_mday = d,
+      .tm_wday = weekday(days),
+      .tm_yday = (int)(days - days_from_civil(y, 1, 1)),
+  };
+}
+
+void local_time_get(local_time_t *lt, int64_t utc, struct tm *out) {
+  lt->stats.conversions++;
+  if (utc < lt->span_start || utc >= lt->span_end) {
+    local_time_find_span(lt, utc);
+  }
+  int64_t local = utc + lt->offset;
+  if (local < lt->day_start || local - lt->day_start >= SECS_PER_DAY) {
+    local_time_set_day(lt, floor_div(local, SECS_PER_DAY));
+  }
+  uint32_t sod = (uint32_t)(local - lt->day_start);
+  *out = lt->day;
+  out->tm_hour = sod / 3600;
+  out->tm_min = sod / 60 % 60;
+  out->tm_sec = sod % 60;
+  out->tm_isdst = lt->dst;
+}
@@ -0,0 +1,444 @@
+#include "lv_mem_pool.h"
+#include "config.h"
+#include "lvgl.h"
+#include <string.h>
+
+#if LV_USE_STDLIB_MALLOC != LV_STDLIB_CUSTOM
+#error "lv_mem_pool.c needs LV_USE_STDLIB_MALLOC = LV_STDLIB_CUSTOM"
+#endif
+
+#define POOL_PAGES (LV_MEM_POOL_SIZE / LV_MEM_POOL_PAGE_SIZE)
+#define NO_PAGE UINT16_MAX
+#define NO_SLOT UINT16_MAX
+
+_Static_assert(LV_MEM_POOL_SIZE % LV_MEM_POOL_PAGE_SIZE == 0,
+               "LV_MEM_POOL_SIZE must be a multiple of the page size");
+_Static_assert(POOL_PAGES < NO_PAGE, "too many pages");
+
+// Multiples of 8 so every slot stays 8-byte aligned
+static const uint16_t s_class_size[LV_MEM_POOL_CLASSES] = {
+    8, 16, 24, 32, 48, 64, 96, 128,
+};
+#define MAX_CLASS_SIZE 128
+
+typedef enum {
+  PAGE_FREE,
+  PAGE_SLAB,
+  PAGE_RUN,      // first page of a run
+  PAGE_RUN_TAIL, // the others
+} page_kind_t;
+
+typedef struct {
+  uint8_t kind;
+  uint8_t cls; // PAGE_SLAB
+  uint8_t arena;
+  uint16_t used;      // PAGE_SLAB: slots in use
+  uint16_t free_slot; // PAGE_SLAB: head of the free slot list
+  uint16_t next;      // PAGE_SLAB: next page with free slots, same arena
+  uint16_t run;       // PAGE_RUN: pages in the run
+  uint32_t bytes;     // PAGE_RUN: bytes requested
+} page_t;
+
+typedef struct {
+  bool open;
+  uint16_t partial[LV_MEM_POOL_CLASSES]; // slab pages with a free slot
+} arena_t;
+
+static uint8_t s_region[LV_MEM_POOL_SIZE] __attribute__((aligned(8)));
+static page_t s_pages[POOL_PAGES];
+static arena_t s_arenas[LV_MEM_POOL_ARENAS];
+static lv_mem_arena_t s_current;
+static lv_mem_pool_stats_t s_stats;
+
+static void *page_addr(uint32_t page) {
+  return &s_region[page * LV_MEM_POOL_PAGE_SIZE];
+}
+
+static uint16_t *slot_link(uint32_t page, uint32_t slot) {
+  uint8_t *p = page_addr(page);
+  return (uint16_t *)(p + slot * s_class_size[s_pages[page].cls]);
+}
+
+static int size_class(size_t size) {
+  for (int c = 0; c < LV_MEM_POOL_CLASSES; c++) {
+    if (size <= s_class_size[c]) {
+      return c;
+    }
+  }
+  return -1;
+}
+
+static void account_used(int32_t delta) {
+  s_stats.used += delta;
+  if (s_stats.used > s_stats.max_used) {
+    s_stats.max_used = s_stats.used;
+  }
+}
+
+/* Lowest run of n free pages, or the highest single free page for a slab */
+static uint32_t pages_find(uint32_t n, bool from_top) {
+  if (from_top) {
+    for (uint32_t p = POOL_PAGES; p-- > 0;) {
+      if (s_pages[p].kind == PAGE_FREE) {
+        return p;
+      }
+    }
+    return NO_PAGE;
+  }
+  uint32_t len = 0;
+  for (uint32_t p = 0; p < POOL_PAGES; p++) {
+    len = s_pages[p].kind == PAGE_FREE ? len + 1 : 0;
+    if (len == n) {
+      return p + 1 - n;
+    }
+  }
+  return NO_PAGE;
+}
+
+static void pages_free(uint32_t first, uint32_t n) {
+  for (uint32_t p = first; p < first + n; p++) {
+    s_stats.arena_pages[s_pages[p].arena]--;
+    s_pages[p] = (page_t){.kind = PAGE_FREE};
+  }
+  account_used(-(int32_t)(n * LV_MEM_POOL_PAGE_SIZE));
+}
+
+static void partial_remove(arena_t *a, int cls, uint32_t page) {
+  uint16_t *link = &a->partial[cls];
+  while (*link != NO_PAGE && *link != page) {
+    link = &s_pages[*link].next;
+  }
+  if (*link == page) {
+    *link = s_pages[page].next;
+  }
+}
+
+static void *slab_alloc(int cls) {
+  arena_t *a = &s_arenas[s_current];
+  uint32_t page = a->partial[cls];
+  if (page == NO_PAGE) {
+    page = pages_find(1, true);
+    if (page == NO_PAGE) {
+      return NULL;
+    }
+    // Thread the free list through the slots
+    uint32_t slots = LV_MEM_POOL_PAGE_SIZE / s_class_size[cls];
+    s_pages[page] = (page_t){.kind = PAGE_SLAB,
+                             .cls = cls,
+                             .arena = s_current,
+                             .free_slot = 0,
+                             .next = NO_PAGE};
+    for (uint32_t s = 0; s < slots; s++) {
+      *slot_link(page, s) = s + 1 < slots ? s + 1 : NO_SLOT;
+    }
+    a->partial[cls] = page;
+    s_stats.arena_pages[s_current]++;
+    account_used(LV_MEM_POOL_PAGE_SIZE);
+  }
+
+  page_t *pg = &s_pages[page];
+  uint32_t slot = pg->free_slot;
+  pg->free_slot = *slot_link(page, slot);
+  pg->used++;
+  if (pg->free_slot == NO_SLOT) {
+    a->partial[cls] = pg->next;
+  }
+  return (uint8_t *)page_addr(page) + slot * s_class_size[cls];
+}
+
+static void slab_free(uint32_t page, void *p) {
+  page_t *pg = &s_pages[page];
+  arena_t *a = &s_arenas[pg->arena];
+  uint32_t slot =
+      ((uint8_t *)p - (uint8_t *)page_addr(page)) / s_class_size[pg->cls];
+  if (pg->free_slot == NO_SLOT) {
+    pg->next = a->partial[pg->cls];
+    a->partial[pg->cls] = page;
+  }
+  *slot_link(page, slot) = pg->free_slot;
+  pg->free_slot = slot;
+  pg->used--;
+  // Arenas keep their empty slabs for the screen's next allocations and
+  // hand them back all at once
+  if (pg->used == 0 && pg->arena == LV_MEM_ARENA_SHARED) {
+    partial_remove(a, pg->cls, page);
+    pages_free(page, 1);
+  }
+}
+
+static void *run_alloc(size_t size) {
+  uint32_t n = (size + LV_MEM_POOL_PAGE_SIZE - 1) / LV_MEM_POOL_PAGE_SIZE;
+  uint32_t first = pages_find(n, false);
+  if (first == NO_PAGE) {
+    return NULL;
+  }
+  for (uint32_t p = first; p < first + n; p++) {
+    s_pages[p] = (page_t){.kind = p == first ? PAGE_RUN : PAGE_RUN_TAIL,
+                          .arena = s_current};
+  }
+  s_pages[first].run = n;
+  s_pages[first].bytes = size;
+  s_stats.arena_pages[s_current] += n;
+  account_used(n * LV_MEM_POOL_PAGE_SIZE);
+  return page_addr(first);
+}
+
+// Page of an allocation, NO_PAGE for pointers LVGL did not get from here
+static uint32_t owner_page(const void *p) {
+  const uint8_t *b = p;
+  if (b < s_region || b >= s_region + LV_MEM_POOL_SIZE) {
+    return NO_PAGE;
+  }
+  return (b - s_region) / LV_MEM_POOL_PAGE_SIZE;
+}
+
+static size_t alloc_size(uint32_t page) {
+  return s_pages[page].kind == PAGE_SLAB ? s_class_size[s_pages[page].cls]
+                                         : s_pages[page].bytes;
+}
+
+void lv_mem_init(void) {
+  memset(s_pages, 0, sizeof(s_pages));
+  memset(&s_stats, 0, sizeof(s_stats));
+  for (int a = 0; a < LV_MEM_POOL_ARENAS; a++) {
+    s_arenas[a].open = a == LV_MEM_ARENA_SHARED;
+    for (int c = 0; c < LV_MEM_POOL_CLASSES; c++) {
+      s_arenas[a].partial[c] = NO_PAGE;
+    }
+  }
+  s_current = LV_MEM_ARENA_SHARED;
+  s_stats.total = LV_MEM_POOL_SIZE;
+  s_stats.arena_pages[LV_MEM_ARENA_SHARED] = 0;
+}
+
+void lv_mem_deinit(void) { lv_mem_init(); }
+
+// One fixed region, LVGL cannot add more
+lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes) {
+  (void)mem;
+  (void)bytes;
+  return NULL;
+}
+
+void lv_mem_remove_pool(lv_mem_pool_t pool) { (void)pool; }
+
+void *lv_malloc_core(size_t size) {
+  int cls = size_class(size);
+  void *p = cls >= 0 ? slab_alloc(cls) : run_alloc(size);
+  if (!p) {
+    s_stats.failures++;
+    LV_LOG_WARN("LVGL pool out of memory for %u bytes", (unsigned)size);
+    return NULL;
+  }
+  s_stats.allocs++;
+  s_stats.live++;
+  s_stats.requested += cls >= 0 ? s_class_size[cls] : size;
+  return p;
+}
+
+void lv_free_core(void *p) {
+  uint32_t page = owner_page(p);
+  if (page == NO_PAGE) {
+    return;
+  }
+  s_stats.live--;
+  if (s_pages[page].kind == PAGE_SLAB) {
+    s_stats.requested -= s_class_size[s_pages[page].cls];
+    slab_free(page, p);
+  } else {
+    s_stats.requested -= s_pages[page].bytes;
+    pages_free(page, s_pages[page].run);
+  }
+}
+
+void *lv_realloc_core(void *p, size_t new_size) {
+  uint32_t page = owner_page(p);
+  if (page == NO_PAGE) {
+    return lv_malloc_core(new_size);
+  }
+  size_t old_size = alloc_size(page);
+  page_t *pg = &s_pages[page];
+  if (pg->kind == PAGE_SLAB && size_class(new_size) == pg->cls) {
+    return p;
+  }
+  uint32_t pages =
+      (new_size + LV_MEM_POOL_PAGE_SIZE - 1) / LV_MEM_POOL_PAGE_SIZE;
+  if (pg->kind == PAGE_RUN && new_size > MAX_CLASS_SIZE && pages <= pg->run) {
+    // Shrink in place, the tail pages go back to the region
+    if (pages < pg->run) {
+      pages_free(page + pages, pg->run - pages);
+      pg->run = pages;
+    }
+    s_stats.requested += new_size - pg->bytes;
+    pg->bytes = new_size;
+    return p;
+  }
+  // Allocate in the arena the block belongs to
+  lv_mem_arena_t prev = lv_mem_arena_enter(pg->arena);
+  void *n = lv_malloc_core(new_size);
+  lv_mem_arena_enter(prev);
+  if (!n) {
+    return NULL;
+  }
+  memcpy(n, p, old_size < new_size ? old_size : new_size);
+  lv_free_core(p);
+  return n;
+}
+
+void lv_mem_monitor_core(lv_mem_monitor_t *mon) {
+  lv_mem_pool_stats_t st;
+  lv_mem_pool_get_stats(&st);
+  uint32_t free_size = st.total - st.used;
+  mon->total_size = st.total;
+  mon->free_size = free_size;
+  mon->free_biggest_size = st.largest_free;
+  mon->free_cnt = st.pages_free;
+  mon->used_cnt = st.live;
+  mon->max_used = st.max_used;
+  mon->used_pct = st.used * 100 / st.total;
+  mon->frag_pct = st.frag_pct;
+}
+
+lv_result_t lv_mem_test_core(void) {
+  for (uint32_t p = 0; p < POOL_PAGES; p++) {
+    const page_t *pg = &s_pages[p];
+    if (pg->kind == PAGE_RUN) {
+      if (pg->run == 0 || p + pg->run > POOL_PAGES) {
+        return LV_RESULT_INVALID;
+      }
+      for (uint32_t t = p + 1; t < p + pg->run; t++) {
+        if (s_pages[t].kind != PAGE_RUN_TAIL) {
+          return LV_RESULT_INVALID;
+        }
+      }
+    } else if (pg->kind == PAGE_SLAB) {
+      uint32_t slots = LV_MEM_POOL_PAGE_SIZE / s_class_size[pg->cls];
+      uint32_t free_slots = 0;
+      for (uint32_t s = pg->free_slot; s != NO_SLOT; s = *slot_link(p, s)) {
+        if (s >= slots || ++free_slots > slots) {
+          return LV_RESULT_INVALID;
+        }
+      }
+      if (free_slots + pg->used != slots) {
+        return LV_RESULT_INVALID;
+      }
+    }
+  }
+  return LV_RESULT_OK;
+}
+
+lv_mem_arena_t lv_mem_arena_open(void) {
+  for (int a = 1; a < LV_MEM_POOL_ARENAS; a++) {
+    if (!s_arenas[a].open) {
+      s_arenas[a].open = true;
+      return a;
+    }
+  }
+  return LV_MEM_ARENA_SHARED;
+}
+
+lv_mem_arena_t lv_mem_arena_enter(lv_mem_arena_t arena) {
+  lv_mem_arena_t prev = s_current;
+  s_current = arena;
+  return prev;
+}
+
+void lv_mem_arena_release(lv_mem_arena_t arena) {
+  if (arena == LV_MEM_ARENA_SHARED || !s_arenas[arena].open) {
+    return;
+  }
+  arena_t *shared = &s_arenas[LV_MEM_ARENA_SHARED];
+  for (uint32_t p = 0; p < POOL_PAGES; p++) {
+    page_t *pg = &s_pages[p];
+    if (pg->kind == PAGE_FREE || pg->arena != arena) {
+      continue;
+    }
+    if (pg->kind == PAGE_SLAB && pg->used == 0) {
+      pages_free(p, 1);
+      s_stats.arena_pages_freed++;
+      continue;
+    }
+    // Still in use: the rest of its life is in the shared arena
+    if (pg->kind == PAGE_SLAB) {
+      s_stats.arena_survivors += pg->used;
+      if (pg->free_slot != NO_SLOT) {
+        pg->next = shared->partial[pg->cls];
+        shared->partial[pg->cls] = p;
+      }
+    } else if (pg->kind == PAGE_RUN) {
+      s_stats.arena_survivors++;
+    }
+    s_stats.arena_pages[arena]--;
+    s_stats.arena_pages[LV_MEM_ARENA_SHARED]++;
+    pg->arena = LV_MEM_ARENA_SHARED;
+  }
+  s_arenas[arena] = (arena_t){.open = false};
+  for (int c = 0; c < LV_MEM_POOL_CLASSES; c++) {
+    s_arenas[arena].partial[c] = NO_PAGE;
+  }
+  if (s_current == arena) {
+    s_current = LV_MEM_ARENA_SHARED;
+  }
+  s_stats.arena_releases++;
+}
+
+void lv_mem_pool_get_stats(lv_mem_pool_stats_t *out) {
+  lv_mem_pool_stats_t *st = &s_stats;
+  st->pages_free = st->pages_slab = st->pages_run = 0;
+  for (int c = 0; c < LV_MEM_POOL_CLASSES; c++) {
+    st->classes[c] = (lv_mem_pool_class_stats_t){.size = s_class_size[c]};
+  }
+  uint32_t len = 0, longest = 0;
+  for (uint32_t p = 0; p < POOL_PAGES; p++) {
+    const page_t *pg = &s_pages[p];
+    len = pg->kind == PAGE_FREE ? len + 1 : 0;
+    longest = len > longest ? len : longest;
+    if (pg->kind == PAGE_FREE) {
+      st->pages_free++;
+    } else if (pg->kind == PAGE_SLAB) {
+      lv_mem_pool_class_stats_t *c = &st->classes[pg->cls];
+      st->pages_slab++;
+      c->pages++;
+      c->slots_used += pg->used;
+      c->slots_total += LV_MEM_POOL_PAGE_SIZE / c->size;
+    } else {
+      st->pages_run++;
+    }
+  }
+  st->largest_free = longest * LV_MEM_POOL_PAGE_SIZE;
+  uint32_t free_size = st->total - st->used;
+  st->frag_pct = free_size ? 100 - st->largest_free * 100 / free_size : 0;
+  *out = *st;
+}
+
+#if LV_USE_SYSMON
+
+static lv_obj_t *s_monitor;
+
+static void monitor_update(lv_timer_t *t) {
+  (void)t;
+  lv_mem_pool_stats_t st;
+  lv_mem_pool_get_stats(&st);
+  lv_label_set_text_fmt(s_monitor,
+                        "%" LV_PRIu32 " kB used (%" LV_PRIu32 " %%)\n"
+                        "%d %% frag, %" LV_PRIu32 " kB max",
+                        st.used / 1024, st.used * 100 / st.total,
+                        st.frag_pct, st.largest_free / 1024);
+}
+
+void lv_mem_pool_monitor_show(bool show) {
+  static lv_timer_t *timer;
+  if (show && !s_monitor) {
+    // Same label and style as the perf monitor, in the other corner
+    s_monitor = lv_sysmon_create(lv_display_get_default());
+    lv_obj_align(s_monitor, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    timer = lv_timer_create(monitor_update, LV_MEM_POOL_MONITOR_MS, NULL);
+    monitor_update(timer);
+  } else if (!show && s_monitor) {
+    lv_timer_delete(timer);
+    lv_obj_delete(s_monitor);
+    s_monitor = NULL;
+  }
+}
+
+#endif
@@ -9,12 +9,13 @@
 
 #include "display/lv_display.h"
 #include "lvgl.h"
+#include "ui.h"
 
 static lv_obj_t *btn;
 static lv_display_rotation_t rotation = LV_DISP_ROTATION_0;
 
 static void btn_cb(lv_event_t *e) {
-  lv_display_t *disp = lv_event_get_user_data(e);
+  lv_display_t *disp = lv_obj_get_display(lv_event_get_target(e));
   rotation++;
   if (rotation > LV_DISP_ROTATION_270) {
     rotation = LV_DISP_ROTATION_0;
@@ -23,15 +24,36 @@ static void btn_cb(lv_event_t *e) {
 }
 static void set_angle(void *obj, int32_t v) { lv_arc_set_value(obj, v); }
 
-void example_lvgl_demo_ui(lv_display_t *disp) {
-  lv_obj_t *scr = lv_display_get_screen_active(disp);
+static void arc_anim_start(lv_obj_t *arc) {
+  lv_anim_t a;
+  lv_anim_init(&a);
+  lv_anim_set_var(&a, arc);
+  lv_anim_set_exec_cb(&a, set_angle);
+  lv_anim_set_duration(&a, 1000);
+  lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE); /*Just for the demo*/
+  lv_anim_set_repeat_delay(&a, 500);
+  lv_anim_set_values(&a, 0, 100);
+  lv_anim_start(&a);
+}
+
+/*Run the arc only while its screen is shown, so the refresh governor can
+ *idle on the other screens*/
+static void screen_cb(lv_event_t *e) {
+  lv_obj_t *arc = lv_event_get_user_data(e);
+  if (lv_event_get_code(e) == LV_EVENT_SCREEN_LOADED) {
+    arc_anim_start(arc);
+  } else {
+    lv_anim_delete(arc, set_angle);
+  }
+}
 
+void example_lvgl_demo_ui_create(lv_obj_t *scr) {
   btn = lv_button_create(scr);
   lv_obj_t *lbl = lv_label_create(btn);
   lv_label_set_text_static(lbl, LV_SYMBOL_REFRESH " ROTATE");
   lv_obj_align(btn, LV_ALIGN_BOTTOM_LEFT, 30, -30);
   /*Button event*/
-  lv_obj_add_event_cb(btn, btn_cb, LV_EVENT_CLICKED, disp);
+  lv_obj_add_event_cb(btn, btn_cb, LV_EVENT_CLICKED, NULL);
 
   /*Create an Arc*/
   lv_obj_t *arc = lv_arc_create(scr);
@@ -43,13 +65,13 @@ void example_lvgl_demo_ui(lv_display_t *disp) {
                      LV_OBJ_FLAG_CLICKABLE); /*To not allow adjusting by click*/
   lv_obj_center(arc);
 
-  lv_anim_t a;
-  lv_anim_init(&a);
-  lv_anim_set_var(&a, arc);
-  lv_anim_set_exec_cb(&a, set_angle);
-  lv_anim_set_duration(&a, 1000);
-  lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE); /*Just for the demo*/
-  lv_anim_set_repeat_delay(&a, 500);
-  lv_anim_set_values(&a, 0, 100);
-  lv_anim_start(&a);
+  lv_obj_add_event_cb(scr, screen_cb, LV_EVENT_SCREEN_LOADED, arc);
+  lv_obj_add_event_cb(scr, screen_cb, LV_EVENT_SCREEN_UNLOADED, arc);
+  if (scr == lv_display_get_screen_active(lv_obj_get_display(scr))) {
+    arc_anim_start(arc);
+  }
+}
+
+void example_lvgl_demo_ui(lv_display_t *disp) {
+  example_lvgl_demo_ui_create(lv_display_get_screen_active(disp));
 }
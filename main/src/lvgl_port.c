@@ -0,0 +1,145 @@
+#include "lvgl_port.h"
+#include "boot.h"
+#include "config.h"
+#include "display/lv_display_private.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lvgl_display.h"
+#include "power_governor.h"
+#include "trace.h"
+#include "ui_cmd.h"
+#include <assert.h>
+#include <sys/param.h>
+
+static const char *TAG = "LVGL_PORT";
+
+static TaskHandle_t s_lvgl_task;
+static SemaphoreHandle_t s_flush_done;
+// Event-mode input devices, read before every lv_timer_handler pass
+static lv_indev_t *s_indevs[LVGL_PORT_MAX_INDEVS];
+static uint32_t s_indev_count;
+static lv_display_t *s_display;
+static power_governor_t s_governor;
+
+/* Match the refresh timer and backlight to what the UI is doing */
+static void example_lvgl_govern(void) {
+  uint32_t now_ms = lv_tick_get();
+  if (power_governor_update(&s_governor, now_ms,
+                            lv_display_get_inactive_time(s_display),
+                            lv_anim_count_running() > 0)) {
+    // The refresh timer keeps its last run, so going faster takes effect
+    // on this pass already
+    lv_timer_set_period(lv_display_get_refr_timer(s_display),
+                        power_governor_period_ms(&s_governor));
+    display_set_backlight(power_governor_backlight(&s_governor));
+    ESP_LOGD(TAG, "%s: %u ms refresh",
+             power_governor_state_names[s_governor.state],
+             (unsigned)power_governor_period_ms(&s_governor));
+  }
+}
+
+/* Render the screen the bring-up built and light the backlight once its last
+ * strip is on the panel */
+static void example_lvgl_first_frame(void) {
+  lv_refr_now(s_display);
+  while (display_transfers_inflight()) {
+    xSemaphoreTake(s_flush_done, pdMS_TO_TICKS(LVGL_TASK_FLUSH_TIMEOUT_MS));
+  }
+  display_set_backlight(power_governor_backlight(&s_governor));
+  boot_mark(BOOT_MARK_FIRST_PIXEL);
+}
+
+static void example_lvgl_port_task(void *arg) {
+  ESP_LOGI(TAG, "Starting LVGL task");
+  example_lvgl_first_frame();
+  uint32_t time_till_next_ms = 0;
+  while (1) {
+    // LVGL is not thread-safe: only this task touches it, everyone else
+    // posts UI commands
+    ui_cmd_dispatch();
+    for (uint32_t i = 0; i < s_indev_count; i++) {
+      lv_indev_read(s_indevs[i]);
+    }
+    example_lvgl_govern();
+    time_till_next_ms = lv_timer_handler();
+    trace_collect();
+
+    if (s_governor.state == POWER_GOVERNOR_INTERACTIVE) {
+      // Event-mode indevs are only read on a wakeup, and scroll throw after
+      // release advances on reads: keep frame pace until the hold expires
+      time_till_next_ms =
+          MIN(time_till_next_ms, power_governor_period_ms(&s_governor));
+    }
+    TickType_t wait = portMAX_DELAY;
+    if (time_till_next_ms != LV_NO_TIMER_READY) {
+      // in case of triggering a task watch dog time out
+      time_till_next_ms = MAX(time_till_next_ms, LVGL_TASK_MIN_DELAY_MS);
+      wait = pdMS_TO_TICKS(time_till_next_ms);
+    }
+    // Nothing pending in LVGL: sleep until its next timer is due or someone
+    // has new input or content for it
+    ulTaskNotifyTake(pdTRUE, wait);
+  }
+}
+
+/* Block the LVGL task while the panel DMA drains instead of spinning on the
+ * flushing flag */
+static void example_lvgl_flush_wait_cb(lv_display_t *disp) {
+  while (disp->flushing) {
+    xSemaphoreTake(s_flush_done, pdMS_TO_TICKS(LVGL_TASK_FLUSH_TIMEOUT_MS));
+  }
+}
+
+void lvgl_port_start(lv_display_t *display) {
+  s_flush_done = xSemaphoreCreateBinary();
+  assert(s_flush_done);
+  lv_display_set_flush_wait_cb(display, example_lvgl_flush_wait_cb);
+
+  s_display = display;
+  const power_governor_config_t governor_config = {
+      .interactive_period_ms = GOVERNOR_INTERACTIVE_PERIOD_MS,
+      .animating_period_ms = GOVERNOR_ANIMATING_PERIOD_MS,
+      .idle_period_ms = GOVERNOR_IDLE_PERIOD_MS,
+      .interactive_hold_ms = GOVERNOR_INTERACTIVE_HOLD_MS,
+      .dim_after_ms = GOVERNOR_DIM_AFTER_MS,
+      .backlight_full = GOVERNOR_BACKLIGHT_FULL,
+      .backlight_dim = GOVERNOR_BACKLIGHT_DIM,
+  };
+  power_governor_init(&s_governor, &governor_config, lv_tick_get());
+  lv_timer_set_period(lv_display_get_refr_timer(display),
+                      power_governor_period_ms(&s_governor));
+
+  xTaskCreate(example_lvgl_port_task, "LVGL", LVGL_TASK_STACK_SIZE, NULL,
+              LVGL_TASK_PRIORITY, &s_lvgl_task);
+}
+
+void lvgl_port_add_indev(lv_indev_t *indev) {
+  assert(s_indev_count < LVGL_PORT_MAX_INDEVS);
+  // No read timer: the driver wakes the LVGL task when it has new data
+  lv_indev_set_mode(indev, LV_INDEV_MODE_EVENT);
+  s_indevs[s_indev_count++] = indev;
+}
+
+void lvgl_port_wake(void) {
+  if (s_lvgl_task) {
+    xTaskNotifyGive(s_lvgl_task);
+  }
+}
+
+bool lvgl_port_wake_from_isr(void) {
+  BaseType_t high_task_wakeup = pdFALSE;
+  if (s_lvgl_task) {
+    vTaskNotifyGiveFromISR(s_lvgl_task, &high_task_wakeup);
+  }
+  return high_task_wakeup == pdTRUE;
+}
+
+bool lvgl_port_flush_done_from_isr(void) {
+  BaseType_t high_task_wakeup = pdFALSE;
+  if (s_flush_done) {
+    xSemaphoreGiveFromISR(s_flush_done, &high_task_wakeup);
+  }
+  return high_task_wakeup == pdTRUE;
+}
@@ -1,15 +1,20 @@
 #include "mod_wifi.h"
+#include "config.h"
+#include "dlog.h"
 #include "esp_event.h"
 #include "esp_event_base.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_netif_net_stack.h"
 #include "esp_netif_sntp.h"
+#include "esp_random.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/event_groups.h"
-#include "freertos/projdefs.h"
-#include "portmacro.h"
+#include "lwip/dhcp.h"
+#include "wifi_cache.h"
 #include <string.h>
+#include <time.h>
 
 static const char *TAG = "MOD_WIFI";
 
@@ -21,48 +26,272 @@ static const char *WIFI_SSID = "";
 static const char *WIFI_PASSWORD = "";
 #endif
 
-#define ESP_MAXIMUM_RETRY 15
+ESP_EVENT_DEFINE_BASE(MOD_WIFI_EVENT);
 
-/* FreeRTOS event group to signal when we are connected*/
-static EventGroupHandle_t s_wifi_event_group;
+/* Everything below runs from callbacks: Wi-Fi/IP events on the default event
+ * loop, the retry timer on the esp_timer task and the SNTP sync on the
+ * TCP/IP task. Nothing here blocks the caller of wifi_connection_start. */
+static mod_wifi_status_t s_status;
+static portMUX_TYPE s_status_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t s_retry_timer;
+static bool s_sntp_started;
+static esp_netif_t *s_sta_netif;
+// Trying the cached AP and IP, scan and DHCP take over on the first failure
+static bool s_fast_path;
+// Connected on the cached IP, DHCP was started to confirm the lease
+static bool s_dhcp_confirming;
+// What the current association will be cached as once it has an IP
+static wifi_cache_t s_pending_cache;
+static int64_t s_connect_start_us;
+// Lease of the last DHCP bind, and when it was bound
+static uint32_t s_lease_s;
+static int64_t s_lease_start_us;
 
-/* The event group allows multiple bits for each event, but we only care about
- * two events:
- * - we are connected to the AP with an IP
- * - we failed to connect after the maximum amount of retries */
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT BIT1
+/* Exponential backoff with equal jitter: half the doubled delay is fixed so
+ * retries never come back to back, the other half is random so watches that
+ * lost the same AP do not retry in lockstep. */
+static uint32_t wifi_backoff_ms(uint32_t attempt) {
+  uint32_t delay = WIFI_BACKOFF_MAX_MS;
+  if (attempt < 16 && (WIFI_BACKOFF_BASE_MS << attempt) < WIFI_BACKOFF_MAX_MS) {
+    delay = WIFI_BACKOFF_BASE_MS << attempt;
+  }
+  return delay / 2 + esp_random() % (delay / 2 + 1);
+}
+
+// Publish the current status to whoever listens for MOD_WIFI_EVENT
+static void wifi_publish(void) {
+  mod_wifi_status_t status;
+  mod_wifi_get_status(&status);
+  esp_event_post(MOD_WIFI_EVENT, MOD_WIFI_EVENT_STATUS, &status,
+                 sizeof(status), 0);
+}
+
+static void wifi_set_state(mod_wifi_state_t state, uint32_t retry_in_ms) {
+  portENTER_CRITICAL(&s_status_lock);
+  s_status.state = state;
+  s_status.retry_in_ms = retry_in_ms;
+  portEXIT_CRITICAL(&s_status_lock);
+  wifi_publish();
+}
+
+static void wifi_retry_timer_cb(void *arg) {
+  DLOGI(TAG, "Retry to connect to the AP");
+  s_connect_start_us = esp_timer_get_time();
+  wifi_set_state(MOD_WIFI_CONNECTING, 0);
+  esp_wifi_connect();
+}
 
-static int s_retry_num = 0;
+// Before this the clock has not been set, by SNTP or from before a restart
+static bool wifi_clock_set(time_t now) { return now >= WIFI_CLOCK_SET_AFTER; }
+
+/* The cached lease still has a while to run. With the clock not set there is
+ * no telling, the DHCP started after link-up confirms it either way. */
+static bool wifi_cache_usable(const wifi_cache_t *cache) {
+  time_t now = time(NULL);
+  if (!wifi_clock_set(now)) {
+    return true;
+  }
+  return (int64_t)now + WIFI_LEASE_MARGIN_S < (int64_t)cache->lease_end;
+}
+
+/* Directed connect to the cached BSSID on its channel with the cached IP set
+ * statically, so neither a scan nor a DHCP exchange delays the first IP. DHCP
+ * starts once the link is up, so the lease is confirmed or renewed, or
+ * another address taken if the cached one is gone. A failure before that
+ * sends us back to the normal path. */
+static void wifi_apply_cache(wifi_config_t *cfg, const wifi_cache_t *cache) {
+  cfg->sta.channel = cache->channel;
+  memcpy(cfg->sta.bssid, cache->bssid, sizeof(cfg->sta.bssid));
+  cfg->sta.bssid_set = true;
+
+  ESP_ERROR_CHECK(esp_netif_dhcpc_stop(s_sta_netif));
+  esp_netif_ip_info_t ip_info = {
+      .ip.addr = cache->ip,
+      .netmask.addr = cache->netmask,
+      .gw.addr = cache->gw,
+  };
+  ESP_ERROR_CHECK(esp_netif_set_ip_info(s_sta_netif, &ip_info));
+  esp_netif_dns_info_t dns = {
+      .ip.type = ESP_IPADDR_TYPE_V4,
+      .ip.u_addr.ip4.addr = cache->dns,
+  };
+  ESP_ERROR_CHECK(
+      esp_netif_set_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns));
+  s_fast_path = true;
+}
+
+// The cached AP or IP did not work: forget it and do a full scan and DHCP
+static void wifi_drop_cache(void) {
+  wifi_config_t cfg;
+  ESP_ERROR_CHECK(esp_wifi_get_config(WIFI_IF_STA, &cfg));
+  cfg.sta.channel = 0;
+  cfg.sta.bssid_set = false;
+  ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &cfg));
+  ESP_ERROR_CHECK(esp_netif_dhcpc_start(s_sta_netif));
+  wifi_cache_erase();
+  s_fast_path = false;
+  s_lease_s = 0;
+}
+
+// Scan again on later reconnects, the cached BSSID may be what went away
+static void wifi_unlock_ap(void) {
+  wifi_config_t cfg;
+  ESP_ERROR_CHECK(esp_wifi_get_config(WIFI_IF_STA, &cfg));
+  if (cfg.sta.bssid_set) {
+    cfg.sta.channel = 0;
+    cfg.sta.bssid_set = false;
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &cfg));
+  }
+}
+
+// Lease time offered by the server lwIP is bound with, 0 when there is none
+static uint32_t wifi_lease_s(void) {
+  struct netif *netif = esp_netif_get_netif_impl(s_sta_netif);
+  struct dhcp *dhcp = netif ? netif_dhcp_data(netif) : NULL;
+  return dhcp ? dhcp->offered_t0_lease : 0;
+}
+
+// UTC end of the last lease, 0 while the clock is not set
+static uint32_t wifi_lease_end(void) {
+  time_t now = time(NULL);
+  if (!s_lease_s || !wifi_clock_set(now)) {
+    return 0;
+  }
+  int64_t bound_at = now - (esp_timer_get_time() - s_lease_start_us) / 1000000;
+  int64_t end = bound_at + s_lease_s;
+  return end > UINT32_MAX ? UINT32_MAX : (uint32_t)end;
+}
+
+// Remember the association that just got an IP through DHCP
+static void wifi_store_cache(const esp_netif_ip_info_t *ip_info) {
+  esp_netif_dns_info_t dns;
+  if (esp_netif_get_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns) !=
+      ESP_OK) {
+    return;
+  }
+  s_pending_cache.ip = ip_info->ip.addr;
+  s_pending_cache.netmask = ip_info->netmask.addr;
+  s_pending_cache.gw = ip_info->gw.addr;
+  s_pending_cache.dns = dns.ip.u_addr.ip4.addr;
+  s_lease_s = wifi_lease_s();
+  s_lease_start_us = esp_timer_get_time();
+  s_pending_cache.lease_end = wifi_lease_end();
+  wifi_cache_save(WIFI_SSID, &s_pending_cache);
+}
+
+/* Default event loop, like event_handler. A cache stored before the first
+ * SNTP sync has no lease end yet, fill it in now the clock is set. */
+static void wifi_self_status_handler(void *arg, esp_event_base_t event_base,
+                                     int32_t event_id, void *event_data) {
+  const mod_wifi_status_t *status = event_data;
+  if (status->time_synced && s_lease_s && !s_pending_cache.lease_end) {
+    s_pending_cache.lease_end = wifi_lease_end();
+    wifi_cache_save(WIFI_SSID, &s_pending_cache);
+  }
+}
+
+static void time_sync_notification_cb(struct timeval *tv) {
+  DLOGI(TAG, "Time synchronized, %lld s since the epoch",
+        (long long)tv->tv_sec);
+
+  portENTER_CRITICAL(&s_status_lock);
+  s_status.time_synced = true;
+  portEXIT_CRITICAL(&s_status_lock);
+  wifi_publish();
+}
+
+// SNTP needs a route out, so it only starts once the first IP is in
+static void wifi_start_sntp(void) {
+  if (s_sntp_started) {
+    return; // later IPs restart the sync through ip_event_to_renew
+  }
+  esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(WIFI_SNTP_SERVER);
+  config.ip_event_to_renew = IP_EVENT_STA_GOT_IP;
+  config.sync_cb = time_sync_notification_cb;
+  ESP_ERROR_CHECK(esp_netif_sntp_init(&config));
+  s_sntp_started = true;
+}
 
 static void event_handler(void *arg, esp_event_base_t event_base,
                           int32_t event_id, void *event_data) {
   if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+    wifi_set_state(MOD_WIFI_CONNECTING, 0);
     esp_wifi_connect();
+  } else if (event_base == WIFI_EVENT &&
+             event_id == WIFI_EVENT_STA_CONNECTED) {
+    wifi_event_sta_connected_t *event = event_data;
+    memcpy(s_pending_cache.bssid, event->bssid, sizeof(event->bssid));
+    s_pending_cache.channel = event->channel;
   } else if (event_base == WIFI_EVENT &&
              event_id == WIFI_EVENT_STA_DISCONNECTED) {
-    if (s_retry_num < ESP_MAXIMUM_RETRY) {
+    wifi_event_sta_disconnected_t *event = event_data;
+    if (s_fast_path) {
+      // No backoff: the AP is likely fine, only the cache was stale
+      DLOGI(TAG, "Cached AP failed (reason %d), scanning instead",
+            event->reason);
+      wifi_drop_cache();
+      wifi_set_state(MOD_WIFI_CONNECTING, 0);
       esp_wifi_connect();
-      s_retry_num++;
-      ESP_LOGI(TAG, "Retry to connect to the AP");
-    } else {
-      xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+      return;
     }
-    ESP_LOGI(TAG, "Connect to the AP fail");
+    s_dhcp_confirming = false;
+    wifi_unlock_ap();
+    portENTER_CRITICAL(&s_status_lock);
+    uint32_t attempt = s_status.attempt++;
+    s_status.last_reason = event->reason;
+    portEXIT_CRITICAL(&s_status_lock);
+
+    // Leave the radio idle until the backoff runs out instead of reconnecting
+    // straight away
+    uint32_t delay_ms = wifi_backoff_ms(attempt);
+    DLOGI(TAG, "Connect to the AP fail (reason %d), retry in %u ms",
+          event->reason, (unsigned)delay_ms);
+    esp_timer_stop(s_retry_timer);
+    ESP_ERROR_CHECK(
+        esp_timer_start_once(s_retry_timer, (uint64_t)delay_ms * 1000));
+    wifi_set_state(MOD_WIFI_BACKOFF, delay_ms);
   } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
     ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-    ESP_LOGI(TAG, "Got IP:" IPSTR, IP2STR(&event->ip_info.ip));
-    s_retry_num = 0;
-    xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+    if (s_dhcp_confirming) {
+      // DHCP bound after the fast connect, with the cached IP or a new one
+      DLOGI(TAG, "DHCP bound " IPSTR " after the cached connect",
+            IP2STR(&event->ip_info.ip));
+      s_dhcp_confirming = false;
+      wifi_store_cache(&event->ip_info);
+      return;
+    }
+    uint32_t time_to_ip_ms =
+        (uint32_t)((esp_timer_get_time() - s_connect_start_us) / 1000);
+    DLOGI(TAG, "Got IP:" IPSTR " in %u ms (%s)", IP2STR(&event->ip_info.ip),
+          (unsigned)time_to_ip_ms, s_fast_path ? "cached" : "scan+DHCP");
+    portENTER_CRITICAL(&s_status_lock);
+    s_status.attempt = 0;
+    s_status.fast_connect = s_fast_path;
+    s_status.time_to_ip_ms = time_to_ip_ms;
+    portEXIT_CRITICAL(&s_status_lock);
+    if (s_fast_path) {
+      // Connected, later drops are the AP's and go through the backoff
+      s_fast_path = false;
+      s_dhcp_confirming = true;
+      ESP_ERROR_CHECK(esp_netif_dhcpc_start(s_sta_netif));
+    } else {
+      wifi_store_cache(&event->ip_info);
+    }
+    wifi_set_state(MOD_WIFI_CONNECTED, 0);
+    wifi_start_sntp();
   }
 }
 
 void mod_wifi_init(void) {
-  s_wifi_event_group = xEventGroupCreate();
+  const esp_timer_create_args_t retry_timer_args = {
+      .callback = wifi_retry_timer_cb,
+      .name = "wifi_retry",
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&retry_timer_args, &s_retry_timer));
 
   ESP_ERROR_CHECK(esp_netif_init());
   ESP_ERROR_CHECK(esp_event_loop_create_default());
-  esp_netif_create_default_wifi_sta();
+  s_sta_netif = esp_netif_create_default_wifi_sta();
 
   wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
   ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -73,6 +302,9 @@ void mod_wifi_init(void) {
       WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL, &instance_any_id));
   ESP_ERROR_CHECK(esp_event_handler_instance_register(
       IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL, &instance_got_ip));
+  ESP_ERROR_CHECK(esp_event_handler_instance_register(
+      MOD_WIFI_EVENT, MOD_WIFI_EVENT_STATUS, wifi_self_status_handler, NULL,
+      NULL));
 
   // Configure Wi-Fi settings
   wifi_config_t wifi_config = {
@@ -90,63 +322,30 @@ void mod_wifi_init(void) {
   wifi_config.sta.ssid[sizeof(wifi_config.sta.ssid) - 1] = '\0';
   wifi_config.sta.password[sizeof(wifi_config.sta.password) - 1] = '\0';
 
+  wifi_cache_t cache;
+  if (wifi_cache_load(WIFI_SSID, &cache)) {
+    if (wifi_cache_usable(&cache)) {
+      ESP_LOGI(TAG, "Using cached AP on channel %u", cache.channel);
+      wifi_apply_cache(&wifi_config, &cache);
+    } else {
+      ESP_LOGI(TAG, "Cached lease has run out, scanning");
+    }
+  }
+
   ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
   ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
 
   ESP_LOGI(TAG, "Wi-Fi initialized (not started yet)");
 }
 
-void time_sync_notification_cb(struct timeval *tv) {
-  ESP_LOGI(TAG, "Notification of a time synchronization event");
+void wifi_connection_start(void) {
+  // STA_START triggers the first connect, everything after is event driven
+  s_connect_start_us = esp_timer_get_time();
+  ESP_ERROR_CHECK(esp_wifi_start());
 }
 
-void wifi_connection_start() {
-
-  esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG("pool.ntp.org");
-  config.ip_event_to_renew = IP_EVENT_STA_GOT_IP;
-  config.sync_cb = time_sync_notification_cb;
-  esp_netif_sntp_init(&config);
-
-  if (esp_netif_sntp_sync_wait(pdMS_TO_TICKS(10000)) != ESP_OK) {
-    ESP_LOGI(TAG, "Failed to update system time within 10s timeout");
-  }
-
-  s_retry_num = 0;                   // Reset retry counter
-  ESP_ERROR_CHECK(esp_wifi_start()); // Start Wi-Fi here
-
-  // Wait for connection/failure
-  EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-                                         WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-                                         pdFALSE, pdFALSE, portMAX_DELAY);
-
-  if (bits & WIFI_CONNECTED_BIT) {
-    ESP_LOGI(TAG, "Connected to AP");
-
-    time_t now = 0;
-    struct tm timeinfo = {0};
-    int retry = 0;
-    const int retry_count = 15;
-    while (esp_netif_sntp_sync_wait(10000 / portTICK_PERIOD_MS) ==
-               ESP_ERR_TIMEOUT &&
-           ++retry < retry_count) {
-      ESP_LOGI(TAG, "Waiting for system time to be set... (%d/%d)", retry,
-               retry_count);
-    }
-
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    char strftime_buf[64];
-
-    // Set timezone to Eastern Standard Time and print local time
-    setenv("TZ", "EST5EDT,M3.2.0/2,M11.1.0", 1);
-    tzset();
-    localtime_r(&now, &timeinfo);
-    strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
-    ESP_LOGI(TAG, "The current date/time in New York is: %s", strftime_buf);
-
-  } else if (bits & WIFI_FAIL_BIT) {
-    ESP_LOGI(TAG, "Failed to connect to AP");
-  } else {
-    ESP_LOGE(TAG, "Unexpected event");
-  }
+void mod_wifi_get_status(mod_wifi_status_t *out) {
+  portENTER_CRITICAL(&s_status_lock);
+  *out = s_status;
+  portEXIT_CRITICAL(&s_status_lock);
 }
@@ -0,0 +1,130 @@
+#include "notif_list.h"
+#include <string.h>
+
+#define ROW_GAP 4
+#define ROW_PAD 6
+
+static void notif_list_bind(notif_list_t *l, notif_list_row_t *row,
+                            int32_t index) {
+  notif_t n;
+  if (index < 0) {
+    lv_obj_add_flag(row->obj, LV_OBJ_FLAG_HIDDEN);
+    row->index = -1;
+    return;
+  }
+  if (!l->ring || !notif_ring_get(l->ring, index, &n)) {
+    l->stats.bind_fails++;
+    n.title[0] = '\0';
+    n.text[0] = '\0';
+  }
+  lv_label_set_text(row->title, n.title);
+  lv_label_set_text(row->text, n.text);
+  lv_obj_set_y(row->obj, index * NOTIF_LIST_ROW_H);
+  lv_obj_remove_flag(row->obj, LV_OBJ_FLAG_HIDDEN);
+  row->index = index;
+  l->stats.binds++;
+}
+
+// Give every row of the window around the scroll position its notification
+static void notif_list_update(notif_list_t *l) {
+  int32_t first = lv_obj_get_scroll_y(l->obj) / NOTIF_LIST_ROW_H -
+                  NOTIF_LIST_MARGIN_ROWS;
+  if (first < 0) {
+    first = 0;
+  }
+  for (int32_t i = first; i < first + (int32_t)l->row_count; i++) {
+    notif_list_row_t *row = &l->rows[i % l->row_count];
+    int32_t index = (uint32_t)i < l->count ? i : -1;
+    if (row->index != index) {
+      notif_list_bind(l, row, index);
+    }
+  }
+}
+
+static void notif_list_scroll_cb(lv_event_t *e) {
+  notif_list_update(lv_event_get_user_data(e));
+}
+
+static void notif_list_row_create(notif_list_row_t *row, lv_obj_t *parent) {
+  row->obj = lv_obj_create(parent);
+  lv_obj_set_size(row->obj, lv_pct(100), NOTIF_LIST_ROW_H - ROW_GAP);
+  lv_obj_set_style_pad_all(row->obj, ROW_PAD, LV_PART_MAIN);
+  lv_obj_remove_flag(row->obj, LV_OBJ_FLAG_SCROLLABLE);
+  // Presses and drags go to the list
+  lv_obj_add_flag(row->obj, LV_OBJ_FLAG_EVENT_BUBBLE);
+
+  row->title = lv_label_create(row->obj);
+  lv_obj_set_width(row->title, lv_pct(100));
+  lv_label_set_long_mode(row->title, LV_LABEL_LONG_DOT);
+
+  row->text = lv_label_create(row->obj);
+  lv_obj_set_width(row->text, lv_pct(100));
+  lv_label_set_long_mode(row->text, LV_LABEL_LONG_DOT);
+  lv_obj_align(row->text, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+
+  lv_obj_add_flag(row->obj, LV_OBJ_FLAG_HIDDEN);
+  row->index = -1;
+}
+
+void notif_list_init(notif_list_t *l, lv_obj_t *parent, notif_ring_t *ring) {
+  memset(l, 0, sizeof(*l));
+  l->ring = ring;
+  l->appended_seen = ring ? ring->stats.appended : 0;
+
+  l->obj = lv_obj_create(parent);
+  lv_obj_set_size(l->obj, lv_pct(100), lv_pct(100));
+  lv_obj_set_scroll_dir(l->obj, LV_DIR_VER);
+  lv_obj_set_style_pad_all(l->obj, 0, LV_PART_MAIN);
+  lv_obj_set_style_border_width(l->obj, 0, LV_PART_MAIN);
+
+  l->spacer = lv_obj_create(l->obj);
+  lv_obj_remove_style_all(l->spacer);
+  lv_obj_remove_flag(l->spacer, LV_OBJ_FLAG_CLICKABLE);
+
+  l->empty = lv_label_create(l->obj);
+  lv_label_set_text_static(l->empty, "No notifications");
+  lv_obj_center(l->empty);
+
+  // Enough rows to cover the list at any scroll offset, plus the margins
+  lv_obj_update_layout(l->obj);
+  uint32_t visible =
+      (lv_obj_get_content_height(l->obj) + NOTIF_LIST_ROW_H - 1) /
+          NOTIF_LIST_ROW_H +
+      1;
+  l->row_count = visible + 2 * NOTIF_LIST_MARGIN_ROWS;
+  if (l->row_count > NOTIF_LIST_MAX_ROWS) {
+    l->row_count = NOTIF_LIST_MAX_ROWS;
+  }
+  for (uint32_t i = 0; i < l->row_count; i++) {
+    notif_list_row_create(&l->rows[i], l->obj);
+  }
+
+  lv_obj_add_event_cb(l->obj, notif_list_scroll_cb, LV_EVENT_SCROLL, l);
+  notif_list_refresh(l);
+}
+
+void notif_list_refresh(notif_list_t *l) {
+  uint32_t count = l->ring ? notif_ring_count(l->ring) : 0;
+  // Appends come in at the top, dropped notifications leave at the bottom
+  uint32_t appended = l->ring ? l->ring->stats.appended : 0;
+  int32_t added = (int32_t)(appended - l->appended_seen);
+  l->appended_seen = appended;
+  l->count = count;
+
+  lv_obj_set_size(l->spacer, 1, count * NOTIF_LIST_ROW_H);
+  if (count) {
+    lv_obj_add_flag(l->empty, LV_OBJ_FLAG_HIDDEN);
+  } else {
+    lv_obj_remove_flag(l->empty, LV_OBJ_FLAG_HIDDEN);
+  }
+  // Every index moved
+  for (uint32_t i = 0; i < l->row_count; i++) {
+    notif_list_bind(l, &l->rows[i], -1);
+  }
+  lv_obj_update_layout(l->obj);
+  // Keep the rows already scrolled to in view
+  if (added > 0 && lv_obj_get_scroll_y(l->obj) > 0) {
+    lv_obj_scroll_by(l->obj, 0, -added * NOTIF_LIST_ROW_H, LV_ANIM_OFF);
+  }
+  notif_list_update(l);
+}
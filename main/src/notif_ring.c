@@ -0,0 +1,288 @@
+#include "notif_ring.h"
+#include "phone_proto.h"
+#include <string.h>
+
+#define SECTOR_HEADER 8
+#define RECORD_HEADER 4
+// time, app and title_len ahead of the strings
+#define RECORD_FIXED 6
+#define RECORD_MAX (RECORD_FIXED + NOTIF_TITLE_MAX + NOTIF_TEXT_MAX)
+#define RECORD_END 0xffff
+#define NO_SECTOR NOTIF_RING_MAX_SECTORS
+
+_Static_assert(RECORD_MAX < RECORD_END, "record length must fit len:u16");
+_Static_assert(NOTIF_RING_MIN_RECORD == ((RECORD_HEADER + RECORD_FIXED + 3) &
+                                         ~3),
+               "NOTIF_RING_MIN_RECORD is the padded empty record");
+
+static uint32_t record_size(uint32_t len) {
+  return (RECORD_HEADER + len + 3) & ~3u;
+}
+
+static uint32_t sector_base(uint32_t sector) {
+  return sector * NOTIF_RING_SECTOR_SIZE;
+}
+
+static uint32_t prev_sector(const notif_ring_t *r, uint32_t sector) {
+  return (sector + r->sector_count - 1) % r->sector_count;
+}
+
+// The record at offset of sector, its length checked against the sector
+// and its CRC against the bytes
+static bool read_record(notif_ring_t *r, uint32_t sector, uint32_t offset,
+                        uint8_t *payload, uint16_t *len) {
+  uint16_t hdr[2];
+  if (offset + RECORD_HEADER > NOTIF_RING_SECTOR_SIZE ||
+      !r->flash.read(r->flash.ctx, sector_base(sector) + offset, hdr,
+                     sizeof(hdr))) {
+    return false;
+  }
+  if (hdr[0] < RECORD_FIXED || hdr[0] > RECORD_MAX ||
+      offset + RECORD_HEADER + hdr[0] > NOTIF_RING_SECTOR_SIZE) {
+    return false;
+  }
+  if (!r->flash.read(r->flash.ctx,
+                     sector_base(sector) + offset + RECORD_HEADER, payload,
+                     hdr[0]) ||
+      phone_proto_crc16(0xffff, payload, hdr[0]) != hdr[1]) {
+    return false;
+  }
+  *len = hdr[0];
+  return true;
+}
+
+static bool region_erased(notif_ring_t *r, uint32_t offset, uint32_t len) {
+  uint8_t buf[64];
+  while (len) {
+    uint32_t n = len < sizeof(buf) ? len : sizeof(buf);
+    if (!r->flash.read(r->flash.ctx, offset, buf, n)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+      if (buf[i] != 0xff) {
+        return false;
+      }
+    }
+    offset += n;
+    len -= n;
+  }
+  return true;
+}
+
+/* Count the records of a sector. A record that does not check out ends the
+ * sector: nothing after it can be trusted, and nothing more goes in. */
+static void scan_sector(notif_ring_t *r, uint32_t sector) {
+  notif_sector_t *s = &r->sectors[sector];
+  uint8_t payload[RECORD_MAX];
+  uint32_t offset = SECTOR_HEADER;
+  s->count = 0;
+  while (offset + RECORD_HEADER <= NOTIF_RING_SECTOR_SIZE) {
+    uint16_t len;
+    if (!r->flash.read(r->flash.ctx, sector_base(sector) + offset, &len,
+                       sizeof(len))) {
+      break;
+    }
+    if (len == RECORD_END) {
+      // A record whose length never made it leaves its bytes behind
+      if (!region_erased(r, sector_base(sector) + offset,
+                         NOTIF_RING_SECTOR_SIZE - offset)) {
+        r->stats.torn++;
+        offset = NOTIF_RING_SECTOR_SIZE;
+      }
+      break;
+    }
+    if (!read_record(r, sector, offset, payload, &len)) {
+      r->stats.torn++;
+      offset = NOTIF_RING_SECTOR_SIZE;
+      break;
+    }
+    s->count++;
+    offset += record_size(len);
+  }
+  s->used = offset < NOTIF_RING_SECTOR_SIZE ? offset : NOTIF_RING_SECTOR_SIZE;
+  r->count += s->count;
+}
+
+bool notif_ring_mount(notif_ring_t *r, const notif_flash_t *flash) {
+  memset(r, 0, sizeof(*r));
+  r->flash = *flash;
+  r->index_sector = NO_SECTOR;
+  r->sector_count = flash->size / NOTIF_RING_SECTOR_SIZE;
+  if (r->sector_count > NOTIF_RING_MAX_SECTORS) {
+    r->sector_count = NOTIF_RING_MAX_SECTORS;
+  }
+  if (r->sector_count < 2) {
+    return false;
+  }
+
+  // The newest sector is the one with the highest seq
+  bool found = false;
+  for (uint32_t i = 0; i < r->sector_count; i++) {
+    uint32_t hdr[2];
+    if (!r->flash.read(r->flash.ctx, sector_base(i), hdr, sizeof(hdr))) {
+      return false;
+    }
+    if (hdr[0] != NOTIF_RING_MAGIC || hdr[1] == 0 || hdr[1] == UINT32_MAX) {
+      continue;
+    }
+    r->sectors[i].seq = hdr[1];
+    if (!found || hdr[1] > r->sectors[r->head].seq) {
+      r->head = i;
+      found = true;
+    }
+  }
+  if (!found) {
+    // The first append moves on to sector 0
+    r->head = r->sector_count - 1;
+    return true;
+  }
+
+  // The log is the run of sectors before the head with consecutive seqs,
+  // anything else is left over from before an erase or a crash
+  uint32_t chain = 0;
+  for (uint32_t s = r->head;
+       chain < r->sector_count &&
+       r->sectors[s].seq == r->sectors[r->head].seq - chain &&
+       r->sectors[s].seq != 0;
+       s = prev_sector(r, s)) {
+    chain++;
+  }
+  uint32_t s = r->head;
+  for (uint32_t i = 0; i < r->sector_count; i++, s = prev_sector(r, s)) {
+    if (i < chain) {
+      scan_sector(r, s);
+    } else {
+      r->sectors[s] = (notif_sector_t){0};
+    }
+  }
+  return true;
+}
+
+// Erase the sector after the head and append to it from now on
+static bool start_sector(notif_ring_t *r) {
+  uint32_t next = (r->head + 1) % r->sector_count;
+  uint32_t seq = r->sectors[r->head].seq + 1;
+  notif_sector_t *s = &r->sectors[next];
+  if (r->index_sector == next) {
+    r->index_sector = NO_SECTOR;
+  }
+  r->count -= s->count;
+  r->stats.dropped += s->count;
+  *s = (notif_sector_t){0};
+  if (!r->flash.erase(r->flash.ctx, sector_base(next),
+                      NOTIF_RING_SECTOR_SIZE)) {
+    return false;
+  }
+  r->stats.erases++;
+  uint32_t hdr[2] = {NOTIF_RING_MAGIC, seq};
+  if (!r->flash.write(r->flash.ctx, sector_base(next), hdr, sizeof(hdr))) {
+    return false;
+  }
+  *s = (notif_sector_t){.seq = seq, .count = 0, .used = SECTOR_HEADER};
+  r->head = next;
+  return true;
+}
+
+bool notif_ring_append(notif_ring_t *r, const notif_t *n) {
+  size_t title_len = strnlen(n->title, NOTIF_TITLE_MAX);
+  size_t text_len = strnlen(n->text, NOTIF_TEXT_MAX);
+  uint8_t payload[RECORD_MAX];
+  memcpy(payload, &n->time, sizeof(n->time));
+  payload[4] = n->app;
+  payload[5] = (uint8_t)title_len;
+  memcpy(payload + RECORD_FIXED, n->title, title_len);
+  memcpy(payload + RECORD_FIXED + title_len, n->text, text_len);
+  uint16_t len = (uint16_t)(RECORD_FIXED + title_len + text_len);
+
+  notif_sector_t *s = &r->sectors[r->head];
+  if (!s->seq || s->used + record_size(len) > NOTIF_RING_SECTOR_SIZE) {
+    if (!start_sector(r)) {
+      return false;
+    }
+    s = &r->sectors[r->head];
+  }
+  uint32_t offset = sector_base(r->head) + s->used;
+  uint16_t hdr[2] = {len, phone_proto_crc16(0xffff, payload, len)};
+  if (!r->flash.write(r->flash.ctx, offset + RECORD_HEADER, payload, len) ||
+      !r->flash.write(r->flash.ctx, offset, hdr, sizeof(hdr))) {
+    // Whatever made it in ends the sector at the next mount, and now
+    s->used = NOTIF_RING_SECTOR_SIZE;
+    return false;
+  }
+  if (r->index_sector == r->head) {
+    r->index[s->count] = s->used;
+  }
+  s->used += record_size(len);
+  s->count++;
+  r->count++;
+  r->stats.appended++;
+  return true;
+}
+
+// Offsets of every record of the sector, mount already checked them
+static bool build_index(notif_ring_t *r, uint32_t sector) {
+  uint32_t offset = SECTOR_HEADER;
+  r->index_sector = NO_SECTOR;
+  for (uint32_t i = 0; i < r->sectors[sector].count; i++) {
+    uint16_t len;
+    if (!r->flash.read(r->flash.ctx, sector_base(sector) + offset, &len,
+                       sizeof(len))) {
+      return false;
+    }
+    r->index[i] = offset;
+    offset += record_size(len);
+  }
+  r->index_sector = sector;
+  r->stats.index_builds++;
+  return true;
+}
+
+bool notif_ring_get(notif_ring_t *r, uint32_t index, notif_t *out) {
+  if (index >= r->count) {
+    return false;
+  }
+  uint32_t sector = r->head;
+  while (index >= r->sectors[sector].count) {
+    index -= r->sectors[sector].count;
+    sector = prev_sector(r, sector);
+  }
+  if (r->index_sector != sector && !build_index(r, sector)) {
+    return false;
+  }
+  uint32_t ordinal = r->sectors[sector].count - 1 - index;
+
+  uint8_t payload[RECORD_MAX];
+  uint16_t len;
+  if (!read_record(r, sector, r->index[ordinal], payload, &len)) {
+    return false;
+  }
+  uint32_t title_len = payload[5];
+  uint32_t text_len = len - RECORD_FIXED - title_len;
+  if (title_len > NOTIF_TITLE_MAX || RECORD_FIXED + title_len > len ||
+      text_len > NOTIF_TEXT_MAX) {
+    return false;
+  }
+  memcpy(&out->time, payload, sizeof(out->time));
+  out->app = payload[4];
+  memcpy(out->title, payload + RECORD_FIXED, title_len);
+  out->title[title_len] = '\0';
+  memcpy(out->text, payload + RECORD_FIXED + title_len, text_len);
+  out->text[text_len] = '\0';
+  return true;
+}
+
+bool notif_ring_clear(notif_ring_t *r) {
+  for (uint32_t i = 0; i < r->sector_count; i++) {
+    if (!r->flash.erase(r->flash.ctx, sector_base(i),
+                        NOTIF_RING_SECTOR_SIZE)) {
+      return false;
+    }
+    r->stats.erases++;
+    r->sectors[i] = (notif_sector_t){0};
+  }
+  r->stats.dropped += r->count;
+  r->count = 0;
+  r->head = r->sector_count - 1;
+  r->index_sector = NO_SECTOR;
+  return true;
+}
@@ -0,0 +1,49 @@
+#include "notif_store.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+
+static const char *TAG = "NOTIF_STORE";
+
+static notif_ring_t s_ring;
+static bool s_mounted;
+
+static bool partition_read(void *ctx, uint32_t offset, void *dst,
+                           uint32_t len) {
+  return esp_partition_read(ctx, offset, dst, len) == ESP_OK;
+}
+
+static bool partition_write(void *ctx, uint32_t offset, const void *src,
+                            uint32_t len) {
+  return esp_partition_write(ctx, offset, src, len) == ESP_OK;
+}
+
+static bool partition_erase(void *ctx, uint32_t offset, uint32_t len) {
+  return esp_partition_erase_range(ctx, offset, len) == ESP_OK;
+}
+
+bool notif_store_init(void) {
+  const esp_partition_t *part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+      NOTIF_PARTITION_LABEL);
+  if (!part) {
+    ESP_LOGW(TAG, "No %s partition", NOTIF_PARTITION_LABEL);
+    return false;
+  }
+  const notif_flash_t flash = {
+      .read = partition_read,
+      .write = partition_write,
+      .erase = partition_erase,
+      .ctx = (void *)part,
+      .size = part->size,
+  };
+  s_mounted = notif_ring_mount(&s_ring, &flash);
+  if (!s_mounted) {
+    ESP_LOGW(TAG, "%s partition not usable", NOTIF_PARTITION_LABEL);
+    return false;
+  }
+  ESP_LOGI(TAG, "%u notifications, %u torn records dropped",
+           (unsigned)notif_ring_count(&s_ring), (unsigned)s_ring.stats.torn);
+  return true;
+}
+
+notif_ring_t *notif_store_ring(void) { return s_mounted ? &s_ring : NULL; }
@@ -0,0 +1,280 @@
+#include "phone_proto.h"
+#include <assert.h>
+#include <string.h>
+
+const char *const phone_proto_err_names[] = {
+    [PHONE_PROTO_OK] = "ok",
+    [PHONE_PROTO_END] = "end",
+    [PHONE_PROTO_ERR_SHORT] = "truncated",
+    [PHONE_PROTO_ERR_LEN] = "bad length",
+    [PHONE_PROTO_ERR_CRC] = "CRC mismatch",
+    [PHONE_PROTO_ERR_VERSION] = "unsupported version",
+};
+
+// Polynomial 0x1021, a nibble at a time
+static const uint16_t crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
+
+uint16_t phone_proto_crc16(uint16_t crc, const void *data, size_t len) {
+  const uint8_t *p = data;
+  while (len--) {
+    crc ^= (uint16_t)(*p++ << 8);
+    crc = (uint16_t)(crc << 4) ^ crc16_nibble[crc >> 12];
+    crc = (uint16_t)(crc << 4) ^ crc16_nibble[crc >> 12];
+  }
+  return crc;
+}
+
+#define CRC16_INIT 0xffff
+
+// Unaligned little-endian access, payloads sit at any offset in the packet
+static uint16_t get_u16(const uint8_t *p) { return p[0] | p[1] << 8; }
+
+static uint32_t get_u32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  put_u16(p, v);
+  put_u16(p + 2, v >> 16);
+}
+
+void phone_proto_reader_init(phone_proto_reader_t *r, const void *packet,
+                             size_t len) {
+  r->p = packet;
+  r->end = r->p + len;
+}
+
+phone_proto_err_t phone_proto_next(phone_proto_reader_t *r,
+                                   phone_proto_frame_t *frame) {
+  size_t left = r->end - r->p;
+  if (left == 0) {
+    return PHONE_PROTO_END;
+  }
+  phone_proto_err_t err = PHONE_PROTO_OK;
+  uint16_t len = left >= 2 ? get_u16(r->p) : 0;
+  if (left < 2 || len > left) {
+    err = PHONE_PROTO_ERR_SHORT;
+  } else if (len < PHONE_PROTO_FRAME_OVERHEAD ||
+             len - PHONE_PROTO_FRAME_OVERHEAD > PHONE_PROTO_MAX_PAYLOAD) {
+    // Writers refuse longer payloads, so readers do too
+    err = PHONE_PROTO_ERR_LEN;
+  } else if (phone_proto_crc16(CRC16_INIT, r->p, len - 2) !=
+             get_u16(r->p + len - 2)) {
+    err = PHONE_PROTO_ERR_CRC;
+  }
+  if (err != PHONE_PROTO_OK) {
+    // Nothing after a bad length or CRC can be trusted to start a frame
+    r->p = r->end;
+    return err;
+  }
+
+  frame->version = r->p[2];
+  frame->type = r->p[3];
+  frame->payload = r->p + 4;
+  frame->len = len - PHONE_PROTO_FRAME_OVERHEAD;
+  r->p += len;
+  return frame->version == PHONE_PROTO_VERSION ? PHONE_PROTO_OK
+                                               : PHONE_PROTO_ERR_VERSION;
+}
+
+void phone_proto_writer_init(phone_proto_writer_t *w, void *buf, size_t cap) {
+  w->buf = buf;
+  w->cap = cap;
+  w->len = 0;
+}
+
+bool phone_proto_write(phone_proto_writer_t *w, uint8_t type,
+                       const void *payload, size_t len) {
+  size_t frame_len = len + PHONE_PROTO_FRAME_OVERHEAD;
+  if (len > PHONE_PROTO_MAX_PAYLOAD || frame_len > w->cap - w->len) {
+    return false;
+  }
+  uint8_t *p = w->buf + w->len;
+  put_u16(p, frame_len);
+  p[2] = PHONE_PROTO_VERSION;
+  p[3] = type;
+  memcpy(p + 4, payload, len);
+  put_u16(p + 4 + len, phone_proto_crc16(CRC16_INIT, p, 4 + len));
+  w->len += frame_len;
+  return true;
+}
+
+size_t phone_proto_encode_time_sync(const phone_time_sync_t *m, uint8_t *out,
+                                    size_t cap) {
+  if (cap < 6) {
+    return 0;
+  }
+  put_u32(out, m->unix_s);
+  put_u16(out + 4, (uint16_t)m->utc_offset_min);
+  return 6;
+}
+
+size_t phone_proto_encode_steps(const phone_steps_t *m, uint8_t *out,
+                                size_t cap) {
+  if (cap < 4) {
+    return 0;
+  }
+  put_u32(out, m->steps);
+  return 4;
+}
+
+size_t phone_proto_encode_battery(const phone_battery_t *m, uint8_t *out,
+                                  size_t cap) {
+  if (cap < 2) {
+    return 0;
+  }
+  out[0] = m->percent;
+  out[1] = m->charging;
+  return 2;
+}
+
+// flags:u8 | position_s:u16 | duration_s:u16 | n:u8 title[n] | n:u8 artist[n]
+size_t phone_proto_encode_media_state(const phone_media_state_t *m,
+                                      uint8_t *out, size_t cap) {
+  size_t len = 7 + m->title_len + m->artist_len;
+  if (cap < len || len > PHONE_PROTO_MAX_PAYLOAD) {
+    return 0;
+  }
+  out[0] = m->playing;
+  put_u16(out + 1, m->position_s);
+  put_u16(out + 3, m->duration_s);
+  out[5] = m->title_len;
+  memcpy(out + 6, m->title, m->title_len);
+  out[6 + m->title_len] = m->artist_len;
+  memcpy(out + 7 + m->title_len, m->artist, m->artist_len);
+  return len;
+}
+
+size_t phone_proto_encode_media_cmd(phone_media_cmd_t cmd, uint8_t *out,
+                                    size_t cap) {
+  if (cap < 1) {
+    return 0;
+  }
+  out[0] = cmd;
+  return 1;
+}
+
+bool phone_proto_decode_time_sync(const phone_proto_frame_t *f,
+                                  phone_time_sync_t *m) {
+  if (f->type != PHONE_MSG_TIME_SYNC || f->len < 6) {
+    return false;
+  }
+  m->unix_s = get_u32(f->payload);
+  m->utc_offset_min = (int16_t)get_u16(f->payload + 4);
+  return true;
+}
+
+bool phone_proto_decode_steps(const phone_proto_frame_t *f, phone_steps_t *m) {
+  if (f->type != PHONE_MSG_STEPS || f->len < 4) {
+    return false;
+  }
+  m->steps = get_u32(f->payload);
+  return true;
+}
+
+bool phone_proto_decode_battery(const phone_proto_frame_t *f,
+                                phone_battery_t *m) {
+  if (f->type != PHONE_MSG_BATTERY || f->len < 2) {
+    return false;
+  }
+  m->percent = f->payload[0];
+  m->charging = f->payload[1] & 1;
+  return true;
+}
+
+bool phone_proto_decode_media_state(const phone_proto_frame_t *f,
+                                    phone_media_state_t *m) {
+  const uint8_t *p = f->payload;
+  if (f->type != PHONE_MSG_MEDIA_STATE || f->len < 7 ||
+      f->len < 7 + p[5] || f->len < 7 + p[5] + p[6 + p[5]]) {
+    return false;
+  }
+  m->playing = p[0] & 1;
+  m->position_s = get_u16(p + 1);
+  m->duration_s = get_u16(p + 3);
+  m->title_len = p[5];
+  m->title = (const char *)p + 6;
+  m->artist_len = p[6 + m->title_len];
+  m->artist = (const char *)p + 7 + m->title_len;
+  return true;
+}
+
+bool phone_proto_decode_media_cmd(const phone_proto_frame_t *f,
+                                  phone_media_cmd_t *cmd) {
+  if (f->type != PHONE_MSG_MEDIA_CMD || f->len < 1 ||
+      f->payload[0] > PHONE_MEDIA_PREVIOUS) {
+    return false;
+  }
+  *cmd = f->payload[0];
+  return true;
+}
+
+void phone_proto_coalescer_init(phone_proto_coalescer_t *c) {
+  memset(c, 0, sizeof(*c));
+}
+
+bool phone_proto_post(phone_proto_coalescer_t *c, phone_msg_type_t type,
+                      const void *payload, size_t len) {
+  if (type <= 0 || type >= PHONE_MSG_TYPE_COUNT ||
+      len > PHONE_PROTO_MAX_PAYLOAD) {
+    return false;
+  }
+  c->superseded += (c->pending >> type) & 1;
+  memcpy(c->payload[type], payload, len);
+  c->len[type] = len;
+  c->pending |= 1u << type;
+  c->posted++;
+  return true;
+}
+
+bool phone_proto_pending(const phone_proto_coalescer_t *c) {
+  return c->pending != 0;
+}
+
+size_t phone_proto_coalesce(phone_proto_coalescer_t *c, void *packet,
+                            size_t mtu) {
+  assert(mtu >= PHONE_PROTO_MIN_MTU);
+  phone_proto_writer_t w;
+  phone_proto_writer_init(&w, packet, mtu);
+  for (uint32_t type = 1; type < PHONE_MSG_TYPE_COUNT; type++) {
+    if ((c->pending >> type) & 1 &&
+        phone_proto_write(&w, type, c->payload[type], c->len[type])) {
+      c->pending &= ~(1u << type);
+      c->frames++;
+    }
+  }
+  c->packets += w.len > 0;
+  return w.len;
+}
+
+int phone_proto_flush(phone_proto_coalescer_t *c,
+                      const phone_proto_transport_t *t) {
+  uint8_t packet[PHONE_PROTO_MAX_MTU];
+  size_t mtu = t->mtu < sizeof(packet) ? t->mtu : sizeof(packet);
+  int sent = 0;
+  for (;;) {
+    uint32_t pending = c->pending;
+    uint32_t frames = c->frames;
+    size_t len = phone_proto_coalesce(c, packet, mtu);
+    if (len == 0) {
+      return sent;
+    }
+    int err = t->send(t->ctx, packet, len);
+    if (err != 0) {
+      // Keep the updates for the next flush unless newer ones replace them
+      c->pending = pending;
+      c->frames = frames;
+      c->packets--;
+      return err < 0 ? err : -err;
+    }
+    sent++;
+  }
+}
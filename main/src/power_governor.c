@@ -0,0 +1,65 @@
+#include "power_governor.h"
+#include <string.h>
+
+const char *const power_governor_state_names[] = {
+    [POWER_GOVERNOR_INTERACTIVE] = "interactive",
+    [POWER_GOVERNOR_ANIMATING] = "animating",
+    [POWER_GOVERNOR_IDLE] = "idle",
+    [POWER_GOVERNOR_DIMMED] = "dimmed",
+};
+
+// Input wins over animations, animations keep the backlight up however long
+// ago the last touch was
+static power_governor_state_t
+power_governor_pick(const power_governor_config_t *cfg, uint32_t inactive_ms,
+                    bool animating) {
+  if (inactive_ms < cfg->interactive_hold_ms) {
+    return POWER_GOVERNOR_INTERACTIVE;
+  }
+  if (animating) {
+    return POWER_GOVERNOR_ANIMATING;
+  }
+  if (inactive_ms >= cfg->dim_after_ms) {
+    return POWER_GOVERNOR_DIMMED;
+  }
+  return POWER_GOVERNOR_IDLE;
+}
+
+void power_governor_init(power_governor_t *g,
+                         const power_governor_config_t *cfg, uint32_t now_ms) {
+  memset(g, 0, sizeof(*g));
+  g->cfg = *cfg;
+  // Boot counts as an interaction: the first screen renders at full rate
+  g->state = POWER_GOVERNOR_INTERACTIVE;
+  g->entered_ms = now_ms;
+}
+
+bool power_governor_update(power_governor_t *g, uint32_t now_ms,
+                           uint32_t inactive_ms, bool animating) {
+  power_governor_state_t next =
+      power_governor_pick(&g->cfg, inactive_ms, animating);
+  if (next == g->state) {
+    return false;
+  }
+  g->time_in_state_ms[g->state] += now_ms - g->entered_ms;
+  g->state = next;
+  g->entered_ms = now_ms;
+  g->transitions++;
+  return true;
+}
+
+uint32_t power_governor_period_ms(const power_governor_t *g) {
+  switch (g->state) {
+  case POWER_GOVERNOR_INTERACTIVE:
+    return g->cfg.interactive_period_ms;
+  case POWER_GOVERNOR_ANIMATING:
+    return g->cfg.animating_period_ms;
+  default:
+    return g->cfg.idle_period_ms;
+  }
+}
+
+uint8_t power_governor_backlight(const power_governor_t *g) {
+  return g->state == POWER_GOVERNOR_DIMMED ? g->cfg.backlight_dim
+                                           : g->cfg.backlight_full;
+}
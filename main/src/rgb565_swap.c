@@ -0,0 +1,41 @@
+#include "rgb565_swap.h"
+#include <stdint.h>
+
+#define SWAP16(v) ((uint16_t)(((v) << 8) | ((v) >> 8)))
+#define SWAP16X2(v) ((((v) & 0x00ff00ffu) << 8) | (((v) >> 8) & 0x00ff00ffu))
+
+void rgb565_swap_words(void *buf, size_t px_count) {
+  uint16_t *buf16 = buf;
+
+  // Peel one pixel so the word loop never issues a misaligned load, which
+  // the C6 would trap and emulate
+  if (((uintptr_t)buf16 & 0x2) && px_count) {
+    *buf16 = SWAP16(*buf16);
+    buf16++;
+    px_count--;
+  }
+
+  uint32_t *buf32 = (uint32_t *)buf16;
+  size_t words = px_count / 2;
+  while (words >= 4) {
+    uint32_t w0 = buf32[0];
+    uint32_t w1 = buf32[1];
+    uint32_t w2 = buf32[2];
+    uint32_t w3 = buf32[3];
+    buf32[0] = SWAP16X2(w0);
+    buf32[1] = SWAP16X2(w1);
+    buf32[2] = SWAP16X2(w2);
+    buf32[3] = SWAP16X2(w3);
+    buf32 += 4;
+    words -= 4;
+  }
+  while (words--) {
+    *buf32 = SWAP16X2(*buf32);
+    buf32++;
+  }
+
+  if (px_count & 1) {
+    buf16 = (uint16_t *)buf32;
+    *buf16 = SWAP16(*buf16);
+  }
+}
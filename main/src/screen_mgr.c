@@ -0,0 +1,532 @@
+#include "screen_mgr.h"
+#include "config.h"
+#include "core/lv_refr_private.h"
+#include "display/lv_display_private.h"
+#include "esp_heap_caps.h"
+#include "lv_mem_pool.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  lv_obj_t *scr; // NULL until visited and after eviction
+  uint32_t shown_ms;
+  // Pool pages the screen was built in, handed back whole on eviction
+  lv_mem_arena_t arena;
+  // Scaled-down bitmap for swipes, outside the LVGL heap
+  uint16_t *snap_px;
+  lv_image_dsc_t snap;
+  uint32_t snap_ms;
+  // Active screen not invalidated since its bitmap was rendered
+  bool snap_clean;
+} screen_slot_t;
+
+typedef struct {
+  lv_display_t *disp;
+  const screen_def_t *defs;
+  uint32_t count;
+  uint32_t heap_budget;
+  uint32_t active;
+  screen_slot_t slots[SCREEN_MGR_MAX_SCREENS];
+  // Bitmaps are all this size. One freed bitmap is kept for the next one.
+  uint32_t snap_size;
+  uint16_t *spare_px;
+  // Full-resolution rows a bitmap is rendered through, band by band
+  uint16_t *band_px;
+  uint32_t band_size;
+  // Renders bitmaps while input is idle
+  lv_timer_t *idle_timer;
+  uint32_t invalidated_ms; // last change on the active screen
+  // Blank screen the two bitmaps slide on, so nothing below them renders
+  lv_obj_t *stage;
+  lv_obj_t *from_img;
+  lv_obj_t *to_img;
+  bool swiping;
+  uint32_t target;
+  int dir;
+  screen_mgr_stats_t stats;
+} screen_mgr_t;
+
+static screen_mgr_t s_mgr;
+
+/* screen_render_band swaps the display's layer_head and the refreshing
+ * display through LVGL's private headers, which change between minor
+ * releases. Recheck it against the new internals before moving the pin. */
+#if LVGL_VERSION_MAJOR != 9 || LVGL_VERSION_MINOR != 2
+#error "screen_render_band is written against LVGL 9.2 internals"
+#endif
+
+_Static_assert(LV_MEM_POOL_ARENAS > SCREEN_MGR_MAX_SCREENS,
+               "one pool arena per screen");
+_Static_assert(SCREEN_SNAPSHOT_BAND_ROWS % (1 << SCREEN_SNAPSHOT_SHIFT) == 0,
+               "bands downscale to whole rows");
+
+static void screen_gesture_cb(lv_event_t *e);
+
+static uint32_t lvgl_heap_used(void) {
+  // The pool counts whole pages, so slab slack is part of the budget
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  return mon.total_size - mon.free_size;
+}
+
+// NULL rather than eat into SCREEN_SNAPSHOT_HEAP_RESERVE
+static void *screen_heap_alloc(size_t size) {
+  if (heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT) <
+      size + SCREEN_SNAPSHOT_HEAP_RESERVE) {
+    return NULL;
+  }
+  return malloc(size);
+}
+
+static void screen_snapshot_free(screen_slot_t *slot) {
+  if (!slot->snap_px) {
+    return;
+  }
+  if (!s_mgr.spare_px) {
+    s_mgr.spare_px = slot->snap_px;
+  } else {
+    s_mgr.stats.snapshot_bytes -= s_mgr.snap_size;
+    free(slot->snap_px);
+  }
+  slot->snap_px = NULL;
+}
+
+// Drop every bitmap and the band, then size them for the display as it is
+static void screen_buffers_reset(void) {
+  for (uint32_t i = 0; i < s_mgr.count; i++) {
+    screen_snapshot_free(&s_mgr.slots[i]);
+  }
+  free(s_mgr.spare_px);
+  free(s_mgr.band_px);
+  s_mgr.spare_px = NULL;
+  s_mgr.band_px = NULL;
+  s_mgr.stats.snapshot_bytes = 0;
+
+  uint32_t w = lv_display_get_horizontal_resolution(s_mgr.disp);
+  uint32_t h = lv_display_get_vertical_resolution(s_mgr.disp);
+  s_mgr.snap_size = (w >> SCREEN_SNAPSHOT_SHIFT) *
+                    (h >> SCREEN_SNAPSHOT_SHIFT) * sizeof(uint16_t);
+  // Allocated with the first bitmap
+  s_mgr.band_size = SCREEN_SNAPSHOT_SHIFT > 0
+                        ? w * SCREEN_SNAPSHOT_BAND_ROWS * sizeof(uint16_t)
+                        : 0;
+}
+
+static void screen_evict(uint32_t index) {
+  screen_slot_t *slot = &s_mgr.slots[index];
+  lv_obj_delete(slot->scr);
+  lv_mem_arena_release(slot->arena);
+  slot->scr = NULL;
+  s_mgr.stats.evicted++;
+  s_mgr.stats.live--;
+}
+
+/* Delete least recently shown screens until the heap is under budget. Never
+ * the active screen or keep; a bitmap of an evicted screen stays usable. */
+static void screen_enforce_budget(uint32_t keep) {
+  while (lvgl_heap_used() > s_mgr.heap_budget) {
+    uint32_t victim = UINT32_MAX;
+    for (uint32_t i = 0; i < s_mgr.count; i++) {
+      screen_slot_t *slot = &s_mgr.slots[i];
+      if (!slot->scr || i == s_mgr.active || i == keep) {
+        continue;
+      }
+      if (victim == UINT32_MAX ||
+          slot->shown_ms < s_mgr.slots[victim].shown_ms) {
+        victim = i;
+      }
+    }
+    if (victim == UINT32_MAX) {
+      return;
+    }
+    screen_evict(victim);
+  }
+}
+
+static lv_obj_t *screen_ensure(uint32_t index) {
+  screen_slot_t *slot = &s_mgr.slots[index];
+  if (!slot->scr) {
+    slot->arena = lv_mem_arena_open();
+    lv_mem_arena_t prev = lv_mem_arena_enter(slot->arena);
+    slot->scr = lv_obj_create(NULL);
+    // Gestures bubble up from the widgets to their screen
+    lv_obj_add_event_cb(slot->scr, screen_gesture_cb, LV_EVENT_GESTURE, NULL);
+    s_mgr.defs[index].create(slot->scr);
+    lv_mem_arena_enter(prev);
+    s_mgr.stats.created++;
+    s_mgr.stats.live++;
+    screen_enforce_budget(index);
+  }
+  return slot->scr;
+}
+
+/* Average blocks of 1 << SCREEN_SNAPSHOT_SHIFT pixels square */
+static void rgb565_downscale(const uint16_t *src, uint32_t src_w,
+                             uint16_t *dst, uint32_t dst_w, uint32_t dst_h) {
+  const uint32_t n = 1u << SCREEN_SNAPSHOT_SHIFT;
+  const uint32_t shift = 2 * SCREEN_SNAPSHOT_SHIFT;
+  for (uint32_t y = 0; y < dst_h; y++) {
+    for (uint32_t x = 0; x < dst_w; x++) {
+      uint32_t r = 0, g = 0, b = 0;
+      for (uint32_t dy = 0; dy < n; dy++) {
+        const uint16_t *row = &src[(y * n + dy) * src_w + x * n];
+        for (uint32_t dx = 0; dx < n; dx++) {
+          r += row[dx] >> 11;
+          g += (row[dx] >> 5) & 0x3f;
+          b += row[dx] & 0x1f;
+        }
+      }
+      dst[y * dst_w + x] =
+          (uint16_t)(((r >> shift) << 11) | ((g >> shift) << 5) | (b >> shift));
+    }
+  }
+}
+
+/* Draw the rows of scr that buf covers, starting at y. This is what
+ * lv_snapshot does for a whole object, with a layer only a band tall. */
+static void screen_render_band(lv_obj_t *scr, lv_draw_buf_t *buf, int32_t y) {
+  lv_area_t area = {0, y, buf->header.w - 1, y + buf->header.h - 1};
+  lv_layer_t layer;
+  lv_memzero(&layer, sizeof(layer));
+  layer.draw_buf = buf;
+  layer.buf_area = area;
+  layer.color_format = buf->header.cf;
+  layer._clip_area = area;
+  layer.phy_clip_area = area;
+  lv_draw_buf_clear(buf, NULL);
+
+  lv_display_t *disp_old = lv_refr_get_disp_refreshing();
+  lv_layer_t *layer_old = s_mgr.disp->layer_head;
+  s_mgr.disp->layer_head = &layer;
+  lv_refr_set_disp_refreshing(s_mgr.disp);
+  lv_obj_redraw(&layer, scr);
+  while (layer.draw_task_head) {
+    lv_draw_dispatch_wait_for_request();
+    lv_draw_dispatch();
+  }
+  s_mgr.disp->layer_head = layer_old;
+  lv_refr_set_disp_refreshing(disp_old);
+}
+
+/* Render the screen into its bitmap, SCREEN_SNAPSHOT_BAND_ROWS rows at a
+ * time through the band buffer, so no full-resolution buffer is needed */
+static bool screen_snapshot(uint32_t index) {
+  screen_slot_t *slot = &s_mgr.slots[index];
+  uint32_t w = lv_display_get_horizontal_resolution(s_mgr.disp);
+  uint32_t h = lv_display_get_vertical_resolution(s_mgr.disp);
+  uint32_t sw = w >> SCREEN_SNAPSHOT_SHIFT;
+  uint32_t sh = h >> SCREEN_SNAPSHOT_SHIFT;
+
+  if (s_mgr.band_size && !s_mgr.band_px) {
+    if (!(s_mgr.band_px = screen_heap_alloc(s_mgr.band_size))) {
+      return false;
+    }
+    s_mgr.stats.snapshot_bytes += s_mgr.band_size;
+  }
+  if (!slot->snap_px) {
+    if (s_mgr.spare_px) {
+      slot->snap_px = s_mgr.spare_px;
+      s_mgr.spare_px = NULL;
+    } else if ((slot->snap_px = screen_heap_alloc(s_mgr.snap_size))) {
+      s_mgr.stats.snapshot_bytes += s_mgr.snap_size;
+    } else {
+      return false;
+    }
+  }
+
+  lv_obj_t *scr = screen_ensure(index);
+  lv_obj_update_layout(scr);
+  for (uint32_t y = 0; y < h; y += SCREEN_SNAPSHOT_BAND_ROWS) {
+    uint32_t rows = LV_MIN(SCREEN_SNAPSHOT_BAND_ROWS, h - y);
+    uint16_t *px =
+        SCREEN_SNAPSHOT_SHIFT > 0 ? s_mgr.band_px : slot->snap_px + y * w;
+    lv_draw_buf_t buf;
+    lv_draw_buf_init(&buf, w, rows, LV_COLOR_FORMAT_RGB565,
+                     w * sizeof(uint16_t), px, w * rows * sizeof(uint16_t));
+    screen_render_band(scr, &buf, y);
+    if (SCREEN_SNAPSHOT_SHIFT > 0) {
+      rgb565_downscale(px, w, slot->snap_px + (y >> SCREEN_SNAPSHOT_SHIFT) * sw,
+                       sw, rows >> SCREEN_SNAPSHOT_SHIFT);
+    }
+  }
+
+  memset(&slot->snap, 0, sizeof(slot->snap));
+  slot->snap.header.magic = LV_IMAGE_HEADER_MAGIC;
+  slot->snap.header.cf = LV_COLOR_FORMAT_RGB565;
+  slot->snap.header.w = sw;
+  slot->snap.header.h = sh;
+  slot->snap.header.stride = sw * sizeof(uint16_t);
+  slot->snap.data_size = s_mgr.snap_size;
+  slot->snap.data = (const uint8_t *)slot->snap_px;
+  slot->snap_ms = lv_tick_get();
+  slot->snap_clean = true;
+  s_mgr.stats.snapshots++;
+  // The bitmap changed under the same descriptor
+  lv_image_cache_drop(&slot->snap);
+  return true;
+}
+
+/* The active screen's bitmap holds while nothing on it was invalidated, a
+ * hidden screen's only for a while, briefly when it ticks */
+static bool screen_snapshot_fresh(uint32_t index) {
+  const screen_slot_t *slot = &s_mgr.slots[index];
+  if (!slot->snap_px) {
+    return false;
+  }
+  if (index == s_mgr.active) {
+    return slot->snap_clean;
+  }
+  uint32_t max_age = s_mgr.defs[index].ticks ? SCREEN_SNAPSHOT_TICK_MAX_AGE_MS
+                                             : SCREEN_SNAPSHOT_MAX_AGE_MS;
+  return lv_tick_elaps(slot->snap_ms) < max_age;
+}
+
+/* Time until the idle timer should render the screen, UINT32_MAX for never:
+ * screens that tick are stale again within a second, and evicted ones would
+ * have to be rebuilt. The active screen waits until it stopped changing,
+ * neighbours are redone at half their age so a swipe finds them fresh. */
+static uint32_t screen_snapshot_due_in(uint32_t index) {
+  const screen_slot_t *slot = &s_mgr.slots[index];
+  if (s_mgr.defs[index].ticks || !slot->scr) {
+    return UINT32_MAX;
+  }
+  if (!slot->snap_px) {
+    return 0;
+  }
+  uint32_t elapsed, wait;
+  if (index == s_mgr.active) {
+    if (slot->snap_clean) {
+      return UINT32_MAX;
+    }
+    elapsed = lv_tick_elaps(s_mgr.invalidated_ms);
+    wait = SCREEN_SNAPSHOT_IDLE_MS;
+  } else {
+    elapsed = lv_tick_elaps(slot->snap_ms);
+    wait = SCREEN_SNAPSHOT_MAX_AGE_MS / 2;
+  }
+  return elapsed >= wait ? 0 : wait - elapsed;
+}
+
+static void screen_idle_schedule(uint32_t delay_ms) {
+  lv_timer_set_period(s_mgr.idle_timer, delay_ms);
+  lv_timer_reset(s_mgr.idle_timer);
+  lv_timer_resume(s_mgr.idle_timer);
+}
+
+/* Render, once input has been idle, the bitmaps a swipe would otherwise
+ * render: the active screen and its neighbours. One per run, then the timer
+ * sleeps until the next is due, or until the active screen changes. */
+static void screen_idle_cb(lv_timer_t *t) {
+  if (s_mgr.swiping || s_mgr.active >= s_mgr.count) {
+    lv_timer_pause(t); // landing schedules it again
+    return;
+  }
+  uint32_t idle = lv_display_get_inactive_time(s_mgr.disp);
+  const uint32_t candidates[] = {s_mgr.active, s_mgr.active - 1,
+                                 s_mgr.active + 1};
+  uint32_t wait = UINT32_MAX;
+  for (uint32_t k = 0; k < 3; k++) {
+    uint32_t i = candidates[k];
+    if (i >= s_mgr.count) {
+      continue;
+    }
+    uint32_t due = screen_snapshot_due_in(i);
+    if (due == 0 && idle >= SCREEN_SNAPSHOT_IDLE_MS) {
+      screen_snapshot(i);
+      due = SCREEN_SNAPSHOT_IDLE_MS; // the others on the next run
+    } else if (due == 0) {
+      due = SCREEN_SNAPSHOT_IDLE_MS - idle;
+    }
+    wait = LV_MIN(wait, due);
+  }
+  if (wait == UINT32_MAX) {
+    lv_timer_pause(t);
+  } else {
+    lv_timer_set_period(t, wait);
+  }
+}
+
+// Anything drawn on the active screen makes its bitmap out of date
+static void screen_invalidate_cb(lv_event_t *e) {
+  (void)e;
+  if (s_mgr.swiping || s_mgr.active >= s_mgr.count) {
+    return;
+  }
+  s_mgr.slots[s_mgr.active].snap_clean = false;
+  s_mgr.invalidated_ms = lv_tick_get();
+  if (!s_mgr.defs[s_mgr.active].ticks) {
+    // Pushed back by every change, runs once the screen has settled
+    screen_idle_schedule(SCREEN_SNAPSHOT_IDLE_MS);
+  }
+}
+
+/* Bookkeeping once a screen is on the display: only the neighbours a swipe
+ * can reach keep their bitmaps */
+static void screen_landed(uint32_t index) {
+  s_mgr.active = index;
+  s_mgr.slots[index].shown_ms = lv_tick_get();
+  s_mgr.slots[index].snap_clean = false;
+  s_mgr.invalidated_ms = lv_tick_get();
+  for (uint32_t i = 0; i < s_mgr.count; i++) {
+    if (i + 1 < index || i > index + 1) {
+      screen_snapshot_free(&s_mgr.slots[i]);
+    }
+  }
+  screen_enforce_budget(index);
+  s_mgr.stats.heap_used = lvgl_heap_used();
+  screen_idle_schedule(SCREEN_SNAPSHOT_IDLE_MS);
+}
+
+static lv_obj_t *screen_stage_image(lv_obj_t *stage, const void *src) {
+  lv_obj_t *img = lv_image_create(stage);
+  lv_image_set_src(img, src);
+  // Stretch the scaled bitmap back over the whole display
+  lv_obj_set_size(img, lv_display_get_horizontal_resolution(s_mgr.disp),
+                  lv_display_get_vertical_resolution(s_mgr.disp));
+  lv_image_set_inner_align(img, LV_IMAGE_ALIGN_STRETCH);
+  lv_image_set_antialias(img, false);
+  return img;
+}
+
+static void screen_swipe_exec(void *var, int32_t v) {
+  (void)var;
+  int32_t w = lv_display_get_horizontal_resolution(s_mgr.disp);
+  lv_obj_set_x(s_mgr.from_img, -s_mgr.dir * v);
+  lv_obj_set_x(s_mgr.to_img, s_mgr.dir * (w - v));
+}
+
+static void screen_swipe_done(lv_anim_t *a) {
+  (void)a;
+  // A reused bitmap may belong to an evicted screen: it gets rebuilt now
+  lv_screen_load(screen_ensure(s_mgr.target));
+  lv_obj_clean(s_mgr.stage);
+  s_mgr.from_img = NULL;
+  s_mgr.to_img = NULL;
+  s_mgr.swiping = false;
+  screen_landed(s_mgr.target);
+}
+
+/* A bitmap rendered while idle when there is a fresh one, which the idle
+ * timer sees to for screens that do not tick. Otherwise render it now. */
+static bool screen_snapshot_for_swipe(uint32_t index) {
+  screen_slot_t *slot = &s_mgr.slots[index];
+  if (screen_snapshot_fresh(index)) {
+    if (index == s_mgr.active) {
+      slot->snap_ms = lv_tick_get(); // still what the display shows
+    }
+    s_mgr.stats.snapshot_hits++;
+    return true;
+  }
+  s_mgr.stats.swipe_renders++;
+  return screen_snapshot(index);
+}
+
+bool screen_mgr_swipe(int dir) {
+  uint32_t from = s_mgr.active;
+  if (s_mgr.swiping || (dir < 0 && from == 0) ||
+      (dir > 0 && from + 1 >= s_mgr.count)) {
+    return false;
+  }
+  uint32_t target = dir > 0 ? from + 1 : from - 1;
+
+  if (!screen_snapshot_for_swipe(from) ||
+      !screen_snapshot_for_swipe(target)) {
+    // No memory for bitmaps, or not without the heap reserve: slide the
+    // live screens
+    s_mgr.stats.live_fallbacks++;
+    lv_screen_load_anim(screen_ensure(target),
+                        dir > 0 ? LV_SCR_LOAD_ANIM_MOVE_LEFT
+                                : LV_SCR_LOAD_ANIM_MOVE_RIGHT,
+                        SCREEN_SWIPE_ANIM_MS, 0, false);
+    screen_landed(target);
+    return true;
+  }
+
+  s_mgr.swiping = true;
+  s_mgr.target = target;
+  s_mgr.dir = dir > 0 ? 1 : -1;
+  s_mgr.from_img = screen_stage_image(s_mgr.stage, &s_mgr.slots[from].snap);
+  s_mgr.to_img = screen_stage_image(s_mgr.stage, &s_mgr.slots[target].snap);
+  screen_swipe_exec(NULL, 0);
+  lv_screen_load(s_mgr.stage);
+
+  lv_anim_t a;
+  lv_anim_init(&a);
+  lv_anim_set_var(&a, s_mgr.stage);
+  lv_anim_set_exec_cb(&a, screen_swipe_exec);
+  lv_anim_set_values(&a, 0, lv_display_get_horizontal_resolution(s_mgr.disp));
+  lv_anim_set_duration(&a, SCREEN_SWIPE_ANIM_MS);
+  lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
+  lv_anim_set_completed_cb(&a, screen_swipe_done);
+  lv_anim_start(&a);
+  return true;
+}
+
+static void screen_gesture_cb(lv_event_t *e) {
+  (void)e;
+  lv_indev_t *indev = lv_indev_active();
+  lv_dir_t dir = lv_indev_get_gesture_dir(indev);
+  bool started = false;
+  if (dir == LV_DIR_LEFT) {
+    started = screen_mgr_swipe(1);
+  } else if (dir == LV_DIR_RIGHT) {
+    started = screen_mgr_swipe(-1);
+  }
+  if (started) {
+    // The release must not click whatever ends up under the finger
+    lv_indev_wait_release(indev);
+  }
+}
+
+// Bitmaps and the band are sized for the old orientation
+static void screen_resolution_cb(lv_event_t *e) {
+  (void)e;
+  screen_buffers_reset();
+}
+
+void screen_mgr_init(lv_display_t *disp, const screen_def_t *defs,
+                     uint32_t count, uint32_t heap_budget) {
+  assert(count > 0 && count <= SCREEN_MGR_MAX_SCREENS);
+  for (uint32_t i = 0; i < s_mgr.count; i++) {
+    free(s_mgr.slots[i].snap_px);
+  }
+  free(s_mgr.spare_px);
+  free(s_mgr.band_px);
+  if (s_mgr.idle_timer) {
+    lv_timer_delete(s_mgr.idle_timer);
+  }
+  memset(&s_mgr, 0, sizeof(s_mgr));
+  s_mgr.disp = disp;
+  s_mgr.defs = defs;
+  s_mgr.count = count;
+  s_mgr.heap_budget = heap_budget;
+  s_mgr.active = UINT32_MAX;
+
+  s_mgr.stage = lv_obj_create(NULL);
+  lv_obj_set_style_bg_color(s_mgr.stage, lv_color_black(), LV_PART_MAIN);
+  lv_obj_remove_flag(s_mgr.stage, LV_OBJ_FLAG_SCROLLABLE);
+  lv_display_add_event_cb(disp, screen_resolution_cb,
+                          LV_EVENT_RESOLUTION_CHANGED, NULL);
+  lv_display_add_event_cb(disp, screen_invalidate_cb,
+                          LV_EVENT_INVALIDATE_AREA, NULL);
+  screen_buffers_reset();
+  s_mgr.idle_timer =
+      lv_timer_create(screen_idle_cb, SCREEN_SNAPSHOT_IDLE_MS, NULL);
+  lv_timer_pause(s_mgr.idle_timer);
+}
+
+void screen_mgr_show(uint32_t index) {
+  assert(index < s_mgr.count && !s_mgr.swiping);
+  lv_obj_t *old = lv_display_get_screen_active(s_mgr.disp);
+  lv_screen_load(screen_ensure(index));
+  if (s_mgr.active == UINT32_MAX && old != s_mgr.stage) {
+    // The display's default screen is not one of ours
+    lv_obj_delete(old);
+  }
+  screen_landed(index);
+}
+
+uint32_t screen_mgr_active(void) { return s_mgr.active; }
+
+void screen_mgr_get_stats(screen_mgr_stats_t *out) { *out = s_mgr.stats; }
@@ -0,0 +1,151 @@
+#include "tile_hash.h"
+#include <string.h>
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+static uint32_t rotl32(uint32_t v, int r) { return (v << r) | (v >> (32 - r)); }
+
+// One MurmurHash3 round per two pixels. 16-bit loads only, the rows of a
+// strip are not always 4-byte aligned and the C6 traps misaligned loads.
+static uint32_t hash_tile(const uint16_t *px, uint32_t stride, uint32_t w,
+                          uint32_t h) {
+  uint32_t hash = w << 16 | h;
+  for (uint32_t y = 0; y < h; y++, px += stride) {
+    uint32_t x = 0;
+    for (; x + 1 < w; x += 2) {
+      uint32_t k = px[x] | (uint32_t)px[x + 1] << 16;
+      hash ^= rotl32(k * 0xcc9e2d51u, 15) * 0x1b873593u;
+      hash = rotl32(hash, 13) * 5 + 0xe6546b64u;
+    }
+    if (x < w) {
+      hash ^= rotl32(px[x] * 0xcc9e2d51u, 15) * 0x1b873593u;
+      hash = rotl32(hash, 13) * 5 + 0xe6546b64u;
+    }
+  }
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash == TILE_HASH_UNKNOWN ? 1 : hash;
+}
+
+void tile_hash_init(tile_hash_t *t, uint32_t *hashes, uint32_t capacity) {
+  memset(t, 0, sizeof(*t));
+  t->hashes = hashes;
+  t->capacity = capacity;
+}
+
+bool tile_hash_set_resolution(tile_hash_t *t, int32_t hor_res,
+                              int32_t ver_res) {
+  uint32_t cols = (hor_res + TILE_HASH_SIZE - 1) / TILE_HASH_SIZE;
+  uint32_t rows = (ver_res + TILE_HASH_SIZE - 1) / TILE_HASH_SIZE;
+  if (cols * rows > t->capacity) {
+    t->cols = t->rows = 0;
+    return false;
+  }
+  t->hor_res = hor_res;
+  t->ver_res = ver_res;
+  t->cols = cols;
+  t->rows = rows;
+  tile_hash_reset(t);
+  return true;
+}
+
+void tile_hash_reset(tile_hash_t *t) {
+  memset(t->hashes, 0, t->capacity * sizeof(t->hashes[0]));
+}
+
+void tile_hash_round(const tile_hash_t *t, int32_t *x1, int32_t *y1,
+                     int32_t *x2, int32_t *y2) {
+  *x1 -= *x1 % TILE_HASH_SIZE;
+  *y1 -= *y1 % TILE_HASH_SIZE;
+  *x2 = MIN(*x2 | (TILE_HASH_SIZE - 1), t->hor_res - 1);
+  *y2 = MIN(*y2 | (TILE_HASH_SIZE - 1), t->ver_res - 1);
+}
+
+/* Compare one band of tile row r and return the x range to send, x1 > x2
+ * when every tile matched */
+static void filter_band(tile_hash_t *t, int32_t x1, int32_t x2, int32_t by1,
+                        int32_t by2, bool whole_rows, const uint16_t *row,
+                        uint32_t stride, int32_t *sx1, int32_t *sx2) {
+  uint32_t r = by1 / TILE_HASH_SIZE;
+  *sx1 = INT32_MAX;
+  *sx2 = INT32_MIN;
+  for (uint32_t c = x1 / TILE_HASH_SIZE; c <= (uint32_t)x2 / TILE_HASH_SIZE;
+       c++) {
+    int32_t cx1 = c * TILE_HASH_SIZE;
+    int32_t cx2 = MIN(cx1 + TILE_HASH_SIZE - 1, t->hor_res - 1);
+    int32_t tx1 = MAX(x1, cx1);
+    int32_t tx2 = MIN(x2, cx2);
+    uint32_t *slot = &t->hashes[r * t->cols + c];
+    if (whole_rows && tx1 == cx1 && tx2 == cx2) {
+      uint32_t hash = hash_tile(row + (tx1 - x1), stride, tx2 - tx1 + 1,
+                                by2 - by1 + 1);
+      t->stats.tiles_hashed++;
+      if (hash == *slot) {
+        t->stats.tiles_skipped++;
+        continue;
+      }
+      *slot = hash;
+    } else {
+      // What the rest of the tile shows is not in this strip
+      *slot = TILE_HASH_UNKNOWN;
+      t->stats.tiles_partial++;
+    }
+    *sx1 = MIN(*sx1, tx1);
+    *sx2 = MAX(*sx2, tx2);
+  }
+}
+
+uint32_t tile_hash_filter(tile_hash_t *t, int32_t x1, int32_t y1, int32_t x2,
+                          int32_t y2, uint8_t *px,
+                          tile_hash_span_t spans[TILE_HASH_MAX_SPANS]) {
+  const uint32_t stride = x2 - x1 + 1;
+  uint32_t n = 0;
+
+  for (int32_t by1 = y1; by1 <= y2;) {
+    int32_t ty1 = by1 - by1 % TILE_HASH_SIZE;
+    int32_t ty2 = MIN(ty1 + TILE_HASH_SIZE - 1, t->ver_res - 1);
+    int32_t by2 = MIN(y2, ty2);
+    int32_t sx1, sx2;
+    filter_band(t, x1, x2, by1, by2, by1 == ty1 && by2 == ty2,
+                (const uint16_t *)px + (by1 - y1) * stride, stride, &sx1,
+                &sx2);
+    if (sx1 <= sx2) {
+      tile_hash_span_t *last = n ? &spans[n - 1] : NULL;
+      if (last && last->y2 + 1 == by1 && last->x1 == sx1 && last->x2 == sx2) {
+        last->y2 = by2;
+      } else if (n == TILE_HASH_MAX_SPANS) {
+        // Out of windows: the last one grows over the bands in between
+        last->x1 = MIN(last->x1, sx1);
+        last->x2 = MAX(last->x2, sx2);
+        last->y2 = by2;
+      } else {
+        spans[n++] = (tile_hash_span_t){sx1, by1, sx2, by2, 0};
+      }
+    }
+    by1 = by2 + 1;
+  }
+
+  // Pack the spans row by row; every row moves down or stays, never up
+  size_t packed = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    tile_hash_span_t *s = &spans[i];
+    size_t row_bytes = (s->x2 - s->x1 + 1) * sizeof(uint16_t);
+    s->offset = packed;
+    for (int32_t y = s->y1; y <= s->y2; y++) {
+      size_t src = ((y - y1) * stride + (s->x1 - x1)) * sizeof(uint16_t);
+      if (src != packed) {
+        memmove(px + packed, px + src, row_bytes);
+      }
+      packed += row_bytes;
+    }
+  }
+  t->stats.bytes_skipped += stride * (y2 - y1 + 1) * sizeof(uint16_t) - packed;
+  if (n == 0) {
+    t->stats.strips_skipped++;
+  }
+  return n;
+}
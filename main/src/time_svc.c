@@ -0,0 +1,107 @@
+#include "time_svc.h"
+#include "config.h"
+#include "esp_log.h"
+#include "timer_svc.h"
+#include <sys/time.h>
+
+static const char *TAG = "time_svc";
+
+typedef struct {
+  uint32_t events;
+  time_svc_cb_t cb;
+  void *arg;
+} time_svc_sub_t;
+
+static local_time_t s_time;
+static struct tm s_last; // local time at the last tick
+static timer_wheel_timer_t s_tick;
+static time_svc_sub_t s_subs[TIME_SVC_MAX_SUBSCRIBERS];
+static int s_num_subs;
+static uint32_t s_events; // all the subscribers want
+
+static void time_svc_read(struct tm *out, int32_t *usec) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  local_time_get(&s_time, tv.tv_sec, out);
+  *usec = (int32_t)tv.tv_usec;
+}
+
+static uint32_t time_svc_changed(const struct tm *a, const struct tm *b) {
+  if (a->tm_mday != b->tm_mday || a->tm_mon != b->tm_mon ||
+      a->tm_year != b->tm_year) {
+    return TIME_SVC_DAY | TIME_SVC_HOUR | TIME_SVC_MINUTE | TIME_SVC_SECOND;
+  }
+  if (a->tm_hour != b->tm_hour) {
+    return TIME_SVC_HOUR | TIME_SVC_MINUTE | TIME_SVC_SECOND;
+  }
+  if (a->tm_min != b->tm_min) {
+    return TIME_SVC_MINUTE | TIME_SVC_SECOND;
+  }
+  return a->tm_sec != b->tm_sec ? TIME_SVC_SECOND : 0;
+}
+
+/* Next tick just after the next boundary anyone wants. One that fires early
+ * finds nothing changed and comes back for the rest. */
+static void time_svc_arm(const struct tm *now, int32_t usec) {
+  if (!s_events) {
+    return;
+  }
+  uint32_t delay_ms = 1000 - usec / 1000 + TIME_SVC_TICK_SLACK_MS;
+  if (!(s_events & TIME_SVC_SECOND)) {
+    delay_ms += (59 - now->tm_sec) * 1000;
+  }
+  timer_svc_start(&s_tick, delay_ms, 0);
+}
+
+static void time_svc_tick(timer_wheel_timer_t *t) {
+  (void)t;
+  struct tm now;
+  int32_t usec;
+  time_svc_read(&now, &usec);
+  uint32_t changed = time_svc_changed(&s_last, &now);
+  s_last = now;
+  for (int i = 0; changed && i < s_num_subs; i++) {
+    if (s_subs[i].events & changed) {
+      s_subs[i].cb(&now, changed, s_subs[i].arg);
+    }
+  }
+  time_svc_arm(&now, usec);
+}
+
+void time_svc_init(const char *tz_rule) {
+  local_tz_t tz;
+  if (!local_tz_parse(tz_rule, &tz)) {
+    ESP_LOGW(TAG, "bad TZ rule \"%s\", using UTC", tz_rule);
+    local_tz_parse("UTC0", &tz);
+  }
+  local_time_init(&s_time, &tz);
+  timer_wheel_timer_init(&s_tick, time_svc_tick, NULL);
+  int32_t usec;
+  time_svc_read(&s_last, &usec);
+}
+
+bool time_svc_subscribe(uint32_t events, time_svc_cb_t cb, void *arg) {
+  if (s_num_subs == TIME_SVC_MAX_SUBSCRIBERS) {
+    return false;
+  }
+  s_subs[s_num_subs++] = (time_svc_sub_t){events, cb, arg};
+  if ((s_events | events) != s_events) {
+    // A finer tick may be wanted, due from now
+    s_events |= events;
+    time_svc_resync(NULL);
+  }
+  return true;
+}
+
+void time_svc_now(struct tm *out) {
+  int32_t usec;
+  time_svc_read(out, &usec);
+}
+
+void time_svc_resync(void *arg) {
+  (void)arg;
+  timer_svc_stop(&s_tick);
+  time_svc_tick(&s_tick);
+}
+
+void time_svc_get_stats(local_time_stats_t *out) { *out = s_time.stats; }
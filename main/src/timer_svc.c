@@ -0,0 +1,113 @@
+#include "timer_svc.h"
+#include "config.h"
+#include "esp_timer.h"
+#include "ui_cmd.h"
+#include <assert.h>
+#include <stdatomic.h>
+
+static timer_wheel_t s_wheel;
+static esp_timer_handle_t s_wakeup;
+// Deadline s_wakeup is armed for, UINT64_MAX when it is not
+static uint64_t s_armed_deadline = UINT64_MAX;
+static bool s_in_run; // callbacks are running, the wheel is at their deadline
+static uint32_t s_runs;
+static uint32_t s_arms;
+static _Atomic uint32_t s_retries; // esp_timer task
+
+static uint64_t now_ms(void) { return (uint64_t)esp_timer_get_time() / 1000; }
+
+/* Point the esp_timer at the earliest deadline, left alone when that did not
+ * change so starting and stopping later timers costs no esp_timer calls */
+static void timer_svc_rearm(void) {
+  if (s_in_run) {
+    return; // re-armed once the callbacks are done
+  }
+  uint64_t deadline;
+  if (!timer_wheel_next(&s_wheel, &deadline)) {
+    deadline = UINT64_MAX;
+  }
+  if (deadline == s_armed_deadline) {
+    return;
+  }
+  esp_timer_stop(s_wakeup); // not running once it fired
+  s_armed_deadline = deadline;
+  if (deadline != UINT64_MAX) {
+    uint64_t now = now_ms();
+    uint64_t delay_ms = deadline > now ? deadline - now : 0;
+    ESP_ERROR_CHECK(esp_timer_start_once(s_wakeup, delay_ms * 1000));
+    s_arms++;
+  }
+}
+
+/* Run everything due. Timers a callback starts count from the deadline it
+ * fired for, so chained one-shots do not drift. */
+static void timer_svc_advance(void) {
+  if (s_in_run) {
+    return;
+  }
+  s_in_run = true;
+  timer_wheel_advance(&s_wheel, now_ms());
+  s_in_run = false;
+}
+
+// LVGL task, posted by the wakeup
+static void timer_svc_run(void *arg) {
+  (void)arg;
+  s_runs++;
+  // The wakeup fired, or it is about to and this run covers it
+  s_armed_deadline = UINT64_MAX;
+  timer_svc_advance();
+  timer_svc_rearm();
+}
+
+// esp_timer task: hand the wheel to the LVGL task
+static void timer_svc_wakeup_cb(void *arg) {
+  (void)arg;
+  if (!ui_cmd_post_call(timer_svc_run, NULL)) {
+    // The queue drains within a frame, and a one-shot may re-arm itself
+    atomic_fetch_add_explicit(&s_retries, 1, memory_order_relaxed);
+    esp_timer_start_once(s_wakeup, TIMER_SVC_RETRY_MS * 1000);
+  }
+}
+
+void timer_svc_init(void) {
+  const esp_timer_create_args_t args = {
+      .callback = timer_svc_wakeup_cb,
+      .name = "timer_svc",
+  };
+  ESP_ERROR_CHECK(esp_timer_create(&args, &s_wakeup));
+  timer_wheel_init(&s_wheel, now_ms());
+}
+
+// Delays count from now, not from when the wheel last ran
+void timer_svc_start(timer_wheel_timer_t *t, uint32_t delay_ms,
+                     uint32_t period_ms) {
+  assert(s_wakeup);
+  timer_svc_advance();
+  timer_wheel_start(&s_wheel, t, delay_ms, period_ms);
+  timer_svc_rearm();
+}
+
+void timer_svc_stop(timer_wheel_timer_t *t) {
+  timer_wheel_stop(&s_wheel, t);
+  timer_svc_rearm();
+}
+
+void timer_svc_pause(timer_wheel_timer_t *t) {
+  timer_svc_advance();
+  timer_wheel_pause(&s_wheel, t);
+  timer_svc_rearm();
+}
+
+void timer_svc_resume(timer_wheel_timer_t *t) {
+  timer_svc_advance();
+  timer_wheel_resume(&s_wheel, t);
+  timer_svc_rearm();
+}
+
+void timer_svc_get_stats(timer_svc_stats_t *out) {
+  out->wheel = s_wheel.stats;
+  out->runs = s_runs;
+  out->arms = s_arms;
+  out->retries = atomic_load_explicit(&s_retries, memory_order_relaxed);
+}
@@ -0,0 +1,202 @@
+#include "timer_wheel.h"
+#include <stddef.h>
+#include <string.h>
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define OVERFLOW_LEVEL TIMER_WHEEL_LEVELS
+
+static uint32_t level_shift(uint32_t level) {
+  return level * TIMER_WHEEL_SLOT_BITS;
+}
+
+static timer_wheel_timer_t **list_head(timer_wheel_t *w, uint32_t level,
+                                       uint64_t expires) {
+  if (level == OVERFLOW_LEVEL) {
+    return &w->overflow;
+  }
+  return &w->slots[level][(expires >> level_shift(level)) & SLOT_MASK];
+}
+
+static void link(timer_wheel_t *w, timer_wheel_timer_t *t) {
+  // The lowest level whose bits above it match now
+  uint64_t diff = t->expires ^ w->now;
+  uint32_t level = 0;
+  while (level < TIMER_WHEEL_LEVELS && (diff >> level_shift(level + 1))) {
+    level++;
+  }
+  timer_wheel_timer_t **head = list_head(w, level, t->expires);
+  t->level = level;
+  t->prev = NULL;
+  t->next = *head;
+  if (*head) {
+    (*head)->prev = t;
+  }
+  *head = t;
+  if (level != OVERFLOW_LEVEL) {
+    w->occupied[level] |=
+        1ull << ((t->expires >> level_shift(level)) & SLOT_MASK);
+  }
+  w->stats.armed++;
+}
+
+static void unlink(timer_wheel_t *w, timer_wheel_timer_t *t) {
+  timer_wheel_timer_t **head = list_head(w, t->level, t->expires);
+  if (t->prev) {
+    t->prev->next = t->next;
+  } else {
+    *head = t->next;
+  }
+  if (t->next) {
+    t->next->prev = t->prev;
+  }
+  if (!*head && t->level != OVERFLOW_LEVEL) {
+    w->occupied[t->level] &=
+        ~(1ull << ((t->expires >> level_shift(t->level)) & SLOT_MASK));
+  }
+  t->next = t->prev = NULL;
+  w->stats.armed--;
+}
+
+// Take a whole list out and link its timers again against the current time
+static void relink_all(timer_wheel_t *w, timer_wheel_timer_t **head,
+                       uint32_t level, uint32_t slot) {
+  timer_wheel_timer_t *t = *head;
+  *head = NULL;
+  if (level != OVERFLOW_LEVEL) {
+    w->occupied[level] &= ~(1ull << slot);
+  }
+  while (t) {
+    timer_wheel_timer_t *next = t->next;
+    w->stats.armed--;
+    link(w, t);
+    w->stats.cascaded++;
+    t = next;
+  }
+}
+
+/* Move now forward, never past the earliest deadline. Only the slot whose
+ * bits now caught up with can hold timers that belong lower: a timer in any
+ * other slot of that level is still later than now in the level's bits. */
+static void set_now(timer_wheel_t *w, uint64_t now) {
+  uint64_t old = w->now;
+  if (now == old) {
+    return;
+  }
+  w->now = now;
+  if ((old >> TIMER_WHEEL_SPAN_BITS) != (now >> TIMER_WHEEL_SPAN_BITS)) {
+    relink_all(w, &w->overflow, OVERFLOW_LEVEL, 0);
+  }
+  for (uint32_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+    uint32_t shift = level_shift(level);
+    if ((old >> shift) != (now >> shift)) {
+      uint32_t slot = (now >> shift) & SLOT_MASK;
+      relink_all(w, &w->slots[level][slot], level, slot);
+    }
+  }
+}
+
+void timer_wheel_init(timer_wheel_t *w, uint64_t now) {
+  memset(w, 0, sizeof(*w));
+  w->now = now;
+}
+
+void timer_wheel_timer_init(timer_wheel_timer_t *t, timer_wheel_cb_t cb,
+                            void *arg) {
+  memset(t, 0, sizeof(*t));
+  t->cb = cb;
+  t->arg = arg;
+}
+
+void timer_wheel_start(timer_wheel_t *w, timer_wheel_timer_t *t,
+                       uint32_t delay, uint32_t period) {
+  if (t->state == TIMER_WHEEL_ARMED) {
+    unlink(w, t);
+  }
+  t->expires = w->now + delay;
+  t->period = period;
+  t->state = TIMER_WHEEL_ARMED;
+  link(w, t);
+}
+
+void timer_wheel_stop(timer_wheel_t *w, timer_wheel_timer_t *t) {
+  if (t->state == TIMER_WHEEL_ARMED) {
+    unlink(w, t);
+  }
+  t->state = TIMER_WHEEL_IDLE;
+}
+
+void timer_wheel_pause(timer_wheel_t *w, timer_wheel_timer_t *t) {
+  if (t->state != TIMER_WHEEL_ARMED) {
+    return;
+  }
+  unlink(w, t);
+  uint64_t left = t->expires - w->now;
+  t->remaining = left > UINT32_MAX ? UINT32_MAX : (uint32_t)left;
+  t->state = TIMER_WHEEL_PAUSED;
+}
+
+void timer_wheel_resume(timer_wheel_t *w, timer_wheel_timer_t *t) {
+  if (t->state == TIMER_WHEEL_PAUSED) {
+    timer_wheel_start(w, t, t->remaining, t->period);
+  }
+}
+
+static uint64_t list_min(const timer_wheel_timer_t *t) {
+  uint64_t min = UINT64_MAX;
+  for (; t; t = t->next) {
+    min = t->expires < min ? t->expires : min;
+  }
+  return min;
+}
+
+/* Every level only holds deadlines later than the levels below it, and
+ * within a level the lowest occupied slot is the earliest */
+bool timer_wheel_next(const timer_wheel_t *w, uint64_t *deadline) {
+  for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+    if (!w->occupied[level]) {
+      continue;
+    }
+    uint32_t slot = __builtin_ctzll(w->occupied[level]);
+    if (level == 0) {
+      *deadline = (w->now & ~(uint64_t)SLOT_MASK) | slot;
+    } else {
+      *deadline = list_min(w->slots[level][slot]);
+    }
+    return true;
+  }
+  if (w->overflow) {
+    *deadline = list_min(w->overflow);
+    return true;
+  }
+  return false;
+}
+
+uint32_t timer_wheel_advance(timer_wheel_t *w, uint64_t now) {
+  uint32_t fired = 0;
+  if (now > w->now) {
+    w->stats.advances++;
+  }
+  uint64_t due;
+  while (timer_wheel_next(w, &due) && due <= now) {
+    set_now(w, due > w->now ? due : w->now);
+    // Everything due now sits in this level 0 slot; a callback may add more
+    timer_wheel_timer_t **head = &w->slots[0][due & SLOT_MASK];
+    timer_wheel_timer_t *t;
+    while ((t = *head) != NULL) {
+      unlink(w, t);
+      if (t->period) {
+        t->expires = due + t->period;
+        link(w, t);
+      } else {
+        t->state = TIMER_WHEEL_IDLE;
+      }
+      t->cb(t);
+      fired++;
+    }
+  }
+  if (now > w->now) {
+    set_now(w, now);
+  }
+  w->stats.fired += fired;
+  return fired;
+}
@@ -0,0 +1,109 @@
+#include "touch_cal.h"
+#include <stdlib.h>
+
+#define ONE (1 << 16)
+
+void touch_cal_identity(touch_cal_t *cal) {
+  *cal = (touch_cal_t){.a = ONE, .e = ONE};
+}
+
+// n / d rounded to nearest, d > 0
+static int64_t div_round(int64_t n, int64_t d) {
+  return n >= 0 ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+/* Cramer's rule on the differences to the third point, exact in 64 bits.
+ * The offsets are fitted at the centroid, so the rounding of the slopes
+ * spreads over the three targets instead of landing on two of them. */
+bool touch_cal_solve(const touch_cal_point_t raw[3],
+                     const touch_cal_point_t target[3], touch_cal_t *out) {
+  int64_t x0 = raw[0].x - raw[2].x, y0 = raw[0].y - raw[2].y;
+  int64_t x1 = raw[1].x - raw[2].x, y1 = raw[1].y - raw[2].y;
+  int64_t det = x0 * y1 - x1 * y0;
+  if (llabs(det) < TOUCH_CAL_MIN_DET) {
+    return false;
+  }
+  int64_t sign = det < 0 ? -1 : 1;
+  det *= sign;
+
+  int64_t u0 = target[0].x - target[2].x, u1 = target[1].x - target[2].x;
+  int64_t v0 = target[0].y - target[2].y, v1 = target[1].y - target[2].y;
+  int64_t a = div_round(sign * (u0 * y1 - u1 * y0) * ONE, det);
+  int64_t b = div_round(sign * (x0 * u1 - x1 * u0) * ONE, det);
+  int64_t d = div_round(sign * (v0 * y1 - v1 * y0) * ONE, det);
+  int64_t e = div_round(sign * (x0 * v1 - x1 * v0) * ONE, det);
+
+  int64_t sx = raw[0].x + raw[1].x + raw[2].x;
+  int64_t sy = raw[0].y + raw[1].y + raw[2].y;
+  int64_t su = target[0].x + target[1].x + target[2].x;
+  int64_t sv = target[0].y + target[1].y + target[2].y;
+  int64_t c = div_round(su * ONE - a * sx - b * sy, 3);
+  int64_t f = div_round(sv * ONE - d * sx - e * sy, 3);
+
+  if (llabs(a) > TOUCH_CAL_MAX_SCALE || llabs(b) > TOUCH_CAL_MAX_SCALE ||
+      llabs(d) > TOUCH_CAL_MAX_SCALE || llabs(e) > TOUCH_CAL_MAX_SCALE ||
+      llabs(c) > TOUCH_CAL_MAX_OFFSET || llabs(f) > TOUCH_CAL_MAX_OFFSET) {
+    return false;
+  }
+  *out = (touch_cal_t){(int32_t)a, (int32_t)b, (int32_t)c,
+                       (int32_t)d, (int32_t)e, (int32_t)f};
+  return true;
+}
+
+/* outer after inner. outer only holds 0 and +-ONE slopes here, so the
+ * products shift back exactly. */
+static void compose(const touch_cal_t *outer, const touch_cal_t *inner,
+                    touch_cal_t *out) {
+  const touch_cal_t o = *outer, i = *inner;
+  out->a = (int32_t)(((int64_t)o.a * i.a + (int64_t)o.b * i.d) >> 16);
+  out->b = (int32_t)(((int64_t)o.a * i.b + (int64_t)o.b * i.e) >> 16);
+  out->c = (int32_t)((((int64_t)o.a * i.c + (int64_t)o.b * i.f) >> 16) + o.c);
+  out->d = (int32_t)(((int64_t)o.d * i.a + (int64_t)o.e * i.d) >> 16);
+  out->e = (int32_t)(((int64_t)o.d * i.b + (int64_t)o.e * i.e) >> 16);
+  out->f = (int32_t)((((int64_t)o.d * i.c + (int64_t)o.e * i.f) >> 16) + o.f);
+}
+
+/* The point mapping of lv_indev for each rotation, from the unrotated
+ * frame: 180 mirrors both axes, 90 and 270 swap them and mirror one. */
+static touch_cal_t rotation_matrix(uint8_t rotation, int32_t hor_res,
+                                   int32_t ver_res) {
+  const int32_t w = (hor_res - 1) * ONE, h = (ver_res - 1) * ONE;
+  switch (rotation & 3) {
+  case 1: // 90
+    return (touch_cal_t){0, -ONE, h, ONE, 0, 0};
+  case 2: // 180
+    return (touch_cal_t){-ONE, 0, w, 0, -ONE, h};
+  case 3: // 270
+    return (touch_cal_t){0, ONE, 0, -ONE, 0, w};
+  default:
+    return (touch_cal_t){ONE, 0, 0, 0, ONE, 0};
+  }
+}
+
+// Inverses of the above, from the rotated frame back
+static touch_cal_t unrotation_matrix(uint8_t rotation, int32_t hor_res,
+                                     int32_t ver_res) {
+  const int32_t w = (hor_res - 1) * ONE, h = (ver_res - 1) * ONE;
+  switch (rotation & 3) {
+  case 1:
+    return (touch_cal_t){0, ONE, 0, -ONE, 0, h};
+  case 2:
+    return (touch_cal_t){-ONE, 0, w, 0, -ONE, h};
+  case 3:
+    return (touch_cal_t){0, -ONE, w, ONE, 0, 0};
+  default:
+    return (touch_cal_t){ONE, 0, 0, 0, ONE, 0};
+  }
+}
+
+void touch_cal_rotate(const touch_cal_t *cal, uint8_t rotation,
+                      int32_t hor_res, int32_t ver_res, touch_cal_t *out) {
+  const touch_cal_t r = rotation_matrix(rotation, hor_res, ver_res);
+  compose(&r, cal, out);
+}
+
+void touch_cal_unrotate(const touch_cal_t *cal, uint8_t rotation,
+                        int32_t hor_res, int32_t ver_res, touch_cal_t *out) {
+  const touch_cal_t r = unrotation_matrix(rotation, hor_res, ver_res);
+  compose(&r, cal, out);
+}
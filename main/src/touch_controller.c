@@ -1,32 +1,260 @@
 #include "touch_controller.h"
 #include "config.h"
+#include "dlog.h"
+#include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "indev/lv_indev.h"
+#include "lvgl_port.h"
+#include "nvs.h"
+#include "touch_cal.h"
+#include "touch_filter.h"
+#include "touch_ring.h"
+#include "trace.h"
+#include <stdatomic.h>
 
 static const char *TAG = "TOUCH_CONTROLLER";
 
+#define TOUCH_CAL_NAMESPACE "touch"
+#define TOUCH_CAL_KEY "cal_v1"
+
 #if CONFIG_EXAMPLE_LCD_TOUCH_ENABLED
+static TaskHandle_t s_touch_task;
+static touch_ring_t s_touch_ring;
+static touch_filter_t s_touch_filter;
+/* Panel coordinates to display pixels in the unrotated frame, lv_indev
+ * follows the display rotation itself. Double-buffered: the LVGL task fills
+ * the spare copy and swaps the pointer, the touch task picks it up at the
+ * next stroke. */
+static touch_cal_t s_cal[2];
+static _Atomic(const touch_cal_t *) s_active_cal = &s_cal[0];
+// Last filtered point, before the calibration, x | y << 16. The calibration
+// screen pairs it with the target that was touched.
+static _Atomic uint32_t s_last_raw;
+
+// PENIRQ went low: a stroke started
+static void example_touch_isr(esp_lcd_touch_handle_t tp) {
+  if (!s_touch_task) {
+    return; // still initializing
+  }
+  // PENIRQ also toggles while the XPT2046 converts, keep it masked until the
+  // sampling task has seen the release
+  gpio_intr_disable(EXAMPLE_PIN_NUM_TOUCH_IRQ);
+  BaseType_t high_task_wakeup = pdFALSE;
+  vTaskNotifyGiveFromISR(s_touch_task, &high_task_wakeup);
+  portYIELD_FROM_ISR(high_task_wakeup);
+}
+
+static uint16_t clamp_coord(int32_t v, int32_t res) {
+  return v < 0 ? 0 : v >= res ? res - 1 : v;
+}
+
+/* Owns all touch SPI traffic. Sleeps until PENIRQ, then samples at a fixed
+ * rate until release, pushing filtered, timestamped points for LVGL. */
+static void example_touch_task(void *arg) {
+  esp_lcd_touch_handle_t tp = arg;
+  touch_event_t ev = {0};
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    touch_filter_reset(&s_touch_filter);
+    const touch_cal_t *cal =
+        atomic_load_explicit(&s_active_cal, memory_order_acquire);
+
+    do {
+      uint16_t x[1];
+      uint16_t y[1];
+      uint8_t cnt = 0;
+      esp_lcd_touch_read_data(tp);
+      ev.time_us = esp_timer_get_time();
+      ev.pressed = esp_lcd_touch_get_coordinates(tp, x, y, NULL, &cnt, 1) &&
+                   cnt > 0;
+      trace_event(TRACE_TOUCH_SAMPLE, ev.pressed);
+      // A release keeps the last pressed point
+      if (ev.pressed) {
+        uint16_t fx, fy;
+        int32_t cx, cy;
+        touch_filter_push(&s_touch_filter, x[0], y[0], &fx, &fy);
+        atomic_store_explicit(&s_last_raw, fx | (uint32_t)fy << 16,
+                              memory_order_relaxed);
+        touch_cal_apply(cal, fx, fy, &cx, &cy);
+        ev.x = clamp_coord(cx, EXAMPLE_LCD_H_RES);
+        ev.y = clamp_coord(cy, EXAMPLE_LCD_V_RES);
+      }
+      if (!ev.pressed) {
+        // A lost sample only thins the path, but LVGL holds on to the last
+        // one it got: without the release it stays pressed until the next
+        // stroke. Wait for the LVGL task to make room.
+        while (touch_ring_full(&s_touch_ring)) {
+          lvgl_port_wake();
+          vTaskDelay(1);
+        }
+      }
+      if (!touch_ring_push(&s_touch_ring, &ev)) {
+        DLOGD(TAG, "touch ring full");
+      }
+      lvgl_port_wake();
+      if (ev.pressed) {
+        vTaskDelay(pdMS_TO_TICKS(TOUCH_SAMPLE_PERIOD_MS));
+      }
+    } while (ev.pressed);
+
+    gpio_intr_enable(EXAMPLE_PIN_NUM_TOUCH_IRQ);
+  }
+}
+
+// Runs in the LVGL task, never touches the bus. Hands LVGL every queued
+// sample so fast swipes keep their full path.
 static void example_lvgl_touch_cb(lv_indev_t *indev, lv_indev_data_t *data) {
-  uint16_t touchpad_x[1] = {0};
-  uint16_t touchpad_y[1] = {0};
-  uint8_t touchpad_cnt = 0;
-
-  esp_lcd_touch_handle_t touch_pad = lv_indev_get_user_data(indev);
-  esp_lcd_touch_read_data(touch_pad);
-  /* Get coordinates */
-  bool touchpad_pressed = esp_lcd_touch_get_coordinates(
-      touch_pad, touchpad_x, touchpad_y, NULL, &touchpad_cnt, 1);
-
-  if (touchpad_pressed && touchpad_cnt > 0) {
-    data->point.x = touchpad_x[0];
-    data->point.y = touchpad_y[0];
-    data->state = LV_INDEV_STATE_PRESSED;
-  } else {
-    data->state = LV_INDEV_STATE_RELEASED;
+  static touch_event_t last;
+  if (touch_ring_pop(&s_touch_ring, &last)) {
+    trace_event(TRACE_INPUT_DISPATCH, last.pressed);
+  }
+  data->point.x = last.x;
+  data->point.y = last.y;
+  data->state =
+      last.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+  data->continue_reading = !touch_ring_empty(&s_touch_ring);
+}
+
+static bool calibration_load(touch_cal_t *out) {
+  nvs_handle_t nvs;
+  if (nvs_open(TOUCH_CAL_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+    return false; // never calibrated
+  }
+  size_t len = sizeof(*out);
+  esp_err_t err = nvs_get_blob(nvs, TOUCH_CAL_KEY, out, &len);
+  nvs_close(nvs);
+  return err == ESP_OK && len == sizeof(*out);
+}
+
+// NULL erases the stored calibration
+static void calibration_store(const touch_cal_t *cal) {
+  nvs_handle_t nvs;
+  esp_err_t err = nvs_open(TOUCH_CAL_NAMESPACE, NVS_READWRITE, &nvs);
+  if (err == ESP_OK) {
+    err = cal ? nvs_set_blob(nvs, TOUCH_CAL_KEY, cal, sizeof(*cal))
+              : nvs_erase_key(nvs, TOUCH_CAL_KEY);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+      err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to store touch calibration: %s",
+             esp_err_to_name(err));
+  }
+}
+
+// Hand the touch task a new calibration through the spare copy
+static void calibration_use(const touch_cal_t *cal) {
+  const touch_cal_t *active =
+      atomic_load_explicit(&s_active_cal, memory_order_relaxed);
+  touch_cal_t *spare = active == &s_cal[0] ? &s_cal[1] : &s_cal[0];
+  *spare = *cal;
+  atomic_store_explicit(&s_active_cal, spare, memory_order_release);
+}
+
+#define CAL_TARGETS 3
+#define CAL_TARGET_SIZE 11
+
+static struct {
+  lv_display_t *display;
+  lv_obj_t *overlay; // NULL when no calibration runs
+  lv_obj_t *target;
+  uint8_t next;
+  touch_cal_point_t raw[CAL_TARGETS];
+  touch_cal_point_t pos[CAL_TARGETS];
+} s_cal_run;
+
+static void calibration_show_target(void) {
+  const touch_cal_point_t *p = &s_cal_run.pos[s_cal_run.next];
+  lv_obj_set_pos(s_cal_run.target, p->x - CAL_TARGET_SIZE / 2,
+                 p->y - CAL_TARGET_SIZE / 2);
+}
+
+// A touch on the overlay ended: the last point before it was on the target
+static void calibration_released_cb(lv_event_t *e) {
+  (void)e;
+  uint32_t raw = atomic_load_explicit(&s_last_raw, memory_order_relaxed);
+  s_cal_run.raw[s_cal_run.next] =
+      (touch_cal_point_t){raw & 0xffff, raw >> 16};
+  if (++s_cal_run.next < CAL_TARGETS) {
+    calibration_show_target();
+    return;
   }
+  lv_obj_delete_async(s_cal_run.overlay);
+  s_cal_run.overlay = NULL;
+
+  // The targets were placed in the rotated frame, the touch task works in
+  // the unrotated one
+  touch_cal_t cal;
+  if (!touch_cal_solve(s_cal_run.raw, s_cal_run.pos, &cal)) {
+    ESP_LOGW(TAG, "Calibration touches too close together, not used");
+    return;
+  }
+  touch_cal_unrotate(&cal, lv_display_get_rotation(s_cal_run.display),
+                     EXAMPLE_LCD_H_RES, EXAMPLE_LCD_V_RES, &cal);
+  calibration_use(&cal);
+  calibration_store(&cal);
+  ESP_LOGI(TAG, "Touch calibrated: %ld %ld %ld / %ld %ld %ld (Q16)",
+           (long)cal.a, (long)cal.b, (long)cal.c, (long)cal.d, (long)cal.e,
+           (long)cal.f);
 }
 #endif
 
+void touch_controller_calibrate(void *arg) {
+  (void)arg;
+#if CONFIG_EXAMPLE_LCD_TOUCH_ENABLED
+  if (s_cal_run.overlay || !s_cal_run.display) {
+    return;
+  }
+  // Spread out, but in from the edges where resistive panels read worst
+  int32_t w = lv_display_get_horizontal_resolution(s_cal_run.display);
+  int32_t h = lv_display_get_vertical_resolution(s_cal_run.display);
+  s_cal_run.pos[0] = (touch_cal_point_t){w / 8, h / 8};
+  s_cal_run.pos[1] = (touch_cal_point_t){w * 7 / 8, h / 2};
+  s_cal_run.pos[2] = (touch_cal_point_t){w / 2, h * 7 / 8};
+  s_cal_run.next = 0;
+
+  lv_obj_t *overlay = lv_obj_create(lv_layer_top());
+  lv_obj_remove_style_all(overlay);
+  lv_obj_set_size(overlay, w, h);
+  lv_obj_set_style_bg_color(overlay, lv_color_black(), 0);
+  lv_obj_set_style_bg_opa(overlay, LV_OPA_COVER, 0);
+  lv_obj_remove_flag(overlay, LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_add_flag(overlay, LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_add_event_cb(overlay, calibration_released_cb, LV_EVENT_RELEASED,
+                      NULL);
+
+  lv_obj_t *hint = lv_label_create(overlay);
+  lv_label_set_text(hint, "Tap the dots");
+  lv_obj_set_style_text_color(hint, lv_color_white(), 0);
+  lv_obj_center(hint);
+
+  s_cal_run.target = lv_obj_create(overlay);
+  lv_obj_remove_style_all(s_cal_run.target);
+  lv_obj_set_size(s_cal_run.target, CAL_TARGET_SIZE, CAL_TARGET_SIZE);
+  lv_obj_set_style_radius(s_cal_run.target, LV_RADIUS_CIRCLE, 0);
+  lv_obj_set_style_bg_color(s_cal_run.target, lv_color_white(), 0);
+  lv_obj_set_style_bg_opa(s_cal_run.target, LV_OPA_COVER, 0);
+  lv_obj_remove_flag(s_cal_run.target, LV_OBJ_FLAG_CLICKABLE);
+  s_cal_run.overlay = overlay;
+  calibration_show_target();
+#endif
+}
+
+void touch_controller_reset_calibration(void *arg) {
+  (void)arg;
+#if CONFIG_EXAMPLE_LCD_TOUCH_ENABLED
+  touch_cal_t cal;
+  touch_cal_identity(&cal);
+  calibration_use(&cal);
+  calibration_store(NULL);
+#endif
+}
+
 void touch_controller_init(lv_display_t *display) {
 #if CONFIG_EXAMPLE_LCD_TOUCH_ENABLED
   esp_lcd_panel_io_handle_t tp_io_handle = NULL;
@@ -40,17 +268,28 @@ void touch_controller_init(lv_display_t *display) {
   ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)LCD_HOST,
                                            &tp_io_config, &tp_io_handle));
 
+  touch_ring_init(&s_touch_ring);
+  touch_filter_init(&s_touch_filter, TOUCH_FILTER_ALPHA_Q8);
+  s_cal_run.display = display;
+  if (calibration_load(&s_cal[0])) {
+    ESP_LOGI(TAG, "Using stored touch calibration");
+  } else {
+    touch_cal_identity(&s_cal[0]);
+  }
+
   esp_lcd_touch_config_t tp_cfg = {
       .x_max = EXAMPLE_LCD_H_RES,
       .y_max = EXAMPLE_LCD_V_RES,
       .rst_gpio_num = -1,
-      .int_gpio_num = -1,
+      .int_gpio_num = EXAMPLE_PIN_NUM_TOUCH_IRQ,
       .flags =
           {
               .swap_xy = 0,
               .mirror_x = 0,
               .mirror_y = CONFIG_EXAMPLE_LCD_MIRROR_Y,
           },
+      // The driver sets PENIRQ up for a falling edge and hooks this in
+      .interrupt_callback = example_touch_isr,
   };
   esp_lcd_touch_handle_t tp = NULL;
 
@@ -61,12 +300,14 @@ void touch_controller_init(lv_display_t *display) {
   ESP_LOGI(TAG, "Initialize touch controller XPT2046");
   ESP_ERROR_CHECK(esp_lcd_touch_new_spi_xpt2046(tp_io_handle, &tp_cfg, &tp));
 #endif
+  xTaskCreate(example_touch_task, "TOUCH", TOUCH_TASK_STACK_SIZE, tp,
+              TOUCH_TASK_PRIORITY, &s_touch_task);
 
   static lv_indev_t *indev;
   indev = lv_indev_create(); // Input device driver (Touch)
   lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
   lv_indev_set_display(indev, display);
-  lv_indev_set_user_data(indev, tp);
   lv_indev_set_read_cb(indev, example_lvgl_touch_cb);
+  lvgl_port_add_indev(indev);
 #endif
 }
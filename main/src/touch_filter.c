@@ -0,0 +1,61 @@
+#include "touch_filter.h"
+#include <string.h>
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c) {
+  if (a > b) {
+    uint16_t t = a;
+    a = b;
+    b = t;
+  }
+  if (b > c) {
+    b = c;
+  }
+  return a > b ? a : b;
+}
+
+// Median of what the window holds; the first samples of a stroke have fewer
+// than three to pick from
+static uint16_t window_median(const uint16_t *v, uint8_t count) {
+  switch (count) {
+  case 1:
+    return v[0];
+  case 2:
+    return (v[0] + v[1] + 1) / 2;
+  default:
+    return median3(v[0], v[1], v[2]);
+  }
+}
+
+void touch_filter_init(touch_filter_t *f, uint8_t alpha_q8) {
+  memset(f, 0, sizeof(*f));
+  f->alpha = alpha_q8;
+}
+
+void touch_filter_reset(touch_filter_t *f) {
+  f->count = 0;
+  f->next = 0;
+}
+
+void touch_filter_push(touch_filter_t *f, uint16_t x, uint16_t y,
+                       uint16_t *out_x, uint16_t *out_y) {
+  f->x[f->next] = x;
+  f->y[f->next] = y;
+  f->next = (f->next + 1) % TOUCH_FILTER_MEDIAN_LEN;
+  if (f->count < TOUCH_FILTER_MEDIAN_LEN) {
+    f->count++;
+  }
+
+  int32_t mx = (int32_t)window_median(f->x, f->count) << 8;
+  int32_t my = (int32_t)window_median(f->y, f->count) << 8;
+  if (f->count == 1 || f->alpha == 0) {
+    // First sample of the stroke seeds the IIR, no lag towards the old point.
+    // Alpha 0 stands for a full weight, which Q8 in 8 bits cannot hold.
+    f->iir_x = mx;
+    f->iir_y = my;
+  } else {
+    f->iir_x += ((mx - f->iir_x) * f->alpha) >> 8;
+    f->iir_y += ((my - f->iir_y) * f->alpha) >> 8;
+  }
+  *out_x = (uint16_t)((f->iir_x + 128) >> 8);
+  *out_y = (uint16_t)((f->iir_y + 128) >> 8);
+}
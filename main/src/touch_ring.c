@@ -0,0 +1,50 @@
+#include "touch_ring.h"
+
+_Static_assert((TOUCH_RING_LEN & (TOUCH_RING_LEN - 1)) == 0,
+               "TOUCH_RING_LEN must be a power of two");
+
+void touch_ring_init(touch_ring_t *r) {
+  atomic_init(&r->head, 0);
+  atomic_init(&r->tail, 0);
+  atomic_init(&r->dropped, 0);
+}
+
+bool touch_ring_push(touch_ring_t *r, const touch_event_t *ev) {
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+  if (head - tail == TOUCH_RING_LEN) {
+    atomic_fetch_add_explicit(&r->dropped, 1, memory_order_relaxed);
+    return false;
+  }
+  r->events[head % TOUCH_RING_LEN] = *ev;
+  // Publish the event before the consumer can see the new head
+  atomic_store_explicit(&r->head, head + 1, memory_order_release);
+  return true;
+}
+
+bool touch_ring_pop(touch_ring_t *r, touch_event_t *ev) {
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+  if (head == tail) {
+    return false;
+  }
+  *ev = r->events[tail % TOUCH_RING_LEN];
+  // Hand the slot back only after it has been copied out
+  atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+bool touch_ring_empty(touch_ring_t *r) {
+  return atomic_load_explicit(&r->head, memory_order_acquire) ==
+         atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
+
+bool touch_ring_full(touch_ring_t *r) {
+  return atomic_load_explicit(&r->head, memory_order_relaxed) -
+             atomic_load_explicit(&r->tail, memory_order_acquire) ==
+         TOUCH_RING_LEN;
+}
+
+uint32_t touch_ring_dropped(touch_ring_t *r) {
+  return atomic_load_explicit(&r->dropped, memory_order_relaxed);
+}
@@ -0,0 +1,91 @@
+#include "trace.h"
+#include "config.h"
+#include "esp_timer.h"
+#include <stdatomic.h>
+#include <string.h>
+
+_Static_assert((TRACE_RING_LEN & (TRACE_RING_LEN - 1)) == 0,
+               "TRACE_RING_LEN must be a power of two");
+_Static_assert(sizeof(trace_record_t) == 8, "trace records are dumped as-is");
+
+static trace_record_t s_ring[TRACE_RING_LEN];
+static _Atomic uint32_t s_head; // next event index, never wraps in practice
+static uint32_t s_cursor;       // next event trace_collect() looks at
+static trace_correlator_t s_correlator;
+static trace_summary_t s_summary;
+
+// Non-zero tag of the ring pass event idx belongs to
+static uint8_t trace_lap(uint32_t idx) {
+  return (uint8_t)((idx / TRACE_RING_LEN) % 255 + 1);
+}
+
+void trace_event(trace_event_id_t id, uint16_t arg) {
+  uint32_t idx = atomic_fetch_add_explicit(&s_head, 1, memory_order_relaxed);
+  trace_record_t *slot = &s_ring[idx % TRACE_RING_LEN];
+  // Readers skip the slot while lap does not match, publish it last
+  __atomic_store_n(&slot->lap, 0, __ATOMIC_RELAXED);
+  slot->time_us = (uint32_t)esp_timer_get_time();
+  slot->arg = arg;
+  slot->id = id;
+  __atomic_store_n(&slot->lap, trace_lap(idx), __ATOMIC_RELEASE);
+}
+
+// False when the event at idx is not written yet or was overwritten meanwhile
+static bool trace_read(uint32_t idx, trace_record_t *out) {
+  const trace_record_t *slot = &s_ring[idx % TRACE_RING_LEN];
+  uint8_t lap = trace_lap(idx);
+  if (__atomic_load_n(&slot->lap, __ATOMIC_ACQUIRE) != lap) {
+    return false;
+  }
+  out->time_us = slot->time_us;
+  out->arg = slot->arg;
+  out->id = slot->id;
+  out->lap = lap;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&slot->lap, __ATOMIC_RELAXED) == lap;
+}
+
+void trace_collect(void) {
+  uint32_t head = atomic_load_explicit(&s_head, memory_order_acquire);
+  if (head - s_cursor > TRACE_RING_LEN) {
+    s_summary.lost += head - s_cursor - TRACE_RING_LEN;
+    s_cursor = head - TRACE_RING_LEN;
+  }
+  for (; s_cursor != head; s_cursor++) {
+    trace_record_t rec;
+    if (!trace_read(s_cursor, &rec)) {
+      break; // still being written, pick it up next time
+    }
+    trace_interaction_t it;
+    if (trace_correlator_feed(&s_correlator, &rec, &it)) {
+      for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        trace_hist_add(&s_summary.stages[s], it.stage_us[s]);
+      }
+      if (it.stage_us[TRACE_STAGE_TOTAL] > TOUCH_LATENCY_BUDGET_MS * 1000) {
+        s_summary.over_budget++;
+      }
+    }
+  }
+}
+
+const trace_summary_t *trace_get_summary(void) { return &s_summary; }
+
+void trace_reset_summary(void) {
+  memset(&s_summary, 0, sizeof(s_summary));
+  trace_correlator_init(&s_correlator);
+}
+
+size_t trace_snapshot(trace_record_t *out, size_t max) {
+  uint32_t head = atomic_load_explicit(&s_head, memory_order_acquire);
+  uint32_t avail = head < TRACE_RING_LEN ? head : TRACE_RING_LEN;
+  if (max > avail) {
+    max = avail;
+  }
+  size_t n = 0;
+  for (uint32_t idx = head - max; idx != head; idx++) {
+    if (trace_read(idx, &out[n])) {
+      n++;
+    }
+  }
+  return n;
+}
@@ -0,0 +1,123 @@
+#include "trace_stats.h"
+#include <string.h>
+
+enum {
+  PHASE_IDLE,
+  PHASE_TOUCHED,      // sample taken, LVGL has not read it yet
+  PHASE_DISPATCHED,   // LVGL read it, waiting for the refresh it causes
+  PHASE_RENDERING,    // refresh running
+  PHASE_TRANSFERRING, // rendered, strips still going out
+};
+
+const char *const trace_stage_names[TRACE_STAGE_COUNT] = {
+    "input", "queue", "render", "transfer", "total"};
+
+void trace_correlator_init(trace_correlator_t *c) { memset(c, 0, sizeof(*c)); }
+
+static void correlator_finish(trace_correlator_t *c, uint32_t photon_us,
+                              trace_interaction_t *out) {
+  // t[] holds the start of each stage, each ends where the next one starts
+  out->touch_us = c->t[TRACE_STAGE_INPUT];
+  out->stage_us[TRACE_STAGE_INPUT] =
+      c->t[TRACE_STAGE_QUEUE] - c->t[TRACE_STAGE_INPUT];
+  out->stage_us[TRACE_STAGE_QUEUE] =
+      c->t[TRACE_STAGE_RENDER] - c->t[TRACE_STAGE_QUEUE];
+  out->stage_us[TRACE_STAGE_RENDER] =
+      c->t[TRACE_STAGE_TRANSFER] - c->t[TRACE_STAGE_RENDER];
+  out->stage_us[TRACE_STAGE_TRANSFER] = photon_us - c->t[TRACE_STAGE_TRANSFER];
+  out->stage_us[TRACE_STAGE_TOTAL] = photon_us - c->t[TRACE_STAGE_INPUT];
+  c->phase = PHASE_IDLE;
+}
+
+bool trace_correlator_feed(trace_correlator_t *c, const trace_record_t *rec,
+                           trace_interaction_t *out) {
+  switch (rec->id) {
+  case TRACE_TOUCH_SAMPLE:
+    // A sample LVGL read without redrawing anything caused no frame: follow
+    // the newer one instead of charging it the wait for an unrelated refresh
+    if (c->phase == PHASE_IDLE || c->phase == PHASE_DISPATCHED) {
+      c->t[TRACE_STAGE_INPUT] = rec->time_us;
+      c->phase = PHASE_TOUCHED;
+    }
+    break;
+  case TRACE_INPUT_DISPATCH:
+    if (c->phase == PHASE_TOUCHED) {
+      c->t[TRACE_STAGE_QUEUE] = rec->time_us;
+      c->phase = PHASE_DISPATCHED;
+    }
+    break;
+  case TRACE_RENDER_START:
+    if (c->phase == PHASE_DISPATCHED) {
+      c->t[TRACE_STAGE_RENDER] = rec->time_us;
+      c->phase = PHASE_RENDERING;
+    }
+    break;
+  case TRACE_RENDER_END:
+    if (c->phase == PHASE_RENDERING) {
+      c->t[TRACE_STAGE_TRANSFER] = rec->time_us;
+      c->phase = PHASE_TRANSFERRING;
+      if (rec->arg == 0) {
+        // Every strip was already on the panel
+        correlator_finish(c, rec->time_us, out);
+        return true;
+      }
+    }
+    break;
+  case TRACE_FLUSH_DONE:
+    if (c->phase == PHASE_TRANSFERRING && rec->arg == 0) {
+      correlator_finish(c, rec->time_us, out);
+      return true;
+    }
+    break;
+  default:
+    break;
+  }
+  return false;
+}
+
+static uint32_t hist_bucket(uint32_t us) {
+  if (us < 8) {
+    return us;
+  }
+  uint32_t msb = 31 - __builtin_clz(us);
+  uint32_t idx = (msb - 2) * 8 + ((us >> (msb - 3)) & 7);
+  return idx < TRACE_HIST_BUCKETS ? idx : TRACE_HIST_BUCKETS - 1;
+}
+
+// Largest value that still lands in bucket idx
+static uint32_t hist_bucket_max(uint32_t idx) {
+  if (idx < 8) {
+    return idx;
+  }
+  uint32_t msb = idx / 8 + 2;
+  return ((8 + idx % 8 + 1) << (msb - 3)) - 1;
+}
+
+void trace_hist_add(trace_hist_t *h, uint32_t us) {
+  h->buckets[hist_bucket(us)]++;
+  h->count++;
+  h->sum_us += us;
+  if (us > h->max_us) {
+    h->max_us = us;
+  }
+}
+
+uint32_t trace_hist_percentile(const trace_hist_t *h, uint32_t percent) {
+  if (h->count == 0) {
+    return 0;
+  }
+  // Rank of the sample at that percentile, 1-based and rounded up
+  uint64_t rank = ((uint64_t)h->count * percent + 99) / 100;
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < TRACE_HIST_BUCKETS; i++) {
+    seen += h->buckets[i];
+    if (seen >= rank) {
+      uint32_t bound = hist_bucket_max(i);
+      return bound < h->max_us ? bound : h->max_us;
+    }
+  }
+  return h->max_us;
+}
@@ -1,59 +1,96 @@
 #include "ui.h"
-#include <stdio.h>
+#include "clock_widget.h"
+#include "config.h"
+#include "notif_list.h"
+#include "notif_store.h"
+#include "screen_mgr.h"
+
+#define UI_BG_COLOR 0x003a57
 
 static uint8_t hours = 0;
 static uint8_t minutes = 0;
 static uint8_t seconds = 0;
-static lv_obj_t *time_label = NULL; // Keep reference to the label
+static clock_widget_t clock_widget;
+static bool clock_created = false;
 
-void lv_screen(lv_disp_t *disp) {
-  lv_obj_t *active_scr = lv_display_get_screen_active(disp);
-  lv_obj_set_style_bg_color(active_scr, lv_color_hex(0x003a57), LV_PART_MAIN);
+static void clock_delete_cb(lv_event_t *e) {
+  (void)e;
+  clock_created = false;
+}
 
-  // Create label only once and store reference
-  time_label = lv_label_create(active_scr);
+// The time lives in this file, so an evicted clock comes back current
+static void clock_screen_create(lv_obj_t *scr) {
+  lv_obj_set_style_bg_color(scr, lv_color_hex(UI_BG_COLOR), LV_PART_MAIN);
 
-  lv_obj_set_style_text_color(time_label, lv_color_hex(0xffffff), LV_PART_MAIN);
-  lv_obj_align(time_label, LV_ALIGN_CENTER, 0, 0);
+  // Create the clock only once per screen; its digit cells are redrawn
+  // individually
+  clock_widget_init(&clock_widget, scr, LV_FONT_DEFAULT,
+                    lv_color_hex(0xffffff), lv_color_hex(UI_BG_COLOR));
+  lv_obj_align(clock_widget.obj, LV_ALIGN_CENTER, 0, 0);
+  lv_obj_add_event_cb(clock_widget.obj, clock_delete_cb, LV_EVENT_DELETE,
+                      NULL);
+  clock_created = true;
 
   // Set initial time display
   update_time_display();
 }
 
-void update_time_display() {
-  if (time_label != NULL) {
-	static char time_str[15]; // "HH:MM:SS" + null terminator
-	sprintf(time_str, "%02d:%02d:%02d", hours, minutes, seconds);
-	lv_label_set_text(time_label, time_str);
-  }
+static notif_list_t notif_list;
+static bool notif_list_created = false;
+
+static void notif_list_delete_cb(lv_event_t *e) {
+  (void)e;
+  notif_list_created = false;
 }
 
-void increment_time() {
-  seconds++;
+// The notifications live in the store, the list only shows a window of them
+static void notif_screen_create(lv_obj_t *scr) {
+  notif_list_init(&notif_list, scr, notif_store_ring());
+  lv_obj_add_event_cb(notif_list.obj, notif_list_delete_cb, LV_EVENT_DELETE,
+                      NULL);
+  notif_list_created = true;
+}
 
-  // Handle rollover
-  if (seconds >= 60) {
-	seconds = 0;
-	minutes++;
-	
-	if (minutes >= 60) {
-	  minutes = 0;
-	  hours++;
+// Swipe order, left to right
+static const screen_def_t ui_screens[] = {
+    {"clock", clock_screen_create, .ticks = true},
+    {"demo", example_lvgl_demo_ui_create, .ticks = true}, // animates
+    {"notifications", notif_screen_create},
+};
 
-	  if (hours >= 24) {
-		hours = 0;
-	  }
-	}
-  }
+void lv_screen(lv_disp_t *disp) {
+  screen_mgr_init(disp, ui_screens, sizeof(ui_screens) / sizeof(ui_screens[0]),
+                  SCREEN_LVGL_HEAP_BUDGET);
+  screen_mgr_show(0);
+}
 
-  // Update the display
-  update_time_display();
+void update_time_display() {
+  if (clock_created) {
+    // Only the cells whose digit changed get invalidated
+    clock_widget_set_time(&clock_widget, hours, minutes, seconds);
+  }
 }
 
-// Optional: Function to set initial time
+// LVGL task only, called by the clock's time_svc subscriber
 void set_time(uint8_t h, uint8_t m, uint8_t s) {
   hours = h;
   minutes = m;
   seconds = s;
   update_time_display();
 }
+
+// LVGL task only
+bool ui_add_notification(const notif_t *n) {
+  notif_ring_t *ring = notif_store_ring();
+  if (!ring || !notif_ring_append(ring, n)) {
+    return false;
+  }
+  if (notif_list_created) {
+    notif_list_refresh(&notif_list);
+  }
+  return true;
+}
+
+notif_list_t *ui_notif_list(void) {
+  return notif_list_created ? &notif_list : NULL;
+}
@@ -0,0 +1,107 @@
+#include "ui_cmd.h"
+#include "lvgl_port.h"
+#include <stdatomic.h>
+
+_Static_assert((UI_CMD_QUEUE_LEN & (UI_CMD_QUEUE_LEN - 1)) == 0,
+               "UI_CMD_QUEUE_LEN must be a power of two");
+
+/* Bounded multi-producer queue, one consumer. Each slot's seq says whose turn
+ * it is: pos when free for the producer claiming pos, pos + 1 once filled
+ * for the consumer. Producers claim slots with a CAS and never wait on each
+ * other or on the consumer. */
+typedef struct {
+  _Atomic uint32_t seq;
+  ui_cmd_t cmd;
+} ui_cmd_slot_t;
+
+static ui_cmd_slot_t s_slots[UI_CMD_QUEUE_LEN];
+static _Atomic uint32_t s_enqueue_pos;
+static uint32_t s_dequeue_pos; // consumer only
+
+static _Atomic uint32_t s_posted;
+static _Atomic uint32_t s_dropped;
+static uint32_t s_applied;
+
+// seq is stored relative to the slot index so that the zeroed statics
+// already describe an empty queue: slot i starts free for position i
+static uint32_t slot_seq(uint32_t idx, memory_order order) {
+  return atomic_load_explicit(&s_slots[idx].seq, order) + idx;
+}
+
+static void slot_set_seq(uint32_t idx, uint32_t seq) {
+  atomic_store_explicit(&s_slots[idx].seq, seq - idx, memory_order_release);
+}
+
+bool ui_cmd_post(const ui_cmd_t *cmd) {
+  uint32_t pos = atomic_load_explicit(&s_enqueue_pos, memory_order_relaxed);
+  uint32_t idx;
+  while (1) {
+    idx = pos % UI_CMD_QUEUE_LEN;
+    uint32_t seq = slot_seq(idx, memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&s_enqueue_pos, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The consumer has not freed this slot from the previous lap yet
+      atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+      return false;
+    } else {
+      // Another producer took pos, retry at the current end
+      pos = atomic_load_explicit(&s_enqueue_pos, memory_order_relaxed);
+    }
+  }
+  s_slots[idx].cmd = *cmd;
+  slot_set_seq(idx, pos + 1);
+  atomic_fetch_add_explicit(&s_posted, 1, memory_order_relaxed);
+  lvgl_port_wake();
+  return true;
+}
+
+bool ui_cmd_post_call(void (*fn)(void *arg), void *arg) {
+  ui_cmd_t cmd = {.type = UI_CMD_CALL, .call = {.fn = fn, .arg = arg}};
+  return ui_cmd_post(&cmd);
+}
+
+static bool ui_cmd_take(ui_cmd_t *out) {
+  uint32_t idx = s_dequeue_pos % UI_CMD_QUEUE_LEN;
+  if (slot_seq(idx, memory_order_acquire) != s_dequeue_pos + 1) {
+    return false; // empty, or the producer is still filling it
+  }
+  *out = s_slots[idx].cmd;
+  // Free the slot for the producer one lap ahead
+  slot_set_seq(idx, s_dequeue_pos + UI_CMD_QUEUE_LEN);
+  s_dequeue_pos++;
+  return true;
+}
+
+static void ui_cmd_apply(const ui_cmd_t *cmd) {
+  switch (cmd->type) {
+  case UI_CMD_CALL:
+    cmd->call.fn(cmd->call.arg);
+    break;
+  default:
+    break;
+  }
+}
+
+uint32_t ui_cmd_dispatch(void) {
+  // At most one queue's worth, so producers cannot keep the LVGL task here
+  ui_cmd_t cmd;
+  uint32_t applied = 0;
+  while (applied < UI_CMD_QUEUE_LEN && ui_cmd_take(&cmd)) {
+    ui_cmd_apply(&cmd);
+    applied++;
+  }
+  s_applied += applied;
+  return applied;
+}
+
+void ui_cmd_get_stats(ui_cmd_stats_t *out) {
+  out->posted = atomic_load_explicit(&s_posted, memory_order_relaxed);
+  out->dropped = atomic_load_explicit(&s_dropped, memory_order_relaxed);
+  out->applied = s_applied;
+}
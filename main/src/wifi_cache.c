@@ -0,0 +1,66 @@
+#include "wifi_cache.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#include <string.h>
+
+static const char *TAG = "WIFI_CACHE";
+
+#define WIFI_CACHE_NAMESPACE "wifi_cache"
+#define WIFI_CACHE_KEY "ap_v2" // v1 had no lease end
+
+static uint32_t ssid_crc(const char *ssid) {
+  return esp_rom_crc32_le(0, (const uint8_t *)ssid, strlen(ssid));
+}
+
+static bool wifi_cache_read(wifi_cache_t *out) {
+  nvs_handle_t nvs;
+  if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+    return false; // never written
+  }
+  size_t len = sizeof(*out);
+  esp_err_t err = nvs_get_blob(nvs, WIFI_CACHE_KEY, out, &len);
+  nvs_close(nvs);
+  return err == ESP_OK && len == sizeof(*out);
+}
+
+bool wifi_cache_load(const char *ssid, wifi_cache_t *out) {
+  if (!wifi_cache_read(out)) {
+    return false;
+  }
+  if (out->ssid_crc != ssid_crc(ssid)) {
+    ESP_LOGI(TAG, "Cached AP is for another SSID, ignoring it");
+    return false;
+  }
+  return true;
+}
+
+void wifi_cache_save(const char *ssid, wifi_cache_t *entry) {
+  entry->ssid_crc = ssid_crc(ssid);
+  entry->reserved = 0;
+  wifi_cache_t stored;
+  if (wifi_cache_read(&stored) && !memcmp(&stored, entry, sizeof(stored))) {
+    return; // spare the flash
+  }
+  nvs_handle_t nvs;
+  esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &nvs);
+  if (err == ESP_OK) {
+    err = nvs_set_blob(nvs, WIFI_CACHE_KEY, entry, sizeof(*entry));
+    if (err == ESP_OK) {
+      err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to store AP cache: %s", esp_err_to_name(err));
+  }
+}
+
+void wifi_cache_erase(void) {
+  nvs_handle_t nvs;
+  if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+    nvs_erase_key(nvs, WIFI_CACHE_KEY);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+  }
+}